@@ -71,7 +71,8 @@ CommMessageOut *WFHttpServerTask::message_out() {
     header.name = "Content-Length";
     header.name_len = strlen("Content-Length");
     header.value = buf;
-    header.value_len = sprintf(buf, "%zu", resp->get_output_body_size());
+    header.value_len =
+        StringUtil::format_uint64(resp->get_output_body_size(), buf);
     resp->add_header(&header);
   }
 
@@ -138,5 +139,8 @@ CommMessageOut *WFHttpServerTask::message_out() {
     resp->add_header(&header);
   }
 
+  if (this->reply_hook_)
+    return this->reply_hook_->message_out(resp, this->keep_alive_timeo != 0);
+
   return this->WFServerTask::message_out();
 }
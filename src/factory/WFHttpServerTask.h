@@ -41,7 +41,23 @@ private:
 public:
   WFHttpServerTask(CommService *service, std::function<void(TASK *)> &proc)
       : WFServerTask(service, WFGlobal::get_scheduler(), proc),
-        req_is_alive_(false), req_has_keep_alive_header_(false) {}
+        req_is_alive_(false), req_has_keep_alive_header_(false),
+        reply_hook_(NULL) {}
+
+public:
+  //*在响应头补全之后调用,可以替换真正发送的消息,例如响应缓存
+  class ReplyHook {
+  public:
+    virtual CommMessageOut *message_out(protocol::HttpResponse *resp,
+                                        bool keep_alive) = 0;
+    virtual ~ReplyHook() {}
+  };
+
+  //*hook随任务一起释放
+  void set_reply_hook(ReplyHook *hook) {
+    delete this->reply_hook_;
+    this->reply_hook_ = hook;
+  }
 
 protected:
   virtual void handle(int state, int error);
@@ -51,6 +67,10 @@ protected:
   bool req_is_alive_;
   bool req_has_keep_alive_header_;
   std::string req_keep_alive_;
+  ReplyHook *reply_hook_;
+
+protected:
+  virtual ~WFHttpServerTask() { delete this->reply_hook_; }
 };
 
 #endif
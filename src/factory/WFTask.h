@@ -12,6 +12,7 @@
 #include "../kernel/SleepRequest.h"
 #include "WFConnection.h"
 #include "Workflow.h"
+#include <algorithm>
 #include <assert.h>
 #include <atomic>
 #include <errno.h>
@@ -19,6 +20,7 @@
 #include <string.h>
 #include <utility>
 #include <iostream>
+#include <mutex>
 using namespace std;
 enum {
   WFT_STATE_UNDEFINED = -1,                 //*未定义
@@ -200,6 +202,396 @@ protected:
   virtual ~WFTimerTask() {}
 };
 
+//*文件io任务,通过IOService异步完成
+template <class ARGS> class WFFileTask : public IORequest {
+public:
+  void start() {
+    assert(!series_of(this));
+    Workflow::start_series_work(this, nullptr);
+  }
+
+  void dismiss() {
+    assert(!series_of(this));
+    delete this;
+  }
+
+public:
+  ARGS *get_args() { return &this->args; }
+
+  //*read/write返回字节数,sync返回0,失败返回-1
+  long get_retval() const {
+    if (this->state == WFT_STATE_SUCCESS)
+      return this->get_res();
+    else
+      return -1;
+  }
+
+public:
+  void *user_data;
+
+public:
+  int get_state() const { return this->state; }
+  int get_error() const { return this->error; }
+
+public:
+  void set_callback(std::function<void(WFFileTask<ARGS> *)> cb) {
+    this->callback = std::move(cb);
+  }
+
+protected:
+  virtual SubTask *done() {
+    SeriesWork *series = series_of(this);
+
+    if (this->callback)
+      this->callback(this);
+
+    delete this;
+    return series->pop();
+  }
+
+protected:
+  ARGS args;
+  std::function<void(WFFileTask<ARGS> *)> callback;
+
+public:
+  WFFileTask(IOService *service, std::function<void(WFFileTask<ARGS> *)> &&cb)
+      : IORequest(service), callback(std::move(cb)) {
+    this->user_data = NULL;
+    this->state = WFT_STATE_UNDEFINED;
+    this->error = 0;
+  }
+
+protected:
+  virtual ~WFFileTask() {}
+};
+
+/**********Go Task**********/
+
+//*execute()由WFTaskFactory::create_go_task生成的子类实现
+class WFGoTask : public ExecRequest {
+public:
+  void start() {
+    assert(!series_of(this));
+    Workflow::start_series_work(this, nullptr);
+  }
+
+  void dismiss() {
+    assert(!series_of(this));
+    delete this;
+  }
+
+public:
+  void *user_data;
+
+public:
+  int get_state() const { return this->state; }
+  int get_error() const { return this->error; }
+
+public:
+  void set_callback(std::function<void(WFGoTask *)> cb) {
+    this->callback = std::move(cb);
+  }
+
+  //*排队超过timeout毫秒还没开始就不执行,state为WFT_STATE_ABORTED,error为ETIMEDOUT
+  void set_queue_timeout(int timeout) { this->queue_timeo = timeout; }
+
+protected:
+  virtual int queue_timeout() { return this->queue_timeo; }
+
+protected:
+  virtual SubTask *done() {
+    SeriesWork *series = series_of(this);
+
+    if (this->callback)
+      this->callback(this);
+
+    delete this;
+    return series->pop();
+  }
+
+protected:
+  int queue_timeo;
+  std::function<void(WFGoTask *)> callback;
+
+public:
+  WFGoTask(ExecQueue *queue, Executor *executor)
+      : ExecRequest(queue, executor) {
+    this->queue_timeo = -1;
+    this->user_data = NULL;
+    this->state = WFT_STATE_UNDEFINED;
+    this->error = 0;
+  }
+
+protected:
+  virtual ~WFGoTask() {}
+};
+
+/**********Thread Task**********/
+
+//*在计算线程里用INPUT算出OUTPUT,execute()由WFThreadTaskFactory生成的子类实现
+template <class INPUT, class OUTPUT> class WFThreadTask : public ExecRequest {
+public:
+  void start() {
+    assert(!series_of(this));
+    Workflow::start_series_work(this, nullptr);
+  }
+
+  void dismiss() {
+    assert(!series_of(this));
+    delete this;
+  }
+
+public:
+  INPUT *get_input() { return &this->input; }
+  OUTPUT *get_output() { return &this->output; }
+
+public:
+  void *user_data;
+
+public:
+  int get_state() const { return this->state; }
+  int get_error() const { return this->error; }
+
+public:
+  void set_callback(std::function<void(WFThreadTask<INPUT, OUTPUT> *)> cb) {
+    this->callback = std::move(cb);
+  }
+
+  void set_queue_timeout(int timeout) { this->queue_timeo = timeout; }
+
+protected:
+  virtual int queue_timeout() { return this->queue_timeo; }
+
+protected:
+  virtual SubTask *done() {
+    SeriesWork *series = series_of(this);
+
+    if (this->callback)
+      this->callback(this);
+
+    delete this;
+    return series->pop();
+  }
+
+protected:
+  INPUT input;
+  OUTPUT output;
+  int queue_timeo;
+  std::function<void(WFThreadTask<INPUT, OUTPUT> *)> callback;
+
+public:
+  WFThreadTask(ExecQueue *queue, Executor *executor,
+               std::function<void(WFThreadTask<INPUT, OUTPUT> *)> &&cb)
+      : ExecRequest(queue, executor), callback(std::move(cb)) {
+    this->queue_timeo = -1;
+    this->user_data = NULL;
+    this->state = WFT_STATE_UNDEFINED;
+    this->error = 0;
+  }
+
+protected:
+  virtual ~WFThreadTask() {}
+};
+
+/**********Parallel For Task**********/
+
+//*把[begin, end)交给多个计算线程.task本身就是ExecSession,被请求workers次,
+//*每个worker用next_range()从同一个游标上抢下一块,块的大小随剩余量变小.
+//*最后一个结束的worker让task完成,回到所在的series
+class WFParallelForTask : public SubTask, public ExecSession {
+public:
+  void start() {
+    assert(!series_of(this));
+    Workflow::start_series_work(this, nullptr);
+  }
+
+  void dismiss() {
+    assert(!series_of(this));
+    delete this;
+  }
+
+public:
+  size_t get_begin() const { return this->begin; }
+  size_t get_end() const { return this->end; }
+  size_t get_workers() const { return this->workers; }
+
+public:
+  void *user_data;
+
+public:
+  int get_state() const { return this->state; }
+  int get_error() const { return this->error; }
+
+public:
+  void set_callback(std::function<void(WFParallelForTask *)> cb) {
+    this->callback = std::move(cb);
+  }
+
+  //*对每个worker单独计时,有一个worker开始了就会把整个区间做完
+  void set_queue_timeout(int timeout) { this->queue_timeo = timeout; }
+
+protected:
+  virtual void dispatch() {
+    Executor *executor = this->executor;
+    ExecQueue *queue = this->queue;
+    size_t n = this->workers;
+    size_t i;
+
+    this->state = WFT_STATE_SUCCESS;
+    this->error = 0;
+    this->next = this->begin;
+    this->pending = n;
+    this->cancel_error = 0;
+    if (n == 0) {
+      this->subtask_done();
+      return;
+    }
+
+    //*已经请求成功的worker会做完全部的块,只有一个都没请求到才算出错
+    for (i = 0; i < n; i++) {
+      if (executor->request(this, queue) < 0) {
+        if (i == 0) {
+          this->state = WFT_STATE_SYS_ERROR;
+          this->error = errno;
+        }
+
+        this->finish(n - i);
+        break;
+      }
+    }
+  }
+
+  virtual SubTask *done() {
+    SeriesWork *series = series_of(this);
+
+    if (this->callback)
+      this->callback(this);
+
+    delete this;
+    return series->pop();
+  }
+
+protected:
+  //*抢[*first, *last),没有剩余时返回false
+  bool next_range(size_t *first, size_t *last) {
+    size_t cur = this->next.load(std::memory_order_relaxed);
+    size_t grain;
+
+    do {
+      if (cur >= this->end)
+        return false;
+
+      grain = (this->end - cur) / (2 * this->workers);
+      if (grain == 0)
+        grain = 1;
+    } while (!this->next.compare_exchange_weak(cur, cur + grain,
+                                               std::memory_order_relaxed));
+
+    *first = cur;
+    *last = cur + grain;
+    return true;
+  }
+
+  virtual int queue_timeout() { return this->queue_timeo; }
+
+private:
+  //*worker超时或Executor销毁时被取消.执行了的worker会把块做完,
+  //*所以最后看游标:走到end就算成功,否则所有worker都被取消了
+  virtual void handle(int state, int error) {
+    if (state != ES_STATE_FINISHED)
+      this->cancel_error.store(error, std::memory_order_relaxed);
+
+    this->finish(1);
+  }
+
+  void finish(size_t count) {
+    if (this->pending.fetch_sub(count, std::memory_order_acq_rel) == count) {
+      if (this->next.load(std::memory_order_relaxed) != this->end &&
+          this->state == WFT_STATE_SUCCESS) {
+        this->state = WFT_STATE_ABORTED;
+        this->error = this->cancel_error.load(std::memory_order_relaxed);
+      }
+
+      this->subtask_done();
+    }
+  }
+
+protected:
+  size_t begin;
+  size_t end;
+  size_t workers;
+  std::atomic<size_t> next;
+  std::atomic<size_t> pending;
+  std::atomic<int> cancel_error;
+  int state;
+  int error;
+  int queue_timeo;
+  ExecQueue *queue;
+  Executor *executor;
+  std::function<void(WFParallelForTask *)> callback;
+
+public:
+  WFParallelForTask(ExecQueue *queue, Executor *executor, size_t begin,
+                    size_t end, size_t workers,
+                    std::function<void(WFParallelForTask *)> &&cb)
+      : callback(std::move(cb)) {
+    this->begin = begin;
+    this->end = end > begin ? end : begin;
+    this->workers = std::min(workers, this->end - this->begin);
+    this->queue = queue;
+    this->executor = executor;
+    this->queue_timeo = -1;
+    this->user_data = NULL;
+    this->state = WFT_STATE_UNDEFINED;
+    this->error = 0;
+  }
+
+protected:
+  virtual ~WFParallelForTask() {}
+};
+
+/**********Map Reduce Task**********/
+
+//*每个worker把抢到的块map进自己的partial,做完后reduce进result.
+//*result与partial都从identity开始,reduce需要满足结合律与交换律
+template <class T> class WFMapReduceTask : public WFParallelForTask {
+public:
+  T *get_result() { return &this->result; }
+
+public:
+  //*回调只存一份在基类里,通过WFParallelForTask *设置的回调同样有效
+  void set_callback(std::function<void(WFMapReduceTask<T> *)> cb) {
+    WFParallelForTask::set_callback(wrap_callback(std::move(cb)));
+  }
+
+protected:
+  T identity;
+  T result;
+  std::mutex mutex;
+
+private:
+  static std::function<void(WFParallelForTask *)>
+  wrap_callback(std::function<void(WFMapReduceTask<T> *)> &&cb) {
+    if (!cb)
+      return nullptr;
+
+    return [cb](WFParallelForTask *task) {
+      cb(static_cast<WFMapReduceTask<T> *>(task));
+    };
+  }
+
+public:
+  WFMapReduceTask(ExecQueue *queue, Executor *executor, size_t begin,
+                  size_t end, size_t workers, const T &identity,
+                  std::function<void(WFMapReduceTask<T> *)> &&cb)
+      : WFParallelForTask(queue, executor, begin, end, workers,
+                          wrap_callback(std::move(cb))),
+        identity(identity), result(identity) {}
+
+protected:
+  virtual ~WFMapReduceTask() {}
+};
+
 
 
 #include "./WFTask.inl"
@@ -25,3 +25,373 @@
   Authors: Xie Han (xiehan@sogou-inc.com)
 */
 
+#include "WFTaskFactory.h"
+#include "../manager/WFGlobal.h"
+#include "../util/AlignedBufferPool.h"
+#include "WFTask.h"
+#include <errno.h>
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+
+/**********File IO Tasks**********/
+
+class __WFFilepreadTask : public WFFileIOTask {
+public:
+  __WFFilepreadTask(int fd, void *buf, size_t count, off_t offset,
+                    IOService *service, fio_callback_t &&cb)
+      : WFFileIOTask(service, std::move(cb)) {
+    this->args.fd = fd;
+    this->args.buf = buf;
+    this->args.count = count;
+    this->args.offset = offset;
+  }
+
+protected:
+  virtual int prepare() {
+    this->prep_pread(this->args.fd, this->args.buf, this->args.count,
+                     this->args.offset);
+    return 0;
+  }
+};
+
+class __WFFilepwriteTask : public WFFileIOTask {
+public:
+  __WFFilepwriteTask(int fd, const void *buf, size_t count, off_t offset,
+                     IOService *service, fio_callback_t &&cb)
+      : WFFileIOTask(service, std::move(cb)) {
+    this->args.fd = fd;
+    this->args.buf = (void *)buf;
+    this->args.count = count;
+    this->args.offset = offset;
+  }
+
+protected:
+  virtual int prepare() {
+    this->prep_pwrite(this->args.fd, this->args.buf, this->args.count,
+                      this->args.offset);
+    return 0;
+  }
+};
+
+class __WFFilepreadvTask : public WFFileVIOTask {
+public:
+  __WFFilepreadvTask(int fd, const struct iovec *iov, int iovcnt,
+                     off_t offset, IOService *service, fvio_callback_t &&cb)
+      : WFFileVIOTask(service, std::move(cb)) {
+    this->args.fd = fd;
+    this->args.iov = iov;
+    this->args.iovcnt = iovcnt;
+    this->args.offset = offset;
+  }
+
+protected:
+  virtual int prepare() {
+    this->prep_preadv(this->args.fd, this->args.iov, this->args.iovcnt,
+                      this->args.offset);
+    return 0;
+  }
+};
+
+class __WFFilepwritevTask : public WFFileVIOTask {
+public:
+  __WFFilepwritevTask(int fd, const struct iovec *iov, int iovcnt,
+                      off_t offset, IOService *service, fvio_callback_t &&cb)
+      : WFFileVIOTask(service, std::move(cb)) {
+    this->args.fd = fd;
+    this->args.iov = iov;
+    this->args.iovcnt = iovcnt;
+    this->args.offset = offset;
+  }
+
+protected:
+  virtual int prepare() {
+    this->prep_pwritev(this->args.fd, this->args.iov, this->args.iovcnt,
+                       this->args.offset);
+    return 0;
+  }
+};
+
+class __WFFilefsyncTask : public WFFileSyncTask {
+public:
+  __WFFilefsyncTask(int fd, IOService *service, fsync_callback_t &&cb)
+      : WFFileSyncTask(service, std::move(cb)) {
+    this->args.fd = fd;
+  }
+
+protected:
+  virtual int prepare() {
+    this->prep_fsync(this->args.fd);
+    return 0;
+  }
+};
+
+class __WFFilefdsyncTask : public WFFileSyncTask {
+public:
+  __WFFilefdsyncTask(int fd, IOService *service, fsync_callback_t &&cb)
+      : WFFileSyncTask(service, std::move(cb)) {
+    this->args.fd = fd;
+  }
+
+protected:
+  virtual int prepare() {
+    this->prep_fdsync(this->args.fd);
+    return 0;
+  }
+};
+
+//*故意不析构:退出时仍在析构的direct任务还要归还缓冲
+static AlignedBufferPool *__direct_buffer_pool() {
+  static AlignedBufferPool *pool = new AlignedBufferPool;
+  return pool;
+}
+
+//*O_DIRECT,buf来自对齐的缓冲池,任务析构时归还
+class __WFFileDirectTask : public WFFileIOTask {
+public:
+  __WFFileDirectTask(int fd, size_t count, off_t offset, bool write,
+                     IOService *service, fio_callback_t &&cb)
+      : WFFileIOTask(service, std::move(cb)) {
+    this->args.fd = fd;
+    this->args.buf = __direct_buffer_pool()->get(count);
+    this->args.count = count;
+    this->args.offset = offset;
+    this->pooled = this->args.buf;
+    this->write = write;
+  }
+
+  __WFFileDirectTask(int fd, void *buf, size_t count, off_t offset,
+                     IOService *service, fio_callback_t &&cb)
+      : WFFileIOTask(service, std::move(cb)) {
+    this->args.fd = fd;
+    this->args.buf = buf;
+    this->args.count = count;
+    this->args.offset = offset;
+    this->pooled = NULL;
+    this->write = true;
+  }
+
+protected:
+  virtual int prepare() {
+    if (!this->args.buf) {
+      errno = ENOMEM;
+      return -1;
+    }
+
+    if (this->write)
+      this->prep_pwrite(this->args.fd, this->args.buf, this->args.count,
+                        this->args.offset);
+    else
+      this->prep_pread(this->args.fd, this->args.buf, this->args.count,
+                       this->args.offset);
+
+    return 0;
+  }
+
+  virtual ~__WFFileDirectTask() {
+    if (this->pooled)
+      __direct_buffer_pool()->put(this->pooled, this->args.count);
+  }
+
+private:
+  void *pooled;
+  bool write;
+};
+
+WFFileIOTask *WFTaskFactory::create_pread_task(int fd, void *buf, size_t count,
+                                               off_t offset,
+                                               fio_callback_t callback) {
+  return new __WFFilepreadTask(fd, buf, count, offset,
+                               WFGlobal::get_io_service(),
+                               std::move(callback));
+}
+
+WFFileIOTask *WFTaskFactory::create_pwrite_task(int fd, const void *buf,
+                                                size_t count, off_t offset,
+                                                fio_callback_t callback) {
+  return new __WFFilepwriteTask(fd, buf, count, offset,
+                                WFGlobal::get_io_service(),
+                                std::move(callback));
+}
+
+WFFileVIOTask *WFTaskFactory::create_preadv_task(int fd,
+                                                 const struct iovec *iov,
+                                                 int iovcnt, off_t offset,
+                                                 fvio_callback_t callback) {
+  return new __WFFilepreadvTask(fd, iov, iovcnt, offset,
+                                WFGlobal::get_io_service(),
+                                std::move(callback));
+}
+
+WFFileVIOTask *WFTaskFactory::create_pwritev_task(int fd,
+                                                  const struct iovec *iov,
+                                                  int iovcnt, off_t offset,
+                                                  fvio_callback_t callback) {
+  return new __WFFilepwritevTask(fd, iov, iovcnt, offset,
+                                 WFGlobal::get_io_service(),
+                                 std::move(callback));
+}
+
+WFFileSyncTask *WFTaskFactory::create_fsync_task(int fd,
+                                                 fsync_callback_t callback) {
+  return new __WFFilefsyncTask(fd, WFGlobal::get_io_service(),
+                               std::move(callback));
+}
+
+WFFileSyncTask *WFTaskFactory::create_fdsync_task(int fd,
+                                                  fsync_callback_t callback) {
+  return new __WFFilefdsyncTask(fd, WFGlobal::get_io_service(),
+                                std::move(callback));
+}
+
+WFFileIOTask *WFTaskFactory::create_pread_direct_task(int fd, size_t count,
+                                                      off_t offset,
+                                                      fio_callback_t callback) {
+  return new __WFFileDirectTask(fd, count, offset, false,
+                                WFGlobal::get_io_service(),
+                                std::move(callback));
+}
+
+WFFileIOTask *WFTaskFactory::create_pwrite_direct_task(
+    int fd, const void *buf, size_t count, off_t offset,
+    fio_callback_t callback) {
+  IOService *service = WFGlobal::get_io_service();
+  __WFFileDirectTask *task;
+
+  if ((uintptr_t)buf % AlignedBufferPool::ALIGNMENT == 0)
+    return new __WFFileDirectTask(fd, (void *)buf, count, offset, service,
+                                  std::move(callback));
+
+  task = new __WFFileDirectTask(fd, count, offset, true, service,
+                                std::move(callback));
+  if (task->get_args()->buf)
+    memcpy(task->get_args()->buf, buf, count);
+
+  return task;
+}
+
+/**********Timer Tasks**********/
+
+class __WFTimerTask : public WFTimerTask {
+public:
+  __WFTimerTask(time_t seconds, long nanoseconds, CommScheduler *scheduler,
+                timer_callback_t &&cb)
+      : WFTimerTask(scheduler, std::move(cb)) {
+    this->value.tv_sec = seconds;
+    this->value.tv_nsec = nanoseconds;
+  }
+
+protected:
+  virtual int duration(struct timespec *value) {
+    *value = this->value;
+    return 0;
+  }
+
+private:
+  struct timespec value;
+};
+
+class __WFNamedTimerTask;
+
+//*名字到正在等待的命名定时器.dispatch()里sleep()与登记在同一把锁下,
+//*所以定时器到期后的handle()总能在表里找到自己.cancel_by_name()也持锁
+//*unsleep():poller的定时器节点在handle()返回后才释放,而handle()要先拿到
+//*这把锁把自己摘掉,所以还在表里的task的节点一定有效
+static std::mutex __timer_mutex;
+static std::map<std::string, std::list<__WFNamedTimerTask *>> __timer_map;
+
+class __WFNamedTimerTask : public __WFTimerTask {
+public:
+  __WFNamedTimerTask(const std::string &name, time_t seconds,
+                     long nanoseconds, CommScheduler *scheduler,
+                     timer_callback_t &&cb)
+      : __WFTimerTask(seconds, nanoseconds, scheduler, std::move(cb)),
+        name(name) {
+    this->in_map = false;
+  }
+
+  virtual void dispatch() {
+    int ret;
+
+    __timer_mutex.lock();
+    ret = this->scheduler->sleep(this);
+    if (ret >= 0) {
+      auto &timers = __timer_map[this->name];
+
+      this->pos = timers.insert(timers.end(), this);
+      this->in_map = true;
+    }
+
+    __timer_mutex.unlock();
+    if (ret < 0)
+      this->handle(SS_STATE_ERROR, errno);
+  }
+
+protected:
+  virtual void handle(int state, int error) {
+    __timer_mutex.lock();
+    if (this->in_map) {
+      auto it = __timer_map.find(this->name);
+
+      it->second.erase(this->pos);
+      if (it->second.empty())
+        __timer_map.erase(it);
+
+      this->in_map = false;
+    }
+
+    __timer_mutex.unlock();
+    WFTimerTask::handle(state, error);
+  }
+
+private:
+  std::string name;
+  std::list<__WFNamedTimerTask *>::iterator pos;
+  bool in_map;
+
+  friend class WFTaskFactory;
+};
+
+WFTimerTask *WFTaskFactory::create_timer_task(time_t seconds, long nanoseconds,
+                                              timer_callback_t callback) {
+  return new __WFTimerTask(seconds, nanoseconds, WFGlobal::get_scheduler(),
+                           std::move(callback));
+}
+
+WFTimerTask *WFTaskFactory::create_timer_task(const std::string &timer_name,
+                                              time_t seconds, long nanoseconds,
+                                              timer_callback_t callback) {
+  return new __WFNamedTimerTask(timer_name, seconds, nanoseconds,
+                                WFGlobal::get_scheduler(),
+                                std::move(callback));
+}
+
+//*unsleep()的结果经msgqueue交给handler线程.msgqueue满时put会阻塞,
+//*若此时所有handler线程都在handle()里等这把锁就会死锁,所以不要一次取消
+//*上万个同名定时器,或者用max分批取消
+size_t WFTaskFactory::cancel_by_name(const std::string &timer_name,
+                                     size_t max) {
+  std::lock_guard<std::mutex> lock(__timer_mutex);
+  auto it = __timer_map.find(timer_name);
+  __WFNamedTimerTask *task;
+  size_t n = 0;
+
+  if (it == __timer_map.end())
+    return 0;
+
+  while (n < max && !it->second.empty()) {
+    task = it->second.front();
+    it->second.pop_front();
+    task->in_map = false;
+    //*已经到期的定时器正等着这把锁进handle(),unsleep()失败,不计数
+    if (task->cancel() >= 0)
+      n++;
+  }
+
+  if (it->second.empty())
+    __timer_map.erase(it);
+
+  return n;
+}
@@ -40,6 +40,9 @@ using namespace std;
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <time.h>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
 #include <utility>
 
 // Network Client/Server tasks
@@ -47,6 +50,116 @@ using namespace std;
 using WFHttpTask = WFNetworkTask<protocol::HttpRequest, protocol::HttpResponse>;
 using http_callback_t = std::function<void(WFHttpTask *)>;
 
+// File IO tasks
+
+struct FileIOArgs {
+  int fd;
+  void *buf;
+  size_t count;
+  off_t offset;
+};
+
+struct FileVIOArgs {
+  int fd;
+  const struct iovec *iov;
+  int iovcnt;
+  off_t offset;
+};
+
+struct FileSyncArgs {
+  int fd;
+};
+
+using WFFileIOTask = WFFileTask<struct FileIOArgs>;
+using fio_callback_t = std::function<void(WFFileIOTask *)>;
+
+using WFFileVIOTask = WFFileTask<struct FileVIOArgs>;
+using fvio_callback_t = std::function<void(WFFileVIOTask *)>;
+
+using WFFileSyncTask = WFFileTask<struct FileSyncArgs>;
+using fsync_callback_t = std::function<void(WFFileSyncTask *)>;
+
+using parallel_for_callback_t = std::function<void(WFParallelForTask *)>;
+
+using timer_callback_t = std::function<void(WFTimerTask *)>;
+
+class WFTaskFactory {
+public:
+  //*buf/iov在回调之前必须保持有效,get_retval()为读写的字节数.
+  //*在handler线程(任务回调)里发起的文件io等回调返回后才一起提交,
+  //*要在回调里同步等待它完成,先调用IOService::flush_deferred()
+  static WFFileIOTask *create_pread_task(int fd, void *buf, size_t count,
+                                         off_t offset,
+                                         fio_callback_t callback);
+
+  static WFFileIOTask *create_pwrite_task(int fd, const void *buf,
+                                          size_t count, off_t offset,
+                                          fio_callback_t callback);
+
+  static WFFileVIOTask *create_preadv_task(int fd, const struct iovec *iov,
+                                           int iovcnt, off_t offset,
+                                           fvio_callback_t callback);
+
+  static WFFileVIOTask *create_pwritev_task(int fd, const struct iovec *iov,
+                                            int iovcnt, off_t offset,
+                                            fvio_callback_t callback);
+
+  static WFFileSyncTask *create_fsync_task(int fd, fsync_callback_t callback);
+
+  //*fdatasync
+  static WFFileSyncTask *create_fdsync_task(int fd, fsync_callback_t callback);
+
+  //*O_DIRECT:fd以O_DIRECT打开,offset与count按块大小对齐.
+  //*读的buf来自对齐的缓冲池,回调里从get_args()->buf取数据,回调后归还
+  static WFFileIOTask *create_pread_direct_task(int fd, size_t count,
+                                                off_t offset,
+                                                fio_callback_t callback);
+
+  //*buf按4KB对齐时直接写,否则先拷到缓冲池的buf里
+  static WFFileIOTask *create_pwrite_direct_task(int fd, const void *buf,
+                                                 size_t count, off_t offset,
+                                                 fio_callback_t callback);
+
+  //*在名为queue_name的队列上用计算线程执行func(args...).
+  //*func与args按值存在task对象里(同std::bind,引用用std::ref),除task本身外不再分配
+  template <class FUNC, class... ARGS>
+  static WFGoTask *create_go_task(const std::string &queue_name, FUNC &&func,
+                                  ARGS &&...args);
+
+  //*queue来自WFGlobal::get_exec_queue(),省去每次按名字查找
+  template <class FUNC, class... ARGS>
+  static WFGoTask *create_go_task(ExecQueue *queue, FUNC &&func,
+                                  ARGS &&...args);
+
+  //*对[begin, end)里的每个下标i执行func(i),分块交给计算线程,
+  //*worker数取计算线程数与下标个数的较小值
+  template <class FUNC>
+  static WFParallelForTask *
+  create_parallel_for_task(const std::string &queue_name, size_t begin,
+                           size_t end, FUNC &&func,
+                           parallel_for_callback_t callback);
+
+  template <class FUNC>
+  static WFParallelForTask *
+  create_parallel_for_task(ExecQueue *queue, size_t begin, size_t end,
+                           FUNC &&func, parallel_for_callback_t callback);
+
+  //*定时器,到期时间按WFGlobalSettings::timer_slack向上取整,
+  //*同一窗口里到期的定时器由poller的一次唤醒处理
+  static WFTimerTask *create_timer_task(time_t seconds, long nanoseconds,
+                                        timer_callback_t callback);
+
+  //*命名定时器,启动后可以用cancel_by_name()按名字取消
+  static WFTimerTask *create_timer_task(const std::string &timer_name,
+                                        time_t seconds, long nanoseconds,
+                                        timer_callback_t callback);
+
+  //*取消最多max个名为timer_name且正在等待的定时器,返回取消的个数.
+  //*被取消的定时器照常回调,get_state()为WFT_STATE_SYS_ERROR,get_error()为ECANCELED
+  static size_t cancel_by_name(const std::string &timer_name,
+                               size_t max = (size_t)-1);
+};
+
 
 
 template <class REQ, class RESP> class WFNetworkTaskFactory {
@@ -61,6 +174,43 @@ public:
                                std::function<void(T *)> &process);
 };
 
+template <class T> class WFMapReduceTaskFactory {
+private:
+  using MR = WFMapReduceTask<T>;
+
+public:
+  //*map(size_t i, T *partial)把下标i累加进partial,
+  //*reduce(T *result, T *partial)把一个worker的partial合并进result
+  template <class MAP, class REDUCE>
+  static MR *create_map_reduce_task(const std::string &queue_name,
+                                    size_t begin, size_t end,
+                                    const T &identity, MAP &&map,
+                                    REDUCE &&reduce,
+                                    std::function<void(MR *)> callback);
+
+  template <class MAP, class REDUCE>
+  static MR *create_map_reduce_task(ExecQueue *queue, size_t begin,
+                                    size_t end, const T &identity, MAP &&map,
+                                    REDUCE &&reduce,
+                                    std::function<void(MR *)> callback);
+};
+
+template <class INPUT, class OUTPUT> class WFThreadTaskFactory {
+private:
+  using T = WFThreadTask<INPUT, OUTPUT>;
+
+public:
+  //*routine(INPUT *, OUTPUT *)按值存在task对象里,不经过std::function
+  template <class ROUTINE>
+  static T *create_thread_task(const std::string &queue_name,
+                               ROUTINE &&routine,
+                               std::function<void(T *)> callback);
+
+  template <class ROUTINE>
+  static T *create_thread_task(ExecQueue *queue, ROUTINE &&routine,
+                               std::function<void(T *)> callback);
+};
+
 
 #include "../manager/EndpointParams.h"
 #include "../manager/WFGlobal.h"
@@ -91,6 +241,207 @@ WFNetworkTask<REQ, RESP> *WFNetworkTaskFactory<REQ, RESP>::create_server_task(
   return new WFServerTask<REQ, RESP>(service, WFGlobal::get_scheduler(), proc);
 }
 
+/**********Template Go Task Factory**********/
+
+template <size_t... I> struct __WFGoIndex {};
+
+template <size_t N, size_t... I>
+struct __WFGoMakeIndex : __WFGoMakeIndex<N - 1, N - 1, I...> {};
+
+template <size_t... I> struct __WFGoMakeIndex<0, I...> {
+  using type = __WFGoIndex<I...>;
+};
+
+//*可调用对象与参数是成员,随task一起分配,没有类型擦除
+template <class FUNC, class... ARGS> class __WFGoTask : public WFGoTask {
+protected:
+  virtual void execute() {
+    this->run(typename __WFGoMakeIndex<sizeof...(ARGS)>::type());
+  }
+
+private:
+  template <size_t... I> void run(__WFGoIndex<I...>) {
+    this->go(std::get<I>(this->args)...);
+  }
+
+protected:
+  FUNC go;
+  std::tuple<ARGS...> args;
+
+public:
+  template <class F, class... A>
+  __WFGoTask(ExecQueue *queue, Executor *executor, F &&func, A &&...args)
+      : WFGoTask(queue, executor), go(std::forward<F>(func)),
+        args(std::forward<A>(args)...) {}
+};
+
+template <class FUNC, class... ARGS>
+WFGoTask *WFTaskFactory::create_go_task(const std::string &queue_name,
+                                        FUNC &&func, ARGS &&...args) {
+  return WFTaskFactory::create_go_task(WFGlobal::get_exec_queue(queue_name),
+                                       std::forward<FUNC>(func),
+                                       std::forward<ARGS>(args)...);
+}
+
+template <class FUNC, class... ARGS>
+WFGoTask *WFTaskFactory::create_go_task(ExecQueue *queue, FUNC &&func,
+                                        ARGS &&...args) {
+  return new __WFGoTask<typename std::decay<FUNC>::type,
+                        typename std::decay<ARGS>::type...>(
+      queue, WFGlobal::get_compute_executor(), std::forward<FUNC>(func),
+      std::forward<ARGS>(args)...);
+}
+
+template <class INPUT, class OUTPUT, class ROUTINE>
+class __WFThreadTask : public WFThreadTask<INPUT, OUTPUT> {
+protected:
+  virtual void execute() { this->routine(&this->input, &this->output); }
+
+protected:
+  ROUTINE routine;
+
+public:
+  template <class R>
+  __WFThreadTask(ExecQueue *queue, Executor *executor, R &&rt,
+                 std::function<void(WFThreadTask<INPUT, OUTPUT> *)> &&cb)
+      : WFThreadTask<INPUT, OUTPUT>(queue, executor, std::move(cb)),
+        routine(std::forward<R>(rt)) {}
+};
+
+template <class INPUT, class OUTPUT>
+template <class ROUTINE>
+WFThreadTask<INPUT, OUTPUT> *
+WFThreadTaskFactory<INPUT, OUTPUT>::create_thread_task(
+    const std::string &queue_name, ROUTINE &&routine,
+    std::function<void(WFThreadTask<INPUT, OUTPUT> *)> callback) {
+  return WFThreadTaskFactory<INPUT, OUTPUT>::create_thread_task(
+      WFGlobal::get_exec_queue(queue_name), std::forward<ROUTINE>(routine),
+      std::move(callback));
+}
+
+template <class INPUT, class OUTPUT>
+template <class ROUTINE>
+WFThreadTask<INPUT, OUTPUT> *
+WFThreadTaskFactory<INPUT, OUTPUT>::create_thread_task(
+    ExecQueue *queue, ROUTINE &&routine,
+    std::function<void(WFThreadTask<INPUT, OUTPUT> *)> callback) {
+  return new __WFThreadTask<INPUT, OUTPUT, typename std::decay<ROUTINE>::type>(
+      queue, WFGlobal::get_compute_executor(), std::forward<ROUTINE>(routine),
+      std::move(callback));
+}
+
+/**********Template Parallel Factory**********/
+
+//*workers数跟计算线程数一样,线程数由WFGlobalSettings::compute_threads决定
+static inline size_t __WFParallelWorkers() {
+  int threads = WFGlobal::get_global_settings()->compute_threads;
+
+  if (threads <= 0)
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return threads > 0 ? threads : 1;
+}
+
+template <class FUNC> class __WFParallelForTask : public WFParallelForTask {
+protected:
+  virtual void execute() {
+    size_t first, last;
+
+    while (this->next_range(&first, &last)) {
+      for (; first < last; first++)
+        this->func(first);
+    }
+  }
+
+protected:
+  FUNC func;
+
+public:
+  template <class F>
+  __WFParallelForTask(ExecQueue *queue, Executor *executor, size_t begin,
+                      size_t end, size_t workers, F &&f,
+                      parallel_for_callback_t &&cb)
+      : WFParallelForTask(queue, executor, begin, end, workers, std::move(cb)),
+        func(std::forward<F>(f)) {}
+};
+
+template <class FUNC>
+WFParallelForTask *WFTaskFactory::create_parallel_for_task(
+    const std::string &queue_name, size_t begin, size_t end, FUNC &&func,
+    parallel_for_callback_t callback) {
+  return WFTaskFactory::create_parallel_for_task(
+      WFGlobal::get_exec_queue(queue_name), begin, end,
+      std::forward<FUNC>(func), std::move(callback));
+}
+
+template <class FUNC>
+WFParallelForTask *WFTaskFactory::create_parallel_for_task(
+    ExecQueue *queue, size_t begin, size_t end, FUNC &&func,
+    parallel_for_callback_t callback) {
+  return new __WFParallelForTask<typename std::decay<FUNC>::type>(
+      queue, WFGlobal::get_compute_executor(), begin, end,
+      __WFParallelWorkers(), std::forward<FUNC>(func), std::move(callback));
+}
+
+template <class T, class MAP, class REDUCE>
+class __WFMapReduceTask : public WFMapReduceTask<T> {
+protected:
+  virtual void execute() {
+    T partial(this->identity);
+    size_t first, last;
+    bool mapped = false;
+
+    while (this->next_range(&first, &last)) {
+      for (; first < last; first++)
+        this->map(first, &partial);
+
+      mapped = true;
+    }
+
+    if (mapped) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->reduce(&this->result, &partial);
+    }
+  }
+
+protected:
+  MAP map;
+  REDUCE reduce;
+
+public:
+  template <class M, class R>
+  __WFMapReduceTask(ExecQueue *queue, Executor *executor, size_t begin,
+                    size_t end, size_t workers, const T &identity, M &&m,
+                    R &&r, std::function<void(WFMapReduceTask<T> *)> &&cb)
+      : WFMapReduceTask<T>(queue, executor, begin, end, workers, identity,
+                           std::move(cb)),
+        map(std::forward<M>(m)), reduce(std::forward<R>(r)) {}
+};
+
+template <class T>
+template <class MAP, class REDUCE>
+WFMapReduceTask<T> *WFMapReduceTaskFactory<T>::create_map_reduce_task(
+    const std::string &queue_name, size_t begin, size_t end, const T &identity,
+    MAP &&map, REDUCE &&reduce,
+    std::function<void(WFMapReduceTask<T> *)> callback) {
+  return WFMapReduceTaskFactory<T>::create_map_reduce_task(
+      WFGlobal::get_exec_queue(queue_name), begin, end, identity,
+      std::forward<MAP>(map), std::forward<REDUCE>(reduce),
+      std::move(callback));
+}
+
+template <class T>
+template <class MAP, class REDUCE>
+WFMapReduceTask<T> *WFMapReduceTaskFactory<T>::create_map_reduce_task(
+    ExecQueue *queue, size_t begin, size_t end, const T &identity, MAP &&map,
+    REDUCE &&reduce, std::function<void(WFMapReduceTask<T> *)> callback) {
+  return new __WFMapReduceTask<T, typename std::decay<MAP>::type,
+                               typename std::decay<REDUCE>::type>(
+      queue, WFGlobal::get_compute_executor(), begin, end,
+      __WFParallelWorkers(), identity, std::forward<MAP>(map),
+      std::forward<REDUCE>(reduce), std::move(callback));
+}
+
 /**********Server Factory**********/
 
 class WFServerTaskFactory {
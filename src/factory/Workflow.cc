@@ -12,17 +12,18 @@
 #include <assert.h>
 #include <functional>
 #include <mutex>
+#include <sched.h>
 #include <stddef.h>
 #include <string.h>
 #include <utility>
 
 SeriesWork::SeriesWork(SubTask *first, series_callback_t &&cb)
     : callback(std::move(cb)) {
-  this->queue = this->buf; //*将队列指向缓冲区
-  this->queue_size =
-      sizeof this->buf / sizeof *this->buf; //*将缓冲区大小设置 为队列的大小
-  this->front = 0;                          //*索引
-  this->back = 0;                           //*索引
+  this->stub.series_next = NULL;
+  this->head = &this->stub; //*空队列只有哨兵
+  this->tail = &this->stub;
+  this->front_stack = NULL;
+  this->has_front = false;
   this->canceled = false;
   this->finished = false;
   assert(!series_of(first)); //*为空
@@ -33,10 +34,7 @@ SeriesWork::SeriesWork(SubTask *first, series_callback_t &&cb)
   this->in_parallel = NULL;
 }
 
-SeriesWork::~SeriesWork() {
-  if (this->queue != this->buf)
-    delete[] this->queue;
-}
+SeriesWork::~SeriesWork() {}
 
 void SeriesWork::dismiss_recursive() {
   SubTask *task = first;
@@ -48,57 +46,70 @@ void SeriesWork::dismiss_recursive() {
   } while (task);
 }
 
-//*扩容队列
-void SeriesWork::expand_queue() {
-  int size = 2 * this->queue_size; //*两倍扩容
-  SubTask **queue = new SubTask *[size];
-  int i, j;
-  i = 0;
-  j = this->front; //*当前执行到的任务对应索引
-  do {
-    queue[i++] = this->queue[j++];
-    if (j == this->queue_size)
-      j = 0;
-  } while (j != this->back);
-
-  if (this->queue != this->buf)
-    delete[] this->queue;
-
-  this->queue = queue;     //*将新创建的队列设置为当前队列
-  this->queue_size = size; //*重设二倍大小
-  this->front = 0;         //*第一个任务的索引
-  this->back = i;          //*最后一个任务的索引
+//*多生产者入队:exchange之后、链上前驱之前,消费者会看到断开的链,由dequeue()等待
+void SeriesWork::enqueue(SubTaskLink *link) {
+  SubTaskLink *prev;
+
+  link->series_next = NULL;
+  prev = __atomic_exchange_n(&this->head, link, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&prev->series_next, link, __ATOMIC_RELEASE);
+}
+
+//*等生产者把next链上,它只差一条store
+static SubTaskLink *__series_wait_next(SubTaskLink *link) {
+  SubTaskLink *next;
+
+  while (!(next = __atomic_load_n(&link->series_next, __ATOMIC_ACQUIRE)))
+    sched_yield();
+
+  return next;
 }
 
-//*向串行任务中加入任务
+//*单消费者出队,队列空时返回NULL
+SubTask *SeriesWork::dequeue() {
+  SubTaskLink *tail = this->tail;
+  SubTaskLink *next = __atomic_load_n(&tail->series_next, __ATOMIC_ACQUIRE);
+
+  if (tail == &this->stub) {
+    if (!next) {
+      if (__atomic_load_n(&this->head, __ATOMIC_ACQUIRE) == tail)
+        return NULL;
+
+      next = __series_wait_next(tail);
+    }
+
+    //*跳过哨兵
+    this->tail = next;
+    tail = next;
+    next = __atomic_load_n(&tail->series_next, __ATOMIC_ACQUIRE);
+  }
+
+  if (!next) {
+    //*tail是最后一个节点,把哨兵放回去才能取走它
+    if (__atomic_load_n(&this->head, __ATOMIC_ACQUIRE) == tail)
+      this->enqueue(&this->stub);
+
+    next = __series_wait_next(tail);
+  }
+
+  this->tail = next;
+  return static_cast<SubTask *>(tail);
+}
+
+//*放到队头.后放的先执行
 void SeriesWork::push_front(SubTask *task) {
-  this->mutex.lock();
-  //*font==0
-  if (--this->front == -1)
-    this->front = this->queue_size - 1;
-  //*将subtask的所属串行任务指针设置为当前
   task->set_pointer(this);
-  this->queue[this->front] = task;
-  //*装满了
-  if (this->front == this->back)
-    //*扩容
-    this->expand_queue();
-
+  this->mutex.lock();
+  task->series_next = this->front_stack;
+  this->front_stack = task;
+  __atomic_store_n(&this->has_front, true, __ATOMIC_RELEASE);
   this->mutex.unlock();
 }
 
-//*添加到末尾
+//*添加到末尾,不加锁
 void SeriesWork::push_back(SubTask *task) {
-  this->mutex.lock();
   task->set_pointer(this);
-  this->queue[this->back] = task;
-  if (++this->back == this->queue_size)
-    this->back = 0;
-
-  if (this->front == this->back)
-    this->expand_queue();
-
-  this->mutex.unlock();
+  this->enqueue(task);
 }
 
 //*取出一个任务并返回,如果cancel==true,还会递归删除所有任务
@@ -118,20 +129,28 @@ SubTask *SeriesWork::pop() {
 }
 
 SubTask *SeriesWork::pop_task() {
-  SubTask *task;
-  this->mutex.lock();
-  //*没执行完
-  if (this->front != this->back) {
-    task = this->queue[this->front];
-    //*队头任务为空
-    if (++this->front == this->queue_size)
-      this->front = 0;
-  } else {
+  SubTask *task = NULL;
+
+  if (__atomic_load_n(&this->has_front, __ATOMIC_ACQUIRE)) {
+    this->mutex.lock();
+    if (this->front_stack) {
+      task = static_cast<SubTask *>(this->front_stack);
+      this->front_stack = task->series_next;
+      if (!this->front_stack)
+        __atomic_store_n(&this->has_front, false, __ATOMIC_RELAXED);
+    }
+
+    this->mutex.unlock();
+  }
+
+  if (!task)
+    task = this->dequeue();
+
+  if (!task) {
     task = this->last;
     this->last = NULL;
   }
 
-  this->mutex.unlock();
   //*任务为空,即执行完成
   if (!task) {
     this->finished = true;
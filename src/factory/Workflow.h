@@ -114,21 +114,25 @@ protected:
   series_callback_t callback; //*执行完任务的回调函数
 
 private:
-  SubTask *pop_task(); //*取出队尾任务
-  void expand_queue(); //*扩容
+  SubTask *pop_task(); //*取出队头任务
+  void enqueue(SubTaskLink *link);
+  SubTask *dequeue();
 
 private:
-  SubTask *buf[4];
+  //*任务队列是链在SubTask里的无锁多生产者单消费者队列(Vyukov):
+  //*push_back()在任意线程用一次exchange追加;只有正在结束的任务会pop,
+  //*所以出队不加锁.push_front()很少用,放在mutex保护的栈里,出队时优先取
+  SubTaskLink stub;         //*哨兵节点
+  SubTaskLink *head;        //*最后入队的节点
+  SubTaskLink *tail;        //*下一个出队的节点,只有消费者访问
+  SubTaskLink *front_stack; //*push_front()的任务,后放的先出
+  bool has_front;           //*front_stack非空
   SubTask *first;  //*第一个任务,单独存储,就是初始化函数
   SubTask *last;   //*最后一个任务,单独存储,结束函数
-  SubTask **queue; //*任务队列
-  int queue_size;  //*任务队列的大小
-  int front;       //*头任务,指向queue->size
-  int back;        //*尾任务,指向0
   bool canceled;   //*取消
   bool finished;   //*完成
   const ParallelTask *in_parallel; //*是否并行
-  std::mutex mutex;                //*互斥锁
+  std::mutex mutex;                //*保护front_stack
 
 protected:
   SeriesWork(SubTask *first, series_callback_t &&callback);
@@ -162,7 +166,6 @@ inline SeriesWork *Workflow::create_series_work(SubTask *first,
 //*暂不清楚,好像是创建并执行
 inline void Workflow::start_series_work(SubTask *first,
                                         series_callback_t callback) {
-  std::cout << "start" << std::endl;
   new SeriesWork(first, std::move(callback));
   first->dispatch();
 }
@@ -83,8 +83,9 @@ private:
 
 class CommScheduler {
 public:
-  int init(size_t poller_threads, size_t handler_threads) {
-    return this->comm.init(poller_threads, handler_threads);
+  /* timer_slack in nanoseconds, 0 for exact timers. */
+  int init(size_t poller_threads, size_t handler_threads, long timer_slack) {
+    return this->comm.init(poller_threads, handler_threads, timer_slack);
   }
 
   void deinit() { this->comm.deinit(); }
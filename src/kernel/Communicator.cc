@@ -914,23 +914,33 @@ void Communicator::handle_sleep_result(struct poller_result *res) {
 void Communicator::handle_aio_result(struct poller_result *res) {
   IOService *service = (IOService *)res->data.context;
   IOSession *session;
+  IOSession *next;
   int state, error;
 
   switch (res->state) {
   case PR_ST_SUCCESS:
+    /* An eventfd count whose events were taken with an earlier one. */
+    if (res->data.result == service)
+      break;
+
+    /* A chain of finished sessions, off the session list already. */
     session = (IOSession *)res->data.result;
-    pthread_mutex_lock(&service->mutex);
-    list_del(&session->list);
-    pthread_mutex_unlock(&service->mutex);
-    if (session->res >= 0) {
-      state = IOS_STATE_SUCCESS;
-      error = 0;
-    } else {
-      state = IOS_STATE_ERROR;
-      error = -session->res;
-    }
+    do {
+      next = session->next;
+      if (session->res >= 0) {
+        state = IOS_STATE_SUCCESS;
+        error = 0;
+      } else {
+        state = IOS_STATE_ERROR;
+        error = -session->res;
+      }
+
+      session->handle(state, error);
+      session = next;
+    } while (session);
 
-    session->handle(state, error);
+    //*回调里发起的io要在decref()之前提交,引用归零时decref()会等它们完成
+    IOService::flush_deferred();
     service->decref();
     break;
 
@@ -949,6 +959,7 @@ void Communicator::handler_thread_routine(void *context) {
   Communicator *comm = (Communicator *)context;
   struct poller_result *res;
 
+  IOService::defer_requests();
   while (1) {
     res = (struct poller_result *)msgqueue_get(comm->msgqueue);
     if (!res)
@@ -984,6 +995,8 @@ void Communicator::handler_thread_routine(void *context) {
       continue;
     }
 
+    //*回调里发起的文件io,在这里一起提交
+    IOService::flush_deferred();
     free(res);
   }
 
@@ -1251,10 +1264,12 @@ int Communicator::create_handler_threads(size_t handler_threads) {
   return -1;
 }
 
-int Communicator::create_poller(size_t poller_threads) {
+int Communicator::create_poller(size_t poller_threads, long timer_slack) {
   struct poller_params params = {
       .max_open_files = (size_t)sysconf(_SC_OPEN_MAX),
       .callback = Communicator::callback,
+      .context = NULL,
+      .timer_slack = timer_slack,
   };
 
   if ((ssize_t)params.max_open_files < 0)
@@ -1277,13 +1292,14 @@ int Communicator::create_poller(size_t poller_threads) {
   return -1;
 }
 
-int Communicator::init(size_t poller_threads, size_t handler_threads) {
+int Communicator::init(size_t poller_threads, size_t handler_threads,
+                       long timer_slack) {
   if (poller_threads == 0) {
     errno = EINVAL;
     return -1;
   }
 
-  if (this->create_poller(poller_threads) >= 0) {
+  if (this->create_poller(poller_threads, timer_slack) >= 0) {
     if (this->create_handler_threads(handler_threads) >= 0) {
       this->stop_flag = 0;
       return 0;
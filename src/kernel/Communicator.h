@@ -233,7 +233,8 @@ public:
 
 class Communicator {
 public:
-  int init(size_t poller_threads, size_t handler_threads);
+  //*timer_slack:sleep()的定时器合并窗口(纳秒),0表示按精确时间唤醒
+  int init(size_t poller_threads, size_t handler_threads, long timer_slack);
   void deinit();
 
   int request(CommSession *session, CommTarget *target);
@@ -265,7 +266,7 @@ private:
   int stop_flag;
 
 private:
-  int create_poller(size_t poller_threads);
+  int create_poller(size_t poller_threads, long timer_slack);
 
   int create_handler_threads(size_t handler_threads);
 
@@ -15,105 +15,258 @@
 #include <errno.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <time.h>
 
 struct ExecSessionEntry {
   struct list_head list; //*执行链表
   ExecSession *session;  //*所属的session
-  thrdpool_t *thrdpool;  //*所属线程池
+  long long enqueue;     //*入队时间,CLOCK_MONOTONIC纳秒
+  long long deadline;    //*过了这个时间就不执行,0表示不限
 };
 
-int ExecQueue::init() {
-  int ret;
-  ret = pthread_mutex_init(&this->mutex, NULL);
-  if (ret == 0) {
-    INIT_LIST_HEAD(&this->session_list);
-    return 0;
-  }
+static inline long long __exec_time() {
+  struct timespec ts;
 
-  errno = ret;
-  return -1;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int ExecQueue::init() {
+  INIT_LIST_HEAD(&this->session_list);
+  INIT_LIST_HEAD(&this->list);
+  this->priority = EXEC_PRIORITY_NORMAL;
+  this->weight = 1;
+  this->deficit = 0;
+  this->cost = 0;
+  this->stats = {};
+  return 0;
 }
 
-void ExecQueue::deinit() { pthread_mutex_destroy(&this->mutex); }
+void ExecQueue::deinit() {}
 
 //*初始化线程池并创建指定数量的线程
 int Executor::init(size_t nthreads) {
-  this->thrdpool = thrdpool_create(nthreads, 0);
-  if (this->thrdpool)
-    return 0;
+  int ret;
+  int i;
+
+  ret = pthread_mutex_init(&this->mutex, NULL);
+  if (ret == 0) {
+    for (i = 0; i < EXEC_PRIORITY_MAX; i++) {
+      INIT_LIST_HEAD(&this->active[i]);
+      this->nactive[i] = 0;
+    }
+
+    this->thrdpool = thrdpool_create(nthreads, 0);
+    if (this->thrdpool)
+      return 0;
 
+    pthread_mutex_destroy(&this->mutex);
+    return -1;
+  }
+
+  errno = ret;
   return -1;
 }
 
 void Executor::deinit() {
   thrdpool_destroy(Executor::executor_cancel, this->thrdpool);
+  pthread_mutex_destroy(&this->mutex);
 }
 
 extern "C" void __thrdpool_schedule(const struct thrdpool_task *, void *,
                                     thrdpool_t *);
 
-//*添加任务到线程池执行
+//*在最高的非空优先级里做deficit round robin,调用者持有mutex.
+//*队首的deficit为正就取它,否则补weight个quantum排到队尾.
+//*全环都不为正时,先算出还要空转几整圈,一次补上,剩下的不超过一圈
+ExecQueue *Executor::pick_queue() {
+  struct list_head *ring;
+  struct list_head *pos;
+  ExecQueue *queue;
+  long long rounds;
+  long long deficit;
+  long long quantum;
+  int prio;
+
+  for (prio = 0; prio < EXEC_PRIORITY_MAX; prio++) {
+    if (this->nactive[prio] != 0)
+      break;
+  }
+
+  ring = &this->active[prio];
+  rounds = -1;
+  list_for_each(pos, ring) {
+    queue = list_entry(pos, ExecQueue, list);
+    deficit = queue->deficit.load(std::memory_order_relaxed);
+    if (deficit > 0) {
+      rounds = 0;
+      break;
+    }
+
+    //*补floor(-deficit / quantum) + 1次才为正,最先转正的那一圈之前都是整圈
+    quantum = queue->weight * EXEC_QUANTUM_NSEC;
+    if (rounds < 0 || -deficit / quantum < rounds)
+      rounds = -deficit / quantum;
+  }
+
+  if (rounds > 0) {
+    list_for_each(pos, ring) {
+      queue = list_entry(pos, ExecQueue, list);
+      queue->deficit += rounds * queue->weight * EXEC_QUANTUM_NSEC;
+    }
+  }
+
+  while (1) {
+    queue = list_entry(ring->next, ExecQueue, list);
+    if (queue->deficit.load(std::memory_order_relaxed) > 0)
+      return queue;
+
+    queue->deficit += queue->weight * EXEC_QUANTUM_NSEC;
+    list_move_tail(&queue->list, ring);
+  }
+}
+
+//*线程池里每个有session的队列对应一个任务,但运行哪个队列的session由pick_queue()决定.
+//*取出的队列还有session就用这个entry的内存重新投递一个任务,保持任务数与活跃队列数相等
 void Executor::executor_thread_routine(void *context) {
-  ExecQueue *queue = (ExecQueue *)context;
+  Executor *executor = (Executor *)context;
   struct ExecSessionEntry *entry;
   ExecSession *session;
+  ExecQueue *queue;
+  long long start;
+  long long wait;
+  long long charge;
+  long long elapsed;
+  int expired;
   int empty;
 
+  start = __exec_time();
+  pthread_mutex_lock(&executor->mutex);
+  queue = executor->pick_queue();
   entry = list_entry(queue->session_list.next, struct ExecSessionEntry, list);
-  pthread_mutex_lock(&queue->mutex);
   list_del(&entry->list);
+  //*start在加锁前取,这之后入队的entry算作没有等待
+  wait = start > entry->enqueue ? start - entry->enqueue : 0;
+  queue->stats.depth--;
+  expired = entry->deadline != 0 && start >= entry->deadline;
+  if (expired)
+    queue->stats.expired++;
+  else {
+    //*执行前按估计时间预扣,空闲线程不会一起挑中同一个队首
+    charge = queue->cost.load(std::memory_order_relaxed);
+    queue->deficit -= charge;
+    queue->stats.executed++;
+    queue->stats.wait_total += wait;
+    if ((unsigned long long)wait > queue->stats.wait_max)
+      queue->stats.wait_max = wait;
+  }
+
   empty = list_empty(&queue->session_list);
-  pthread_mutex_unlock(&queue->mutex);
+  if (empty) {
+    list_del(&queue->list);
+    executor->nactive[queue->priority]--;
+  }
+
+  pthread_mutex_unlock(&executor->mutex);
 
   session = entry->session;
   if (!empty) {
     struct thrdpool_task task = {.routine = Executor::executor_thread_routine,
-                                 .context = queue};
-    __thrdpool_schedule(&task, entry, entry->thrdpool);
+                                 .context = executor};
+    __thrdpool_schedule(&task, entry, executor->thrdpool);
   } else
     free(entry);
 
+  if (expired) {
+    session->handle(ES_STATE_CANCELED, ETIMEDOUT);
+    return;
+  }
+
+  start = __exec_time();
   session->execute();
+  elapsed = __exec_time() - start;
+  queue->deficit += charge - elapsed;
+  charge = queue->cost.load(std::memory_order_relaxed);
+  queue->cost.store(charge + (elapsed - charge) / 8, std::memory_order_relaxed);
   session->handle(ES_STATE_FINISHED, 0);
 }
 
 void Executor::executor_cancel(const struct thrdpool_task *task) {
-  ExecQueue *queue = (ExecQueue *)task->context;
+  Executor *executor = (Executor *)task->context;
   struct ExecSessionEntry *entry;
-  struct list_head *pos, *tmp;
   ExecSession *session;
+  ExecQueue *queue;
+  int prio;
+
+  while (1) {
+    entry = NULL;
+    pthread_mutex_lock(&executor->mutex);
+    for (prio = 0; prio < EXEC_PRIORITY_MAX; prio++) {
+      if (executor->nactive[prio] != 0) {
+        queue = list_entry(executor->active[prio].next, ExecQueue, list);
+        entry = list_entry(queue->session_list.next, struct ExecSessionEntry,
+                           list);
+        list_del(&entry->list);
+        queue->stats.depth--;
+        if (list_empty(&queue->session_list)) {
+          list_del(&queue->list);
+          executor->nactive[prio]--;
+        }
+
+        break;
+      }
+    }
+
+    pthread_mutex_unlock(&executor->mutex);
+    if (!entry)
+      break;
 
-  list_for_each_safe(pos, tmp, &queue->session_list) {
-    entry = list_entry(pos, struct ExecSessionEntry, list);
-    list_del(pos);
     session = entry->session;
     free(entry);
-
     session->handle(ES_STATE_CANCELED, 0);
   }
 }
 
 int Executor::request(ExecSession *session, ExecQueue *queue) {
   struct ExecSessionEntry *entry;
+  int timeout;
 
   session->queue = queue;
   entry = (struct ExecSessionEntry *)malloc(sizeof(struct ExecSessionEntry));
   if (entry) {
+    timeout = session->queue_timeout();
     entry->session = session;
-    entry->thrdpool = this->thrdpool;
-    pthread_mutex_lock(&queue->mutex);
+    entry->enqueue = __exec_time();
+    if (timeout >= 0)
+      entry->deadline = entry->enqueue + timeout * 1000000LL;
+    else
+      entry->deadline = 0;
+
+    pthread_mutex_lock(&this->mutex);
     list_add_tail(&entry->list, &queue->session_list);
     if (queue->session_list.next == &entry->list) {
       struct thrdpool_task task = {.routine = Executor::executor_thread_routine,
-                                   .context = queue};
+                                   .context = this};
       if (thrdpool_schedule(&task, this->thrdpool) < 0) {
         list_del(&entry->list);
         free(entry);
         entry = NULL;
+      } else {
+        //*空闲时不攒额度,但还没扣完的执行时间要留着
+        if (queue->deficit.load(std::memory_order_relaxed) > 0)
+          queue->deficit = 0;
+
+        list_add_tail(&queue->list, &this->active[queue->priority]);
+        this->nactive[queue->priority]++;
       }
     }
 
-    pthread_mutex_unlock(&queue->mutex);
+    if (entry) {
+      queue->stats.depth++;
+      queue->stats.requests++;
+    }
+
+    pthread_mutex_unlock(&this->mutex);
   }
 
   return -!entry;
@@ -124,3 +277,39 @@ int Executor::increase_thread() { return thrdpool_increase(this->thrdpool); }
 
 //*减少线程池线程数量
 int Executor::decrease_thread() { return thrdpool_decrease(this->thrdpool); }
+
+int Executor::set_queue_weight(ExecQueue *queue, unsigned int weight) {
+  if (weight == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&this->mutex);
+  queue->weight = weight;
+  pthread_mutex_unlock(&this->mutex);
+  return 0;
+}
+
+int Executor::set_queue_priority(ExecQueue *queue, int priority) {
+  if (priority < 0 || priority >= EXEC_PRIORITY_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&this->mutex);
+  if (!list_empty(&queue->session_list)) {
+    list_move_tail(&queue->list, &this->active[priority]);
+    this->nactive[queue->priority]--;
+    this->nactive[priority]++;
+  }
+
+  queue->priority = priority;
+  pthread_mutex_unlock(&this->mutex);
+  return 0;
+}
+
+void Executor::get_queue_stats(ExecQueue *queue, struct ExecQueueStats *stats) {
+  pthread_mutex_lock(&this->mutex);
+  *stats = queue->stats;
+  pthread_mutex_unlock(&this->mutex);
+}
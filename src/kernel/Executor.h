@@ -1,12 +1,31 @@
-
 #ifndef _EXECUTOR_H_
 #define _EXECUTOR_H_
 
 #include "list.h"
+#include <atomic>
 #include <pthread.h>
 #include <stddef.h>
 
-//*执行队列
+//*优先级类:高优先级的队列有session时,低优先级的队列不会被调度
+#define EXEC_PRIORITY_HIGH 0
+#define EXEC_PRIORITY_NORMAL 1
+#define EXEC_PRIORITY_LOW 2
+#define EXEC_PRIORITY_MAX 3
+
+//*同一优先级内按权重做deficit round robin,一个权重对应的execute()时间
+#define EXEC_QUANTUM_NSEC 100000LL
+
+//*队列统计,时间都是纳秒
+struct ExecQueueStats {
+  size_t depth;                  //*正在排队的session数
+  unsigned long long requests;   //*累计请求数
+  unsigned long long executed;   //*累计出队执行数
+  unsigned long long wait_total; //*出队session的排队时间之和
+  unsigned long long wait_max;   //*最长的一次排队时间
+  unsigned long long expired;    //*出队时已超过queue_timeout(),没有执行就丢掉的数量
+};
+
+//*执行队列.一个队列只交给一个Executor,状态由那个Executor的锁保护
 class ExecQueue {
 public:
   int init();
@@ -14,7 +33,12 @@ public:
 
 private:
   struct list_head session_list; //*会话队列
-  pthread_mutex_t mutex;
+  struct list_head list;         //*在Executor同优先级的活跃环里的位置
+  int priority;
+  unsigned int weight;
+  std::atomic<long long> deficit; //*出队时先扣cost,执行完按实际时间找补
+  std::atomic<long long> cost;    //*execute()时间的滑动平均,出队时预扣
+  struct ExecQueueStats stats;
 
 public:
   virtual ~ExecQueue() {}
@@ -30,6 +54,10 @@ private:
   virtual void execute() = 0;
   virtual void handle(int state, int error) = 0;
 
+  //*request()之后排队超过这么多毫秒,出队时就不再execute(),
+  //*直接以ES_STATE_CANCELED和ETIMEDOUT调用handle().-1表示不限
+  virtual int queue_timeout() { return -1; }
+
 protected:
   ExecQueue *get_queue() const { return this->queue; } //*获得队列
 
@@ -52,10 +80,20 @@ public:
   int increase_thread();
   int decrease_thread();
 
+public:
+  //*默认权重1,优先级EXEC_PRIORITY_NORMAL.队列正在排队时修改也立即生效
+  int set_queue_weight(ExecQueue *queue, unsigned int weight);
+  int set_queue_priority(ExecQueue *queue, int priority);
+  void get_queue_stats(ExecQueue *queue, struct ExecQueueStats *stats);
+
 private:
   struct __thrdpool *thrdpool;
+  pthread_mutex_t mutex;
+  struct list_head active[EXEC_PRIORITY_MAX]; //*各优先级有session的队列
+  size_t nactive[EXEC_PRIORITY_MAX];
 
 private:
+  ExecQueue *pick_queue();
   static void executor_thread_routine(void *context);
   static void executor_cancel(const struct thrdpool_task *task);
 
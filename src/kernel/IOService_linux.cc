@@ -2,7 +2,11 @@
 
 #include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <unistd.h>
 #include <string.h>
@@ -160,72 +164,247 @@ static inline void io_set_eventfd(struct iocb *iocb, int eventfd)
 	iocb->u.c.resfd = eventfd;
 }
 
-void IOSession::prep_pread(int fd, void *buf, size_t count, long long offset)
+/* io_uring, without liburing */
+
+static inline int io_uring_setup(unsigned entries, struct io_uring_params *p)
 {
-	struct iocb *iocb = (struct iocb *)this->iocb_buf;
+	return syscall(__NR_io_uring_setup, entries, p);
+}
 
-	memset(iocb, 0, sizeof(*iocb));
-	iocb->aio_fildes = fd;
-	iocb->aio_lio_opcode = IO_CMD_PREAD;
-	iocb->u.c.buf = buf;
-	iocb->u.c.nbytes = count;
-	iocb->u.c.offset = offset;
+static inline int io_uring_enter(int fd, unsigned to_submit,
+								 unsigned min_complete, unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+				   NULL, 0);
 }
 
-void IOSession::prep_pwrite(int fd, void *buf, size_t count, long long offset)
+static inline int io_uring_register(int fd, unsigned opcode, const void *arg,
+									unsigned nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+struct __io_ring
+{
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned sq_mask;
+	unsigned sq_entries;
+	struct io_uring_sqe *sqes;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr;
+	void *cq_ptr;
+	size_t sq_size;
+	size_t cq_size;
+	int event_fd;
+	int fd;
+};
+
+static int __io_ring_map(struct io_uring_params *params, struct __io_ring *ring)
+{
+	size_t sqes_size = params->sq_entries * sizeof (struct io_uring_sqe);
+	unsigned *array;
+	char *sq, *cq;
+	unsigned i;
+
+	ring->sq_size = params->sq_off.array + params->sq_entries * sizeof (unsigned);
+	ring->cq_size = params->cq_off.cqes +
+					params->cq_entries * sizeof (struct io_uring_cqe);
+	if (params->features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (ring->cq_size > ring->sq_size)
+			ring->sq_size = ring->cq_size;
+	}
+
+	sq = (char *)mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (sq == MAP_FAILED)
+		return -1;
+
+	cq = sq;
+	if (!(params->features & IORING_FEAT_SINGLE_MMAP))
+	{
+		cq = (char *)mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+						  MAP_SHARED | MAP_POPULATE, ring->fd,
+						  IORING_OFF_CQ_RING);
+		if (cq == MAP_FAILED)
+		{
+			munmap(sq, ring->sq_size);
+			return -1;
+		}
+	}
+
+	ring->sqes = (struct io_uring_sqe *)mmap(NULL, sqes_size,
+											 PROT_READ | PROT_WRITE,
+											 MAP_SHARED | MAP_POPULATE,
+											 ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+	{
+		if (cq != sq)
+			munmap(cq, ring->cq_size);
+
+		munmap(sq, ring->sq_size);
+		return -1;
+	}
+
+	ring->sq_ptr = sq;
+	ring->cq_ptr = cq;
+	ring->sq_head = (unsigned *)(sq + params->sq_off.head);
+	ring->sq_tail = (unsigned *)(sq + params->sq_off.tail);
+	ring->sq_mask = *(unsigned *)(sq + params->sq_off.ring_mask);
+	ring->sq_entries = params->sq_entries;
+	ring->cq_head = (unsigned *)(cq + params->cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params->cq_off.tail);
+	ring->cq_mask = *(unsigned *)(cq + params->cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params->cq_off.cqes);
+
+	/* SQEs are used in ring order, so the index array never changes. */
+	array = (unsigned *)(sq + params->sq_off.array);
+	for (i = 0; i < params->sq_entries; i++)
+		array[i] = i;
+
+	return 0;
+}
+
+static void __io_ring_unmap(struct __io_ring *ring)
 {
-	struct iocb *iocb = (struct iocb *)this->iocb_buf;
+	munmap(ring->sqes, ring->sq_entries * sizeof (struct io_uring_sqe));
+	if (ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+
+	munmap(ring->sq_ptr, ring->sq_size);
+}
+
+static struct __io_ring *__io_ring_create(unsigned entries)
+{
+	struct __io_ring *ring;
+	struct io_uring_params params;
+
+	ring = (struct __io_ring *)malloc(sizeof (struct __io_ring));
+	if (!ring)
+		return NULL;
 
-	memset(iocb, 0, sizeof(*iocb));
-	iocb->aio_fildes = fd;
-	iocb->aio_lio_opcode = IO_CMD_PWRITE;
-	iocb->u.c.buf = buf;
-	iocb->u.c.nbytes = count;
-	iocb->u.c.offset = offset;
+	memset(&params, 0, sizeof params);
+	params.flags = IORING_SETUP_CLAMP;
+	ring->fd = io_uring_setup(entries, &params);
+	if (ring->fd >= 0)
+	{
+		/* IORING_OP_READ and IORING_OP_WRITE came with this. */
+		if (!(params.features & IORING_FEAT_RW_CUR_POS))
+			errno = ENOSYS;
+		else if (__io_ring_map(&params, ring) >= 0)
+		{
+			ring->event_fd = -1;
+			return ring;
+		}
+
+		close(ring->fd);
+	}
+
+	free(ring);
+	return NULL;
+}
+
+static void __io_ring_destroy(struct __io_ring *ring)
+{
+	__io_ring_unmap(ring);
+	close(ring->fd);
+	free(ring);
+}
+
+enum
+{
+	IOS_OP_PREAD,
+	IOS_OP_PWRITE,
+	IOS_OP_PREADV,
+	IOS_OP_PWRITEV,
+	IOS_OP_FSYNC,
+	IOS_OP_FDSYNC,
+	IOS_OP_READ_FIXED,
+	IOS_OP_WRITE_FIXED,
+};
+
+void IOSession::prep_pread(int fd, void *buf, size_t count, long long offset)
+{
+	this->fd = fd;
+	this->op = IOS_OP_PREAD;
+	this->buf = buf;
+	this->count = count;
+	this->offset = offset;
+	this->fixed_file = 0;
+}
+
+void IOSession::prep_pwrite(int fd, void *buf, size_t count, long long offset)
+{
+	this->fd = fd;
+	this->op = IOS_OP_PWRITE;
+	this->buf = buf;
+	this->count = count;
+	this->offset = offset;
+	this->fixed_file = 0;
 }
 
 void IOSession::prep_preadv(int fd, const struct iovec *iov, int iovcnt,
 							long long offset)
 {
-	struct iocb *iocb = (struct iocb *)this->iocb_buf;
-
-	memset(iocb, 0, sizeof(*iocb));
-	iocb->aio_fildes = fd;
-	iocb->aio_lio_opcode = IO_CMD_PREADV;
-	iocb->u.c.buf = (void *)iov;
-	iocb->u.c.nbytes = iovcnt;
-	iocb->u.c.offset = offset;
+	this->fd = fd;
+	this->op = IOS_OP_PREADV;
+	this->buf = (void *)iov;
+	this->count = iovcnt;
+	this->offset = offset;
+	this->fixed_file = 0;
 }
 
 void IOSession::prep_pwritev(int fd, const struct iovec *iov, int iovcnt,
 							 long long offset)
 {
-	struct iocb *iocb = (struct iocb *)this->iocb_buf;
-
-	memset(iocb, 0, sizeof(*iocb));
-	iocb->aio_fildes = fd;
-	iocb->aio_lio_opcode = IO_CMD_PWRITEV;
-	iocb->u.c.buf = (void *)iov;
-	iocb->u.c.nbytes = iovcnt;
-	iocb->u.c.offset = offset;
+	this->fd = fd;
+	this->op = IOS_OP_PWRITEV;
+	this->buf = (void *)iov;
+	this->count = iovcnt;
+	this->offset = offset;
+	this->fixed_file = 0;
 }
 
 void IOSession::prep_fsync(int fd)
 {
-	struct iocb *iocb = (struct iocb *)this->iocb_buf;
-
-	memset(iocb, 0, sizeof(*iocb));
-	iocb->aio_fildes = fd;
-	iocb->aio_lio_opcode = IO_CMD_FSYNC;
+	this->fd = fd;
+	this->op = IOS_OP_FSYNC;
+	this->fixed_file = 0;
 }
 
 void IOSession::prep_fdsync(int fd)
 {
-	struct iocb *iocb = (struct iocb *)this->iocb_buf;
+	this->fd = fd;
+	this->op = IOS_OP_FDSYNC;
+	this->fixed_file = 0;
+}
+
+void IOSession::prep_read_fixed(int fd, void *buf, size_t count,
+								long long offset, int buf_index)
+{
+	this->fd = fd;
+	this->op = IOS_OP_READ_FIXED;
+	this->buf = buf;
+	this->count = count;
+	this->offset = offset;
+	this->buf_index = buf_index;
+	this->fixed_file = 0;
+}
 
-	memset(iocb, 0, sizeof(*iocb));
-	iocb->aio_fildes = fd;
-	iocb->aio_lio_opcode = IO_CMD_FDSYNC;
+void IOSession::prep_write_fixed(int fd, void *buf, size_t count,
+								 long long offset, int buf_index)
+{
+	this->fd = fd;
+	this->op = IOS_OP_WRITE_FIXED;
+	this->buf = buf;
+	this->count = count;
+	this->offset = offset;
+	this->buf_index = buf_index;
+	this->fixed_file = 0;
 }
 
 int IOService::init(int maxevents)
@@ -239,27 +418,123 @@ int IOService::init(int maxevents)
 	}
 
 	this->io_ctx = NULL;
-	if (io_setup(maxevents, &this->io_ctx) >= 0)
+	this->ring = __io_ring_create(maxevents > 0 ? maxevents : 1);
+	if (this->ring)
 	{
-		ret = pthread_mutex_init(&this->mutex, NULL);
-		if (ret == 0)
-		{
-			INIT_LIST_HEAD(&this->session_list);
-			this->event_fd = -1;
-			return 0;
-		}
+		/* Never more in flight than SQEs, so the SQ ring is never full
+		 * and the CQ ring, twice as large, never overflows. */
+		if ((unsigned)maxevents > this->ring->sq_entries)
+			maxevents = this->ring->sq_entries;
+	}
+	else if (io_setup(maxevents, &this->io_ctx) < 0)
+		return -1;
 
-		errno = ret;
-		io_destroy(this->io_ctx);
+	ret = pthread_mutex_init(&this->mutex, NULL);
+	if (ret == 0)
+	{
+		INIT_LIST_HEAD(&this->session_list);
+		this->maxevents = maxevents;
+		this->nevents = 0;
+		this->submitting = 0;
+		this->pending = NULL;
+		this->pending_tail = &this->pending;
+		this->failed = NULL;
+		this->files = NULL;
+		this->nfiles = 0;
+		this->event_fd = -1;
+		return 0;
 	}
 
+	errno = ret;
+	if (this->ring)
+		__io_ring_destroy(this->ring);
+	else
+		io_destroy(this->io_ctx);
+
 	return -1;
 }
 
 void IOService::deinit()
 {
 	pthread_mutex_destroy(&this->mutex);
-	io_destroy(this->io_ctx);
+	free(this->files);
+	if (this->ring)
+		__io_ring_destroy(this->ring);
+	else
+		io_destroy(this->io_ctx);
+}
+
+int IOService::register_buffers(const struct iovec *iov, int n)
+{
+	if (this->ring)
+	{
+		if (io_uring_register(this->ring->fd, IORING_REGISTER_BUFFERS,
+							  iov, n) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+int IOService::register_files(const int *fds, int n)
+{
+	if (this->ring)
+	{
+		if (io_uring_register(this->ring->fd, IORING_REGISTER_FILES,
+							  fds, n) < 0)
+			return -1;
+	}
+	else
+	{
+		this->files = (int *)malloc(n * sizeof (int));
+		if (!this->files)
+			return -1;
+
+		memcpy(this->files, fds, n * sizeof (int));
+		this->nfiles = n;
+	}
+
+	return 0;
+}
+
+#define IOS_DEFERRED_MAX	4
+
+static __thread int __defer_requests;
+static __thread int __deferred_count;
+static __thread IOService *__deferred[IOS_DEFERRED_MAX];
+
+static int __defer_service(IOService *service)
+{
+	int i;
+
+	if (!__defer_requests)
+		return 0;
+
+	for (i = 0; i < __deferred_count; i++)
+	{
+		if (__deferred[i] == service)
+			return 1;
+	}
+
+	if (__deferred_count == IOS_DEFERRED_MAX)
+		return 0;
+
+	__deferred[__deferred_count++] = service;
+	return 1;
+}
+
+static void __undefer_service(IOService *service)
+{
+	int i;
+
+	for (i = 0; i < __deferred_count; i++)
+	{
+		if (__deferred[i] == service)
+		{
+			__deferred[i] = __deferred[--__deferred_count];
+			break;
+		}
+	}
 }
 
 inline void IOService::incref()
@@ -270,18 +545,26 @@ inline void IOService::incref()
 void IOService::decref()
 {
 	IOSession *session;
-	struct io_event event;
+	IOSession *next;
 	int state, error;
+	int wait;
 
 	if (__sync_sub_and_fetch(&this->ref, 1) == 0)
 	{
+		/* Requests deferred by this thread have to be submitted before
+		 * waiting for them, and the service must not be flushed again
+		 * after handle_unbound(). */
+		this->flush();
+		__undefer_service(this);
 		while (!list_empty(&this->session_list))
 		{
-			if (io_getevents(this->io_ctx, 1, 1, &event, NULL) > 0)
+			pthread_mutex_lock(&this->mutex);
+			wait = !this->failed;
+			pthread_mutex_unlock(&this->mutex);
+			session = this->get_events(wait);
+			while (session)
 			{
-				session = (IOSession *)event.data;
-				list_del(&session->list);
-				session->res = event.res;
+				next = session->next;
 				if (session->res >= 0)
 				{
 					state = IOS_STATE_SUCCESS;
@@ -294,6 +577,7 @@ void IOService::decref()
 				}
 
 				session->handle(state, error);
+				session = next;
 			}
 		}
 
@@ -301,9 +585,224 @@ void IOService::decref()
 	}
 }
 
+/* Linux never reads or writes more than this at a time. */
+#define IOS_RW_COUNT_MAX	0x7ffff000
+
+void IOService::prep_sqe(IOSession *session)
+{
+	struct __io_ring *ring = this->ring;
+	unsigned tail = *ring->sq_tail;
+	struct io_uring_sqe *sqe = &ring->sqes[tail & ring->sq_mask];
+	size_t count = session->count;
+
+	if (count > IOS_RW_COUNT_MAX)
+		count = IOS_RW_COUNT_MAX;
+
+	memset(sqe, 0, sizeof (struct io_uring_sqe));
+	sqe->fd = session->fd;
+	sqe->addr = (uintptr_t)session->buf;
+	sqe->len = count;
+	sqe->off = session->offset;
+	sqe->user_data = (uintptr_t)session;
+	switch (session->op)
+	{
+	case IOS_OP_PREAD:
+		sqe->opcode = IORING_OP_READ;
+		break;
+	case IOS_OP_PWRITE:
+		sqe->opcode = IORING_OP_WRITE;
+		break;
+	case IOS_OP_PREADV:
+		sqe->opcode = IORING_OP_READV;
+		break;
+	case IOS_OP_PWRITEV:
+		sqe->opcode = IORING_OP_WRITEV;
+		break;
+	case IOS_OP_FSYNC:
+	case IOS_OP_FDSYNC:
+		sqe->opcode = IORING_OP_FSYNC;
+		sqe->addr = 0;
+		sqe->len = 0;
+		sqe->off = 0;
+		if (session->op == IOS_OP_FDSYNC)
+			sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+		break;
+	case IOS_OP_READ_FIXED:
+		sqe->opcode = IORING_OP_READ_FIXED;
+		sqe->buf_index = session->buf_index;
+		break;
+	case IOS_OP_WRITE_FIXED:
+		sqe->opcode = IORING_OP_WRITE_FIXED;
+		sqe->buf_index = session->buf_index;
+		break;
+	}
+
+	if (session->fixed_file)
+		sqe->flags = IOSQE_FIXED_FILE;
+
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+void IOService::prep_iocb(IOSession *session, struct iocb *iocb)
+{
+	/* In the order of IOS_OP_, fixed buffers are plain ones here. */
+	static const short opcodes[] = {
+		IO_CMD_PREAD, IO_CMD_PWRITE, IO_CMD_PREADV, IO_CMD_PWRITEV,
+		IO_CMD_FSYNC, IO_CMD_FDSYNC, IO_CMD_PREAD, IO_CMD_PWRITE,
+	};
+	size_t count = session->count;
+
+	if (count > IOS_RW_COUNT_MAX)
+		count = IOS_RW_COUNT_MAX;
+
+	memset(iocb, 0, sizeof (struct iocb));
+	iocb->aio_fildes = session->fixed_file ? this->files[session->fd] :
+											 session->fd;
+	iocb->aio_lio_opcode = opcodes[session->op];
+	if (session->op != IOS_OP_FSYNC && session->op != IOS_OP_FDSYNC)
+	{
+		iocb->u.c.buf = session->buf;
+		iocb->u.c.nbytes = count;
+		iocb->u.c.offset = session->offset;
+	}
+
+	/* Flushed after the service is unbound, reaped by decref(). */
+	if (this->event_fd >= 0)
+		io_set_eventfd(iocb, this->event_fd);
+
+	iocb->data = session;
+}
+
+/* A session accepted but not submitted finishes with the error, through the
+ * eventfd, as if it had been submitted. */
+void IOService::fail(IOSession *session, int error)
+{
+	session->res = -error;
+	session->next = this->failed;
+	this->failed = session;
+	if (this->event_fd >= 0)
+		eventfd_write(this->event_fd, 1);
+}
+
+/* One thread at a time submits every SQE queued, also those queued by other
+ * threads meanwhile, so a burst of requests costs few io_uring_enter(). If
+ * the ring fails, the sessions not submitted finish with the error. */
+void IOService::submit_sqes()
+{
+	struct __io_ring *ring = this->ring;
+	IOSession *session;
+	unsigned head, tail;
+	int ret, error;
+
+	while (1)
+	{
+		ret = io_uring_enter(ring->fd, ring->sq_entries, 0, 0);
+		error = errno;
+		pthread_mutex_lock(&this->mutex);
+		head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+		tail = *ring->sq_tail;
+		if (ret < 0 && error != EINTR && head != tail)
+		{
+			__atomic_store_n(ring->sq_tail, head, __ATOMIC_RELEASE);
+			do
+			{
+				session = (IOSession *)ring->sqes[head & ring->sq_mask].user_data;
+				this->fail(session, error);
+			} while (++head != tail);
+		}
+
+		if (head == tail)
+			break;
+
+		pthread_mutex_unlock(&this->mutex);
+	}
+
+	this->submitting = 0;
+	pthread_mutex_unlock(&this->mutex);
+}
+
+#define IOS_SUBMIT_MAX		64
+
+/* Native aio: every session pending, IOS_SUBMIT_MAX iocbs an io_submit(). */
+void IOService::submit_iocbs()
+{
+	struct iocb iocbs[IOS_SUBMIT_MAX];
+	struct iocb *iocbps[IOS_SUBMIT_MAX];
+	IOSession *session;
+	int i, n, ret;
+
+	pthread_mutex_lock(&this->mutex);
+	session = this->pending;
+	this->pending = NULL;
+	this->pending_tail = &this->pending;
+	pthread_mutex_unlock(&this->mutex);
+
+	while (session)
+	{
+		for (n = 0; session && n < IOS_SUBMIT_MAX; n++)
+		{
+			this->prep_iocb(session, &iocbs[n]);
+			iocbps[n] = &iocbs[n];
+			session = session->next;
+		}
+
+		/* io_submit() stops at the first iocb it fails on. */
+		i = 0;
+		while (i < n)
+		{
+			ret = io_submit(this->io_ctx, n - i, iocbps + i);
+			if (ret > 0)
+				i += ret;
+			else
+			{
+				pthread_mutex_lock(&this->mutex);
+				this->fail((IOSession *)iocbs[i].data, ret < 0 ? errno : EAGAIN);
+				pthread_mutex_unlock(&this->mutex);
+				i++;
+			}
+		}
+	}
+}
+
+void IOService::flush()
+{
+	struct __io_ring *ring = this->ring;
+	int submit = 0;
+
+	if (ring)
+	{
+		pthread_mutex_lock(&this->mutex);
+		if (!this->submitting && *ring->sq_tail != *ring->sq_head)
+		{
+			this->submitting = 1;
+			submit = 1;
+		}
+
+		pthread_mutex_unlock(&this->mutex);
+		if (submit)
+			this->submit_sqes();
+	}
+	else
+		this->submit_iocbs();
+}
+
+void IOService::defer_requests()
+{
+	__defer_requests = 1;
+}
+
+void IOService::flush_deferred()
+{
+	int i;
+
+	for (i = 0; i < __deferred_count; i++)
+		__deferred[i]->flush();
+
+	__deferred_count = 0;
+}
+
 int IOService::request(IOSession *session)
 {
-	struct iocb *iocb = (struct iocb *)session->iocb_buf;
 	int ret = -1;
 
 	pthread_mutex_lock(&this->mutex);
@@ -311,36 +810,125 @@ int IOService::request(IOSession *session)
 		errno = ENOENT;
 	else if (session->prepare() >= 0)
 	{
-		io_set_eventfd(iocb, this->event_fd);
-		iocb->data = session;
-		if (io_submit(this->io_ctx, 1, &iocb) > 0)
+		if (this->ring)
 		{
-			list_add_tail(&session->list, &this->session_list);
+			if (this->nevents >= this->maxevents)
+				errno = EAGAIN;
+			else if (this->ring->event_fd == this->event_fd ||
+					 io_uring_register(this->ring->fd,
+									   IORING_REGISTER_EVENTFD,
+									   &this->event_fd, 1) >= 0)
+			{
+				this->ring->event_fd = this->event_fd;
+				this->prep_sqe(session);
+				ret = 0;
+			}
+		}
+		else if (session->fixed_file &&
+				 (session->fd < 0 || session->fd >= this->nfiles))
+			errno = EBADF;
+		else
+		{
+			session->next = NULL;
+			*this->pending_tail = session;
+			this->pending_tail = &session->next;
 			ret = 0;
 		}
+
+		if (ret == 0)
+		{
+			list_add_tail(&session->list, &this->session_list);
+			this->nevents++;
+		}
 	}
 
 	pthread_mutex_unlock(&this->mutex);
 	if (ret < 0)
+	{
 		session->res = -errno;
+		return -1;
+	}
 
-	return ret;
+	if (!__defer_service(this))
+		this->flush();
+
+	return 0;
+}
+
+#define IOS_EVENTS_MAX		64
+
+/* Takes finished sessions off the session list, chained by 'next'. With
+ * io_uring these are all the CQEs there, since the eventfd is not signalled
+ * once for every CQE, and with native aio up to IOS_EVENTS_MAX events. */
+IOSession *IOService::get_events(int wait)
+{
+	struct __io_ring *ring = this->ring;
+	struct io_event events[IOS_EVENTS_MAX];
+	struct timespec timeout = { };
+	IOSession *head = NULL;
+	IOSession **next = &head;
+	IOSession *session;
+	struct io_uring_cqe *cqe;
+	unsigned cq_head, cq_tail;
+	int i, n;
+
+	if (ring)
+	{
+		if (wait)
+			io_uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+
+		cq_head = *ring->cq_head;
+		cq_tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+		while (cq_head != cq_tail)
+		{
+			cqe = &ring->cqes[cq_head & ring->cq_mask];
+			session = (IOSession *)cqe->user_data;
+			session->res = cqe->res;
+			*next = session;
+			next = &session->next;
+			cq_head++;
+		}
+
+		__atomic_store_n(ring->cq_head, cq_head, __ATOMIC_RELEASE);
+	}
+	else
+	{
+		n = io_getevents(this->io_ctx, wait, IOS_EVENTS_MAX, events,
+						 wait ? NULL : &timeout);
+		for (i = 0; i < n; i++)
+		{
+			session = (IOSession *)events[i].data;
+			session->res = events[i].res;
+			*next = session;
+			next = &session->next;
+		}
+	}
+
+	pthread_mutex_lock(&this->mutex);
+	*next = this->failed;
+	this->failed = NULL;
+	for (session = head; session; session = session->next)
+	{
+		list_del(&session->list);
+		this->nevents--;
+	}
+
+	pthread_mutex_unlock(&this->mutex);
+	return head;
 }
 
 void *IOService::aio_finish(void *context)
 {
 	IOService *service = (IOService *)context;
-	IOSession *session;
-	struct io_event event;
+	IOSession *session = service->get_events(0);
 
-	if (io_getevents(service->io_ctx, 1, 1, &event, NULL) > 0)
+	if (session)
 	{
 		service->incref();
-		session = (IOSession *)event.data;
-		session->res = event.res;
 		return session;
 	}
 
-	return NULL;
+	/* The events of this eventfd count were taken with an earlier one.
+	 * Returning NULL would make the poller put the count back. */
+	return service;
 }
-
@@ -37,15 +37,33 @@ protected:
 	void prep_fsync(int fd);
 	void prep_fdsync(int fd);
 
+	/* 'buf' has to be in the buffer 'buf_index' registered by
+	 * IOService::register_buffers(). */
+	void prep_read_fixed(int fd, void *buf, size_t count, long long offset,
+						 int buf_index);
+	void prep_write_fixed(int fd, void *buf, size_t count, long long offset,
+						  int buf_index);
+
+	/* Called after a prep_ function, 'fd' is the index of a file registered
+	 * by IOService::register_files(). */
+	void use_fixed_file() { this->fixed_file = 1; }
+
 protected:
 	long get_res() const { return this->res; }
 
 private:
-	char iocb_buf[64];
+	int fd;
+	int op;
+	void *buf;
+	size_t count;
+	long long offset;
+	int buf_index;
+	int fixed_file;
 	long res;
 
 private:
 	struct list_head list;
+	IOSession *next;
 
 public:
 	virtual ~IOSession() { }
@@ -53,6 +71,10 @@ public:
 	friend class Communicator;
 };
 
+/* Runs on io_uring, which also makes buffered IO asynchronous. Falls back to
+ * the Linux native aio when the kernel has no io_uring (before 5.6).
+ * Requests made in a handler callback are submitted when it returns, so a
+ * callback must not wait for its own file IO. */
 class IOService
 {
 public:
@@ -61,6 +83,12 @@ public:
 
 	int request(IOSession *session);
 
+public:
+	/* Once, before any request. Without io_uring, registered buffers are
+	 * plain buffers and file indexes are mapped to the fds here. */
+	int register_buffers(const struct iovec *iov, int n);
+	int register_files(const int *fds, int n);
+
 private:
 	virtual void handle_stop(int error) { }
 	virtual void handle_unbound() = 0;
@@ -73,11 +101,40 @@ private:
 
 private:
 	struct io_context *io_ctx;
+	struct __io_ring *ring;
+	int maxevents;
+	int nevents;
+	int submitting;
+	IOSession *pending;
+	IOSession **pending_tail;
+	IOSession *failed;
+	int *files;
+	int nfiles;
 
 private:
 	void incref();
 	void decref();
 
+private:
+	void prep_sqe(IOSession *session);
+	void prep_iocb(IOSession *session, struct iocb *iocb);
+	void submit_sqes();
+	void submit_iocbs();
+	void flush();
+	void fail(IOSession *session, int error);
+	IOSession *get_events(int wait);
+
+public:
+	/* In a handler thread, requests are submitted together when the
+	 * callback returns. A callback that waits for its own file IO to
+	 * finish must call this first, or the IO is never submitted and the
+	 * wait never ends. */
+	static void flush_deferred();
+
+private:
+	/* Called by the Communicator for its handler threads. */
+	static void defer_requests();
+
 private:
 	int event_fd;
 	int ref;
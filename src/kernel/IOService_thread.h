@@ -71,6 +71,13 @@ private:
 	int maxevents;
 	int nevents;
 
+public:
+	/* Requests are never deferred by this implementation. */
+	static void flush_deferred() { }
+
+private:
+	static void defer_requests() { }
+
 private:
 	void incref();
 	void decref();
@@ -23,7 +23,12 @@
 
 class ParallelTask;
 
-class SubTask {
+//*task在所属SeriesWork队列里的链接,SeriesWork入队不需要再分配
+struct SubTaskLink {
+  SubTaskLink *series_next;
+};
+
+class SubTask : private SubTaskLink {
 public:
   virtual void dispatch() = 0;
 
@@ -49,6 +54,7 @@ public:
 
   virtual ~SubTask() {}
   friend class ParallelTask;
+  friend class SeriesWork;
 };
 
 class ParallelTask : public SubTask {
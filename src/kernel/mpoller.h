@@ -60,7 +60,7 @@ static inline int mpoller_add_timer(const struct timespec *value, void *context,
 									mpoller_t *mpoller)
 {
 	static unsigned int n = 0;
-	*index = n++ % mpoller->nthreads;
+	*index = __sync_fetch_and_add(&n, 1) % mpoller->nthreads;
 	return poller_add_timer(value, context, timer, mpoller->poller[*index]);
 }
 
@@ -62,6 +62,7 @@ struct __poller {
   int pipe_rd;                                      //*读端
   int pipe_wr;                                      //*写端
   int stopped;                                      //*是否已经停止
+  long timer_slack;                                 //*定时器合并窗口(纳秒)
   struct rb_root timeo_tree;                        //*超时红黑树
   struct rb_node *tree_first;                       //*第一个超时节点
   struct rb_node *tree_last;                        //*最后一个超时节点
@@ -716,7 +717,6 @@ static void *__poller_thread_routine(void *arg) {
         break;
       case PD_OP_EVENT:
         __poller_handle_event(node, poller);
-        printf("异步io事件触发\n");
         break;
       case PD_OP_NOTIFY:
         __poller_handle_notify(node, poller);
@@ -785,6 +785,9 @@ poller_t *__poller_create(void **nodes_buf,
         poller->max_open_files = params->max_open_files;
         poller->callback = params->callback;
         poller->context = params->context;
+        poller->timer_slack = params->timer_slack;
+        if (poller->timer_slack > 1000000000)
+          poller->timer_slack = 1000000000;
 
         poller->timeo_tree.rb_node = NULL;
         poller->tree_first = NULL;
@@ -1128,6 +1131,17 @@ int poller_add_timer(const struct timespec *value, void *context, void **timer,
       node->timeout.tv_sec++;
     }
 
+    //*向上取整到timer_slack的倍数:不会提前到期,同一窗口里的定时器
+    //*到期时间相同,由timerfd的一次唤醒一起处理
+    if (poller->timer_slack > 1) {
+      node->timeout.tv_nsec += poller->timer_slack - 1;
+      node->timeout.tv_nsec -= node->timeout.tv_nsec % poller->timer_slack;
+      if (node->timeout.tv_nsec >= 1000000000) {
+        node->timeout.tv_nsec = 0;
+        node->timeout.tv_sec++;
+      }
+    }
+
     *timer = node;
     pthread_mutex_lock(&poller->mutex);
     __poller_insert_node(node, poller);
@@ -70,6 +70,7 @@ struct poller_params {
   size_t max_open_files;
   void (*callback)(struct poller_result *, void *); //*回调函数
   void *context;                                    //*上下文
+  long timer_slack; //*定时器合并窗口(纳秒),到期时间向上取整到它的倍数,0不合并
 };
 
 #ifdef __cplusplus
@@ -25,6 +25,7 @@
 #include <string>
 #include <unistd.h>
 #include <unordered_map>
+#include <vector>
 
 class __WFGlobal {
 public:
@@ -214,8 +215,8 @@ public:
 private:
   __CommManager() : fio_service_(NULL), fio_flag_(false) {
     const auto *settings = WFGlobal::get_global_settings();
-    if (scheduler_.init(settings->poller_threads, settings->handler_threads) <
-        0)
+    if (scheduler_.init(settings->poller_threads, settings->handler_threads,
+                        (long)settings->timer_slack * 1000) < 0)
       abort();
 
     signal(SIGPIPE, SIG_IGN);
@@ -266,7 +267,15 @@ inline IOService *__CommManager::get_io_service() {
 
 class __ExecManager {
 protected:
-  using ExecQueueMap = std::unordered_map<std::string, ExecQueue *>;
+  struct ExecQueueNode {
+    std::string name;
+    ExecQueue *queue;
+    const ExecQueueNode *next;
+  };
+
+  enum {
+    EXEC_QUEUE_BUCKETS = 1024,
+  };
 
 public:
   static __ExecManager *get_instance() {
@@ -278,9 +287,12 @@ public:
   Executor *get_compute_executor() { return &compute_executor_; }
 
 private:
-  __ExecManager() : rwlock_(PTHREAD_RWLOCK_INITIALIZER) {
+  __ExecManager() {
     int compute_threads = WFGlobal::get_global_settings()->compute_threads;
 
+    for (auto &bucket : buckets_)
+      bucket.store(NULL, std::memory_order_relaxed);
+
     if (compute_threads < 0)
       compute_threads = sysconf(_SC_NPROCESSORS_ONLN);
 
@@ -289,47 +301,58 @@ private:
   }
 
   ~__ExecManager() {
+    const ExecQueueNode *node;
+    const ExecQueueNode *next;
+
     compute_executor_.deinit();
 
-    for (auto &kv : queue_map_) {
-      kv.second->deinit();
-      delete kv.second;
+    for (auto &bucket : buckets_) {
+      for (node = bucket.load(std::memory_order_relaxed); node; node = next) {
+        next = node->next;
+        node->queue->deinit();
+        delete node->queue;
+        delete node;
+      }
     }
   }
 
 private:
-  pthread_rwlock_t rwlock_;
-  ExecQueueMap queue_map_;
+  //*固定个数的桶,每个桶是只增不减的链表:写者在mutex_下把新节点发布到链头,
+  //*读者不加锁沿链查找.节点发布后不再修改,也不复制,内存与队列数成正比
+  std::mutex mutex_;
+  std::atomic<const ExecQueueNode *> buckets_[EXEC_QUEUE_BUCKETS];
   Executor compute_executor_;
 };
 
 inline ExecQueue *__ExecManager::get_exec_queue(const std::string &queue_name) {
-  ExecQueue *queue = NULL;
-  ExecQueueMap::const_iterator iter;
-
-  pthread_rwlock_rdlock(&rwlock_);
-  iter = queue_map_.find(queue_name);
-  if (iter != queue_map_.cend())
-    queue = iter->second;
-
-  pthread_rwlock_unlock(&rwlock_);
-  if (queue)
-    return queue;
-
-  pthread_rwlock_wrlock(&rwlock_);
-  iter = queue_map_.find(queue_name);
-  if (iter == queue_map_.cend()) {
-    queue = new ExecQueue();
-    if (queue->init() >= 0)
-      queue_map_.emplace(queue_name, queue);
-    else {
-      delete queue;
-      queue = NULL;
-    }
-  } else
-    queue = iter->second;
+  size_t n = std::hash<std::string>()(queue_name) % EXEC_QUEUE_BUCKETS;
+  std::atomic<const ExecQueueNode *> &bucket = buckets_[n];
+  const ExecQueueNode *head = bucket.load(std::memory_order_acquire);
+  const ExecQueueNode *node;
+  ExecQueue *queue;
+
+  for (node = head; node; node = node->next) {
+    if (node->name == queue_name)
+      return node->queue;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  //*只需查看head之后新发布的节点
+  for (node = bucket.load(std::memory_order_relaxed); node != head;
+       node = node->next) {
+    if (node->name == queue_name)
+      return node->queue;
+  }
+
+  queue = new ExecQueue();
+  if (queue->init() < 0) {
+    delete queue;
+    return NULL;
+  }
 
-  pthread_rwlock_unlock(&rwlock_);
+  node = new ExecQueueNode{queue_name, queue,
+                           bucket.load(std::memory_order_relaxed)};
+  bucket.store(node, std::memory_order_release);
   return queue;
 }
 
@@ -44,6 +44,8 @@ struct WFGlobalSettings {
   int poller_threads;
   int handler_threads;
   int compute_threads; ///< auto-set by system CPU number if value<0
+  unsigned int timer_slack; ///< in microseconds, timers due in one slack window
+                            ///< wake the poller once; 0 for exact timers
   int fio_max_events;
   const char *resolv_conf_path;
   const char *hosts_path;
@@ -61,6 +63,7 @@ static constexpr struct WFGlobalSettings GLOBAL_SETTINGS_DEFAULT = {
     .poller_threads = 1,
     .handler_threads = 1,
     .compute_threads = -1,
+    .timer_slack = 50,
     .fio_max_events = 4096,
     .resolv_conf_path = "/etc/resolv.conf",
     .hosts_path = "/etc/hosts",
@@ -110,6 +113,14 @@ public:
 
   static const char *get_error_string(int state, int error);
 
+  /**
+   * @brief      resolve a compute queue by name, creating it on first use
+   * @return     the queue, valid until the library exits; NULL on failure
+   * @note       lock-free once the name exists. Keep the returned handle and
+   *             pass it to the task factories instead of the name on hot paths
+   */
+  static class ExecQueue *get_exec_queue(const std::string &queue_name);
+
   static bool increase_handler_thread() {
     return WFGlobal::get_scheduler()->increase_handler_thread() == 0;
   }
@@ -130,7 +141,6 @@ public:
 public:
   static bool is_scheduler_created();
   static class CommScheduler *get_scheduler();
-  static class ExecQueue *get_exec_queue(const std::string &queue_name);
   static class Executor *get_compute_executor();
   static class IOService *get_io_service();
   static class ExecQueue *get_dns_queue();
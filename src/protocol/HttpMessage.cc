@@ -9,37 +9,153 @@
  */
 
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <utility>
+#include "../util/crc32c.h"
 #include "HttpMessage.h"
 
 namespace protocol
 {
 
+/* 'capacity' is the room after the block header for copied data, and 0
+ * for a block by reference. */
 struct HttpMessageBlock
 {
 	struct list_head list;
 	const void *ptr;
 	size_t size;
+	size_t capacity;
 };
 
+/*
+ * Small copies are packed one after another into chunks of
+ * HTTP_OUTPUT_CHUNK_SIZE, so a body built piece by piece ends up in a few
+ * large blocks, that is, a few iovecs for encode(). Copies bigger than
+ * HTTP_OUTPUT_PACK_MAX get a block of their own. Free chunks are kept in a
+ * small per-thread slab for the next messages.
+ */
+#define HTTP_OUTPUT_CHUNK_SIZE	16384
+#define HTTP_OUTPUT_PACK_MAX	4096
+#define HTTP_OUTPUT_SLAB_MAX	16
+
+/* 1 while the slab of the thread is alive, -1 once it is destroyed. Plain
+ * data, so it is still valid after the thread-local destructors have run. */
+static thread_local int __output_slab_state;
+
+class HttpOutputSlab
+{
+public:
+	HttpOutputSlab()
+	{
+		INIT_LIST_HEAD(&this->list);
+		this->count = 0;
+		__output_slab_state = 1;
+	}
+
+	~HttpOutputSlab()
+	{
+		struct list_head *pos, *tmp;
+
+		__output_slab_state = -1;
+		list_for_each_safe(pos, tmp, &this->list)
+			free(list_entry(pos, struct HttpMessageBlock, list));
+	}
+
+public:
+	struct list_head list;
+	int count;
+};
+
+static thread_local HttpOutputSlab __output_slab;
+
+/* A message filled or freed after the slab, e.g. a static one at exit,
+ * mallocs and frees its blocks directly. */
+static inline HttpOutputSlab *__get_output_slab()
+{
+	if (__output_slab_state < 0)
+		return NULL;
+
+	return &__output_slab;
+}
+
+static struct HttpMessageBlock *__alloc_block(size_t capacity)
+{
+	HttpOutputSlab *slab = __get_output_slab();
+	struct HttpMessageBlock *block;
+
+	if (capacity == HTTP_OUTPUT_CHUNK_SIZE && slab && slab->count > 0)
+	{
+		block = list_entry(slab->list.next, struct HttpMessageBlock, list);
+		list_del(&block->list);
+		slab->count--;
+	}
+	else
+	{
+		block = (struct HttpMessageBlock *)
+				malloc(sizeof (struct HttpMessageBlock) + capacity);
+		if (!block)
+			return NULL;
+	}
+
+	block->ptr = block + 1;
+	block->size = 0;
+	block->capacity = capacity;
+	return block;
+}
+
+static void __free_block(struct HttpMessageBlock *block)
+{
+	HttpOutputSlab *slab = __get_output_slab();
+
+	if (slab && block->capacity == HTTP_OUTPUT_CHUNK_SIZE &&
+		slab->count < HTTP_OUTPUT_SLAB_MAX)
+	{
+		list_add(&block->list, &slab->list);
+		slab->count++;
+	}
+	else
+		free(block);
+}
+
+/* The last block if it is a copy with room for 'size' more bytes. */
+static inline struct HttpMessageBlock *__tail_room(struct list_head *head,
+												   size_t size)
+{
+	struct HttpMessageBlock *block;
+
+	if (list_empty(head))
+		return NULL;
+
+	block = list_entry(head->prev, struct HttpMessageBlock, list);
+	if (block->capacity - block->size < size || block->capacity == 0)
+		return NULL;
+
+	return block;
+}
+
 bool HttpMessage::append_output_body(const void *buf, size_t size)
 {
-	size_t n = sizeof (struct HttpMessageBlock) + size;
-	struct HttpMessageBlock *block = (struct HttpMessageBlock *)malloc(n);
+	struct HttpMessageBlock *block = __tail_room(&this->output_body, size);
 
-	if (block)
+	if (!block)
 	{
-		memcpy(block + 1, buf, size);
-		block->ptr = block + 1;
-		block->size = size;
+		if (size <= HTTP_OUTPUT_PACK_MAX)
+			block = __alloc_block(HTTP_OUTPUT_CHUNK_SIZE);
+		else
+			block = __alloc_block(size);
+
+		if (!block)
+			return false;
+
 		list_add_tail(&block->list, &this->output_body);
-		this->output_body_size += size;
-		return true;
 	}
 
-	return false;
+	memcpy((char *)block->ptr + block->size, buf, size);
+	block->size += size;
+	this->output_body_size += size;
+	return true;
 }
 
 bool HttpMessage::append_output_body_nocopy(const void *buf, size_t size)
@@ -51,6 +167,7 @@ bool HttpMessage::append_output_body_nocopy(const void *buf, size_t size)
 	{
 		block->ptr = buf;
 		block->size = size;
+		block->capacity = 0;
 		list_add_tail(&block->list, &this->output_body);
 		this->output_body_size += size;
 		return true;
@@ -59,6 +176,45 @@ bool HttpMessage::append_output_body_nocopy(const void *buf, size_t size)
 	return false;
 }
 
+void *HttpMessage::reserve_output_body(size_t size)
+{
+	struct HttpMessageBlock *block = __tail_room(&this->output_body, size);
+
+	if (!block)
+	{
+		if (size <= HTTP_OUTPUT_CHUNK_SIZE)
+			block = __alloc_block(HTTP_OUTPUT_CHUNK_SIZE);
+		else
+			block = __alloc_block(size);
+
+		if (!block)
+			return NULL;
+
+		list_add_tail(&block->list, &this->output_body);
+	}
+
+	return (char *)block->ptr + block->size;
+}
+
+void HttpMessage::commit_output_body(size_t size)
+{
+	struct HttpMessageBlock *block;
+
+	block = list_entry(this->output_body.prev, struct HttpMessageBlock, list);
+	if (block->size == 0)
+	{
+		if (size == 0)
+		{
+			list_del(&block->list);
+			__free_block(block);
+			return;
+		}
+	}
+
+	block->size += size;
+	this->output_body_size += size;
+}
+
 size_t HttpMessage::get_output_body_blocks(const void *buf[], size_t size[],
 										   size_t max) const
 {
@@ -111,7 +267,7 @@ void HttpMessage::clear_output_body()
 	{
 		block = list_entry(pos, struct HttpMessageBlock, list);
 		list_del(pos);
-		free(block);
+		__free_block(block);
 	}
 
 	this->output_body_size = 0;
@@ -119,14 +275,12 @@ void HttpMessage::clear_output_body()
 
 struct list_head *HttpMessage::combine_from(struct list_head *pos, size_t size)
 {
-	size_t n = sizeof (struct HttpMessageBlock) + size;
-	struct HttpMessageBlock *block = (struct HttpMessageBlock *)malloc(n);
+	struct HttpMessageBlock *block = __alloc_block(size);
 	struct HttpMessageBlock *entry;
 	char *ptr;
 
 	if (block)
 	{
-		block->ptr = block + 1;
 		block->size = size;
 		ptr = (char *)block->ptr;
 
@@ -137,7 +291,7 @@ struct list_head *HttpMessage::combine_from(struct list_head *pos, size_t size)
 			list_del(&entry->list);
 			memcpy(ptr, entry->ptr, entry->size);
 			ptr += entry->size;
-			free(entry);
+			__free_block(entry);
 		} while (pos != &this->output_body);
 
 		list_add_tail(&block->list, &this->output_body);
@@ -147,6 +301,39 @@ struct list_head *HttpMessage::combine_from(struct list_head *pos, size_t size)
 	return NULL;
 }
 
+int HttpMessage::set_checksum_header()
+{
+	static const char base64[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	struct HttpMessageBlock *block;
+	struct list_head *pos;
+	uint32_t crc = 0;
+	char value[32];
+	int i;
+
+	list_for_each(pos, &this->output_body)
+	{
+		block = list_entry(pos, struct HttpMessageBlock, list);
+		crc = crc32c(crc, block->ptr, block->size);
+	}
+
+	if (this->checksum_type == CHECKSUM_ETAG)
+	{
+		sprintf(value, "\"%08x\"", crc);
+		return http_parser_set_header("ETag", 4, value, 10, this->parser);
+	}
+
+	/* The 4 bytes big-endian, as a structured field byte sequence. */
+	memcpy(value, "crc32c=:", 8);
+	for (i = 0; i < 5; i++)
+		value[8 + i] = base64[(crc >> (26 - 6 * i)) & 0x3f];
+
+	value[13] = base64[(crc & 0x3) << 4];
+	memcpy(value + 14, "==:", 3);
+	return http_parser_set_header("Repr-Digest", 11, value, 17,
+								  this->parser);
+}
+
 int HttpMessage::encode(struct iovec vectors[], int max)
 {
 	const char *start_line[3];
@@ -176,6 +363,12 @@ int HttpMessage::encode(struct iovec vectors[], int max)
 		return -1;
 	}
 
+	if (this->checksum_type != CHECKSUM_NONE)
+	{
+		if (this->set_checksum_header() < 0)
+			return -1;
+	}
+
 	vectors[0].iov_base = (void *)start_line[0];
 	vectors[0].iov_len = strlen(start_line[0]);
 	vectors[1].iov_base = (void *)" ";
@@ -236,6 +429,42 @@ int HttpMessage::encode(struct iovec vectors[], int max)
 	return i;
 }
 
+/* Everything after the header not handed over yet. A chunked body ends at
+ * the data the parser has decoded, and the chunks after it are kept. */
+int HttpMessage::feed_body()
+{
+	http_parser_t *parser = this->parser;
+	char *body = (char *)parser->msgbuf + parser->header_offset;
+	size_t end = parser->chunked ? parser->dechunk_offset : parser->msgsize;
+	size_t size = end - parser->header_offset - this->body_offset;
+	size_t n;
+
+	if (size == 0)
+		return 0;
+
+	if (this->body_callback(body + this->body_offset, size) < 0)
+		return -1;
+
+	if (!this->body_discard)
+		this->body_offset += size;
+	else if (parser->chunked)
+	{
+		n = parser->chunk_offset - parser->header_offset;
+		memmove(body, body + n, parser->msgsize - parser->chunk_offset);
+		parser->msgsize -= n;
+		parser->chunk_offset = parser->header_offset;
+		parser->dechunk_offset = parser->header_offset;
+	}
+	else
+	{
+		parser->msgsize = parser->header_offset;
+		if (parser->transfer_length != (size_t)-1)
+			parser->transfer_length -= size;
+	}
+
+	return 0;
+}
+
 inline int HttpMessage::append(const void *buf, size_t *size)
 {
 	int ret = http_parser_append_message(buf, size, this->parser);
@@ -248,6 +477,12 @@ inline int HttpMessage::append(const void *buf, size_t *size)
 			errno = EMSGSIZE;
 			ret = -1;
 		}
+		else if (this->body_callback &&
+				 http_parser_header_complete(this->parser))
+		{
+			if (this->feed_body() < 0)
+				ret = -1;
+		}
 	}
 	else if (ret == -2)
 	{
@@ -271,6 +506,15 @@ HttpMessage::HttpMessage(HttpMessage&& msg) :
 
 	this->cur_size = msg.cur_size;
 	msg.cur_size = 0;
+
+	this->body_callback = std::move(msg.body_callback);
+	this->body_offset = msg.body_offset;
+	this->body_discard = msg.body_discard;
+	msg.body_callback = nullptr;
+	msg.body_offset = 0;
+
+	this->checksum_type = msg.checksum_type;
+	msg.checksum_type = CHECKSUM_NONE;
 }
 
 HttpMessage& HttpMessage::operator = (HttpMessage&& msg)
@@ -295,6 +539,15 @@ HttpMessage& HttpMessage::operator = (HttpMessage&& msg)
 
 		this->cur_size = msg.cur_size;
 		msg.cur_size = 0;
+
+		this->body_callback = std::move(msg.body_callback);
+		this->body_offset = msg.body_offset;
+		this->body_discard = msg.body_discard;
+		msg.body_callback = nullptr;
+		msg.body_offset = 0;
+
+		this->checksum_type = msg.checksum_type;
+		msg.checksum_type = CHECKSUM_NONE;
 	}
 
 	return *this;
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <utility>
 #include <string>
+#include <functional>
 #include "../kernel/list.h"
 #include "ProtocolMessage.h"
 #include "http_parser.h"
@@ -48,6 +49,9 @@ public:
 		return http_parser_set_version(version, this->parser) == 0;
 	}
 
+	/* A received chunked message is decoded when it completes. After that
+	 * it is not chunked any more: "chunked" is dropped from
+	 * Transfer-Encoding and Content-Length is set to the decoded size. */
 	bool is_chunked() const
 	{
 		return http_parser_chunked(this->parser);
@@ -86,6 +90,8 @@ public:
 									  this->parser) == 0;
 	}
 
+	/* A chunked body is decoded in place by the parser, so the body is
+	 * always the payload, without chunk lines or trailers. */
 	bool get_parsed_body(const void **body, size_t *size) const
 	{
 		return http_parser_get_body(body, size, this->parser) == 0;
@@ -108,6 +114,12 @@ public:
 		return this->append_output_body_nocopy(buf, strlen(buf));
 	}
 
+	/* Append without copying: write up to 'size' bytes into the buffer
+	 * returned by reserve_output_body(), then commit the bytes written.
+	 * The output body must not be changed in between. */
+	void *reserve_output_body(size_t size);
+	void commit_output_body(size_t size);
+
 	size_t get_output_body_size() const
 	{
 		return this->output_body_size;
@@ -120,6 +132,39 @@ public:
 
 	void clear_output_body();
 
+	/* A crc32c of the output body, computed in encode() over the output
+	 * body blocks and sent as a header:
+	 *   CHECKSUM_ETAG         ETag: "1c291ca3"
+	 *   CHECKSUM_REPR_DIGEST  Repr-Digest: crc32c=:HCkcow==:
+	 * Replaces any header of the same name. */
+	enum
+	{
+		CHECKSUM_NONE,
+		CHECKSUM_ETAG,
+		CHECKSUM_REPR_DIGEST,
+	};
+
+	void set_output_checksum(int type)
+	{
+		this->checksum_type = type;
+	}
+
+	/* Input body callback. Called from append() with the body bytes as they
+	 * arrive, the decoded data for a chunked body, so the body can be parsed
+	 * while it is still being received, e.g. by json_stream_feed(). Return
+	 * a negative number with errno set to fail the message. With 'discard',
+	 * the bytes are dropped after the call and get_parsed_body() returns
+	 * nothing, so the body may be larger than memory.
+	 * For a server, set it on the request in an overridden new_session().
+	 * For a client, set it on the response before the task starts. */
+	using body_callback_t = std::function<int (const void *buf, size_t size)>;
+
+	void set_body_callback(body_callback_t callback, bool discard)
+	{
+		this->body_callback = std::move(callback);
+		this->body_discard = discard;
+	}
+
 	/* std::string interfaces */
 public:
 	bool get_http_version(std::string& version) const
@@ -214,10 +259,16 @@ protected:
 
 private:
 	struct list_head *combine_from(struct list_head *pos, size_t size);
+	int set_checksum_header();
+	int feed_body();
 
 private:
 	struct list_head output_body;
 	size_t output_body_size;
+	body_callback_t body_callback;
+	size_t body_offset;
+	bool body_discard;
+	int checksum_type;
 
 public:
 	HttpMessage(bool is_resp) : parser(new http_parser_t)
@@ -226,6 +277,9 @@ public:
 		INIT_LIST_HEAD(&this->output_body);
 		this->output_body_size = 0;
 		this->cur_size = 0;
+		this->body_offset = 0;
+		this->body_discard = false;
+		this->checksum_type = CHECKSUM_NONE;
 	}
 
 	virtual ~HttpMessage()
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include "http_parser.h"
 #include "HttpMessage.h"
+#include "../util/StringUtil.h"
 #include "HttpUtil.h"
 
 namespace protocol
@@ -88,25 +89,18 @@ std::string HttpUtil::decode_chunked_body(const HttpMessage *msg)
 {
 	const void *body;
 	size_t body_len;
-	const void *chunk;
-	size_t chunk_size;
-	std::string decode_result;
-	HttpChunkCursor cursor(msg);
 
 	if (msg->get_parsed_body(&body, &body_len))
-	{
-		decode_result.reserve(body_len);
-		while (cursor.next(&chunk, &chunk_size))
-			decode_result.append((const char *)chunk, chunk_size);
-	}
+		return std::string((const char *)body, body_len);
 
-	return decode_result;
+	return std::string();
 }
 
 void HttpUtil::set_response_status(HttpResponse *resp, int status_code)
 {
 	char buf[32];
-	sprintf(buf, "%d", status_code);
+
+	buf[StringUtil::format_int64(status_code, buf)] = '\0';
 	resp->set_status_code(buf);
 
 	switch (status_code)
@@ -423,11 +417,7 @@ bool HttpHeaderCursor::find_and_erase(const std::string& name)
 HttpChunkCursor::HttpChunkCursor(const HttpMessage *msg)
 {
 	if (msg->get_parsed_body(&this->body, &this->body_len))
-	{
-		this->pos = this->body;
-		this->chunked = msg->is_chunked();
 		this->end = false;
-	}
 	else
 	{
 		this->body = NULL;
@@ -435,43 +425,22 @@ HttpChunkCursor::HttpChunkCursor(const HttpMessage *msg)
 	}
 }
 
+/* The parser has decoded a chunked body already, so the body is one chunk. */
 bool HttpChunkCursor::next(const void **chunk, size_t *size)
 {
 	if (this->end)
 		return false;
 
-	if (!this->chunked)
-	{
-		*chunk = this->body;
-		*size = this->body_len;
-		this->end = true;
-		return true;
-	}
-
-	const char *cur = (const char *)this->pos;
-	char *end;
-
-	*size = strtol(cur, &end, 16);
-	if (*size == 0)
-	{
-		this->end = true;
-		return false;
-	}
-
-	cur = strchr(end, '\r');
-	*chunk = cur + 2;
-	cur += *size + 4;
-	this->pos = cur;
+	*chunk = this->body;
+	*size = this->body_len;
+	this->end = true;
 	return true;
 }
 
 void HttpChunkCursor::rewind()
 {
 	if (this->body)
-	{
-		this->pos = this->body;
 		this->end = false;
-	}
 }
 
 }
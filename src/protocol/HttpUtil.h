@@ -155,6 +155,9 @@ protected:
 	http_header_cursor_t cursor;
 };
 
+/* The parser decodes a received chunked body, and the message has a
+ * Content-Length afterwards, so the cursor yields the whole body as one
+ * chunk, the same as for a body that was never chunked. */
 class HttpChunkCursor
 {
 public:
@@ -168,8 +171,6 @@ public:
 protected:
 	const void *body;
 	size_t body_len;
-	const void *pos;
-	bool chunked;
 	bool end;
 };
 
@@ -8,6 +8,7 @@
  * Copyright (c) 2024 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../kernel/list.h"
@@ -471,9 +472,15 @@ static int __parse_chunk_data(const char *ptr, size_t len,
 			}
 			else if ((unsigned long)chunk_size < CHUNK_SIZE_MAX)
 			{
-				chunk_size += i + 4;
-				if (len < (size_t)chunk_size)
+				if (len < (size_t)chunk_size + i + 4)
 					return 0;
+
+				/* Decode in place: the data of every chunk is moved down
+				 * right after the data of the previous one. */
+				memmove((char *)parser->msgbuf + parser->dechunk_offset,
+						ptr + i + 2, chunk_size);
+				parser->dechunk_offset += chunk_size;
+				chunk_size += i + 4;
 			}
 			else
 				return -2;
@@ -568,6 +575,62 @@ void http_parser_init(int is_resp, http_parser_t *parser)
 	parser->is_resp = is_resp;
 }
 
+/* After the body is dechunked in place the message is no longer chunked:
+ * drop "chunked" from Transfer-Encoding and give it a Content-Length, so
+ * that a parsed message can be sent again as it is. */
+static int __finish_dechunked(http_parser_t *parser)
+{
+	size_t size = parser->msgsize - parser->header_offset;
+	struct __header_line *line;
+	struct list_head *pos, *tmp;
+	char buf[32];
+	int len;
+
+	list_for_each_safe(pos, tmp, &parser->header_list)
+	{
+		line = list_entry(pos, struct __header_line, list);
+		if (line->name_len != 17 ||
+			strncasecmp(line->buf, "Transfer-Encoding", 17) != 0)
+			continue;
+
+		/* "chunked" is the last coding, e.g. "gzip, chunked". */
+		len = line->value_len;
+		if (len >= 7 &&
+			strncasecmp(line->buf + 19 + len - 7, "chunked", 7) == 0)
+		{
+			len -= 7;
+			while (len > 0 && (line->buf[19 + len - 1] == ' ' ||
+							   line->buf[19 + len - 1] == '\t' ||
+							   line->buf[19 + len - 1] == ','))
+				len--;
+		}
+
+		if (len == 0)
+		{
+			list_del(&line->list);
+			if (line->buf != (char *)(line + 1))
+				free(line->buf);
+
+			free(line);
+		}
+		else
+		{
+			line->buf[19 + len] = '\r';
+			line->buf[19 + len + 1] = '\n';
+			line->value_len = len;
+		}
+	}
+
+	parser->chunked = 0;
+	len = sprintf(buf, "%zu", size);
+	if (__set_message_header("Content-Length", 14, buf, len, parser) < 0)
+		return -1;
+
+	parser->has_content_length = 1;
+	parser->content_length = size;
+	return 0;
+}
+
 int http_parser_append_message(const void *buf, size_t *n,
 							   http_parser_t *parser)
 {
@@ -606,6 +669,7 @@ int http_parser_append_message(const void *buf, size_t *n,
 		if (parser->chunked)
 		{
 			parser->chunk_offset = parser->header_offset;
+			parser->dechunk_offset = parser->header_offset;
 			parser->chunk_state = CPS_CHUNK_DATA;
 		}
 		else if (parser->transfer_length == (size_t)-1)
@@ -637,8 +701,13 @@ int http_parser_append_message(const void *buf, size_t *n,
 			return ret;
 	}
 
+	/* The body is the decoded data. Chunk lines and trailers are gone. */
 	*n -= parser->msgsize - parser->chunk_offset;
-	parser->msgsize = parser->chunk_offset;
+	parser->msgsize = parser->dechunk_offset;
+	parser->chunk_offset = parser->dechunk_offset;
+	if (__finish_dechunked(parser) < 0)
+		return -1;
+
 	parser->complete = 1;
 	return 1;
 }
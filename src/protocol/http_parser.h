@@ -23,6 +23,7 @@ typedef struct __http_parser
 	int chunk_state;
 	size_t header_offset;
 	size_t chunk_offset;
+	size_t dechunk_offset;
 	size_t content_length;
 	size_t transfer_length;
 	char *version;
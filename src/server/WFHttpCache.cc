@@ -0,0 +1,370 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/server/WFHttpCache.cc
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "WFHttpCache.h"
+#include "../factory/Workflow.h"
+#include "../protocol/HttpUtil.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+using namespace protocol;
+
+#define CONNECTION_KEEP_ALIVE "Connection: Keep-Alive\r\n"
+#define CONNECTION_CLOSE "Connection: close\r\n"
+
+static inline int64_t __get_current_ms() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+//*命中时替换发送的消息,响应头和响应体都直接引用缓存
+class __HttpCacheReplay : public WFHttpServerTask::ReplyHook,
+                          public CommMessageOut {
+public:
+  __HttpCacheReplay(WFHttpCache *cache, const WFHttpCache::Handle *handle) {
+    this->cache = cache;
+    this->handle = handle;
+  }
+
+  virtual ~__HttpCacheReplay() { this->cache->release(this->handle); }
+
+private:
+  virtual CommMessageOut *message_out(HttpResponse *resp, bool keep_alive) {
+    this->keep_alive = keep_alive;
+    return this;
+  }
+
+  virtual int encode(struct iovec vectors[], int max) {
+    const WFHttpCache::Entry *entry = this->handle->value;
+    int i = 0;
+
+    if (max < 4) {
+      errno = EOVERFLOW;
+      return -1;
+    }
+
+    vectors[i].iov_base = entry->head;
+    vectors[i].iov_len = entry->head_len;
+    i++;
+    if (this->keep_alive) {
+      vectors[i].iov_base = (void *)CONNECTION_KEEP_ALIVE;
+      vectors[i].iov_len = sizeof CONNECTION_KEEP_ALIVE - 1;
+    } else {
+      vectors[i].iov_base = (void *)CONNECTION_CLOSE;
+      vectors[i].iov_len = sizeof CONNECTION_CLOSE - 1;
+    }
+
+    i++;
+    vectors[i].iov_base = (void *)"\r\n";
+    vectors[i].iov_len = 2;
+    i++;
+    if (entry->body_len > 0) {
+      vectors[i].iov_base = entry->body;
+      vectors[i].iov_len = entry->body_len;
+      i++;
+    }
+
+    return i;
+  }
+
+private:
+  WFHttpCache *cache;
+  const WFHttpCache::Handle *handle;
+  bool keep_alive;
+};
+
+//*未命中时由第一个请求持有,发送前把响应存入缓存,任务结束时唤醒等待者
+class __HttpCacheFill : public WFHttpServerTask::ReplyHook {
+public:
+  __HttpCacheFill(WFHttpCache *cache, const std::string &key) : key(key) {
+    this->cache = cache;
+  }
+
+  virtual ~__HttpCacheFill() { this->cache->fill_finish(this->key); }
+
+private:
+  virtual CommMessageOut *message_out(HttpResponse *resp, bool keep_alive) {
+    this->cache->fill(this->key, resp);
+    return resp;
+  }
+
+private:
+  WFHttpCache *cache;
+  std::string key;
+};
+
+//*同一个key已有请求在调用process时,后来的请求在series里等待
+class __HttpCacheWaiter : public SubTask {
+public:
+  __HttpCacheWaiter(WFHttpCache *cache, WFHttpTask *task,
+                    const std::string &key)
+      : key(key) {
+    this->cache = cache;
+    this->task = task;
+  }
+
+  virtual void dispatch() {
+    if (!this->cache->wait(this))
+      this->wake();
+  }
+
+  void wake() {
+    const WFHttpCache::Handle *handle = this->cache->lookup(this->key);
+
+    if (handle) {
+      static_cast<WFHttpServerTask *>(this->task)
+          ->set_reply_hook(new __HttpCacheReplay(this->cache, handle));
+    } else
+      this->cache->proc(this->task);
+
+    this->subtask_done();
+  }
+
+private:
+  virtual SubTask *done() {
+    SeriesWork *series = series_of(this);
+
+    delete this;
+    return series->pop();
+  }
+
+private:
+  WFHttpCache *cache;
+  WFHttpTask *task;
+  std::string key;
+
+  friend class WFHttpCache;
+};
+
+WFHttpCache::WFHttpCache(const struct WFHttpCacheParams *params,
+                         http_process_t proc)
+    : proc(std::move(proc)) {
+  const char *const *name;
+
+  this->params = *params;
+  this->params.key_headers = NULL;
+  this->cache.set_max_size(params->max_entries);
+  for (name = params->key_headers; name && *name; name++)
+    this->key_headers.emplace_back(*name);
+}
+
+void WFHttpCache::process(WFHttpTask *task) {
+  HttpRequest *req = task->get_req();
+  const Handle *handle;
+  std::string key;
+
+  if (strcmp(req->get_method(), HttpMethodGet) != 0) {
+    this->proc(task);
+    return;
+  }
+
+  key = this->make_key(req);
+  handle = this->lookup(key);
+  if (handle) {
+    static_cast<WFHttpServerTask *>(task)->set_reply_hook(
+        new __HttpCacheReplay(this, handle));
+    return;
+  }
+
+  this->mutex.lock();
+  auto ret = this->pending.emplace(key, std::vector<__HttpCacheWaiter *>());
+  this->mutex.unlock();
+
+  if (ret.second) {
+    static_cast<WFHttpServerTask *>(task)->set_reply_hook(
+        new __HttpCacheFill(this, key));
+    this->proc(task);
+  } else
+    series_of(task)->push_back(new __HttpCacheWaiter(this, task, key));
+}
+
+std::string WFHttpCache::make_key(HttpRequest *req) const {
+  std::string key(req->get_method());
+  std::string value;
+
+  key += ' ';
+  key += req->get_request_uri();
+  if (!this->key_headers.empty()) {
+    HttpHeaderCursor cursor(req);
+
+    for (const std::string &name : this->key_headers) {
+      key += '\n';
+      cursor.rewind();
+      if (cursor.find(name, value))
+        key += value;
+    }
+  }
+
+  return key;
+}
+
+const WFHttpCache::Handle *WFHttpCache::lookup(const std::string &key) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  const Handle *handle = this->cache.get(key);
+
+  if (handle && handle->value->expire <= __get_current_ms()) {
+    this->cache.release(handle);
+    this->cache.del(key);
+    handle = NULL;
+  }
+
+  return handle;
+}
+
+void WFHttpCache::release(const Handle *handle) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->cache.release(handle);
+}
+
+//*Connection与Keep-Alive只对当前连接有效,不存入缓存,命中时按请求重新生成
+static inline bool
+__is_connection_header(const struct HttpMessageHeader *header) {
+  const char *name = (const char *)header->name;
+
+  return header->name_len == 10 && (strncasecmp(name, "Connection", 10) == 0 ||
+                                    strncasecmp(name, "Keep-Alive", 10) == 0);
+}
+
+//*max-age/s-maxage单位为秒,返回-1表示没有,返回0表示不可缓存
+static int __parse_cache_control(const char *p, size_t len) {
+  const char *end = p + len;
+  const char *token;
+  int max_age = -1;
+  size_t n;
+
+  while (p < end) {
+    while (p < end && (isspace(*p) || *p == ','))
+      p++;
+
+    token = p;
+    while (p < end && *p != ',')
+      p++;
+
+    n = p - token;
+    while (n > 0 && isspace(token[n - 1]))
+      n--;
+
+    if ((n == 8 && strncasecmp(token, "no-store", 8) == 0) ||
+        (n == 8 && strncasecmp(token, "no-cache", 8) == 0) ||
+        (n == 7 && strncasecmp(token, "private", 7) == 0))
+      return 0;
+
+    if (n > 8 && strncasecmp(token, "max-age=", 8) == 0) {
+      if (max_age < 0)
+        max_age = atoi(token + 8);
+    } else if (n > 9 && strncasecmp(token, "s-maxage=", 9) == 0)
+      max_age = atoi(token + 9);
+  }
+
+  return max_age;
+}
+
+bool WFHttpCache::fill(const std::string &key, HttpResponse *resp) {
+  const char *code = resp->get_status_code();
+  size_t body_len = resp->get_output_body_size();
+  struct HttpMessageHeader header;
+  int64_t ttl = this->params.ttl;
+  size_t head_len;
+  Entry *entry;
+  char *p;
+
+  if (!code || strcmp(code, "200") != 0 ||
+      body_len > this->params.max_body_size)
+    return false;
+
+  HttpHeaderCursor cursor(resp);
+
+  head_len = strlen(resp->get_http_version()) + 1 + strlen(code) + 1 +
+             strlen(resp->get_reason_phrase()) + 2;
+  while (cursor.next(&header)) {
+    if (__is_connection_header(&header))
+      continue;
+
+    if (header.name_len == 13 &&
+        strncasecmp((const char *)header.name, "Cache-Control", 13) == 0) {
+      int max_age = __parse_cache_control((const char *)header.value,
+                                          header.value_len);
+      if (max_age >= 0)
+        ttl = (int64_t)max_age * 1000;
+    }
+
+    head_len += header.name_len + 2 + header.value_len + 2;
+  }
+
+  if (ttl <= 0)
+    return false;
+
+  /* One more byte for the '\0' written by sprintf(). */
+  entry = (Entry *)malloc(sizeof (Entry) + head_len + body_len + 1);
+  if (!entry)
+    return false;
+
+  entry->head = (char *)(entry + 1);
+  entry->head_len = head_len;
+  entry->body = entry->head + head_len;
+  entry->body_len = body_len;
+  entry->expire = __get_current_ms() + ttl;
+
+  p = entry->head;
+  p += sprintf(p, "%s %s %s\r\n", resp->get_http_version(), code,
+               resp->get_reason_phrase());
+  cursor.rewind();
+  while (cursor.next(&header)) {
+    if (__is_connection_header(&header))
+      continue;
+
+    memcpy(p, header.name, header.name_len);
+    p += header.name_len;
+    *p++ = ':';
+    *p++ = ' ';
+    memcpy(p, header.value, header.value_len);
+    p += header.value_len;
+    *p++ = '\r';
+    *p++ = '\n';
+  }
+
+  resp->get_output_body_merged(entry->body, &body_len);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->cache.release(this->cache.put(key, entry));
+  return true;
+}
+
+void WFHttpCache::fill_finish(const std::string &key) {
+  std::vector<__HttpCacheWaiter *> waiters;
+
+  this->mutex.lock();
+  auto it = this->pending.find(key);
+  waiters.swap(it->second);
+  this->pending.erase(it);
+  this->mutex.unlock();
+
+  for (__HttpCacheWaiter *waiter : waiters)
+    waiter->wake();
+}
+
+//*返回true表示已加入等待队列
+bool WFHttpCache::wait(__HttpCacheWaiter *waiter) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->pending.find(waiter->key);
+
+  if (it == this->pending.end())
+    return false;
+
+  it->second.push_back(waiter);
+  return true;
+}
@@ -0,0 +1,102 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/server/WFHttpCache.h
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#ifndef _WFHTTPCACHE_H_
+#define _WFHTTPCACHE_H_
+
+#include "../factory/WFHttpServerTask.h"
+#include "../util/LRUCache.h"
+#include "WFHttpServer.h"
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file   WFHttpCache.h
+ * @brief  Response micro-cache in front of WFHttpServer process
+ */
+
+struct WFHttpCacheParams {
+  size_t max_entries;   //*最多缓存的响应个数,0表示不限
+  int ttl;              //*默认缓存时间(毫秒),响应带max-age时以max-age为准
+  size_t max_body_size; //*超过这个大小的响应不缓存
+  const char *const *key_headers; //*以NULL结尾,这些请求头的值也参与key
+};
+
+static constexpr struct WFHttpCacheParams HTTP_CACHE_PARAMS_DEFAULT = {
+    .max_entries = 1024,
+    .ttl = 1000,
+    .max_body_size = 1024 * 1024,
+    .key_headers = NULL,
+};
+
+class __HttpCacheWaiter;
+
+//*缓存GET请求的200响应,key为method+URI+key_headers
+//*命中时不调用process,直接把编码好的响应作为nocopy iovec发出
+//*同一个key并发未命中时只有第一个请求调用process,其余的等待其结果
+//*用法:
+//*  WFHttpCache cache(&params, process);
+//*  WFHttpServer server(cache.get_process());
+class WFHttpCache {
+public:
+  WFHttpCache(const struct WFHttpCacheParams *params, http_process_t proc);
+
+  http_process_t get_process() {
+    return [this](WFHttpTask *task) { this->process(task); };
+  }
+
+  //*删除所有未被使用的缓存
+  void prune() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->cache.prune();
+  }
+
+public:
+  struct Entry {
+    char *head; //*状态行+响应头,不含Connection,Keep-Alive和结尾的空行
+    size_t head_len;
+    char *body;
+    size_t body_len;
+    int64_t expire; //*CLOCK_MONOTONIC毫秒
+  };
+
+  struct EntryDeleter {
+    void operator()(Entry *entry) const { free(entry); }
+  };
+
+  using Cache = LRUCache<std::string, Entry *, EntryDeleter>;
+  using Handle = LRUHandle<std::string, Entry *>;
+
+private:
+  void process(WFHttpTask *task);
+  std::string make_key(protocol::HttpRequest *req) const;
+  const Handle *lookup(const std::string &key);
+  bool fill(const std::string &key, protocol::HttpResponse *resp);
+  void fill_finish(const std::string &key);
+  bool wait(__HttpCacheWaiter *waiter);
+  void release(const Handle *handle);
+
+private:
+  struct WFHttpCacheParams params;
+  std::vector<std::string> key_headers;
+  http_process_t proc;
+  Cache cache;
+  std::unordered_map<std::string, std::vector<__HttpCacheWaiter *>> pending;
+  std::mutex mutex;
+
+  friend class __HttpCacheWaiter;
+  friend class __HttpCacheReplay;
+  friend class __HttpCacheFill;
+};
+
+#endif
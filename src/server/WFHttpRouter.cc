@@ -0,0 +1,302 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/server/WFHttpRouter.cc
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "WFHttpRouter.h"
+#include <errno.h>
+#include <string.h>
+
+using namespace protocol;
+
+//*静态节点保存压缩后的前缀,子节点按首字节索引
+//*:param和*wildcard节点没有前缀,name为参数名
+class __HttpRouteNode {
+public:
+  __HttpRouteNode() {
+    this->param = NULL;
+    this->wildcard = NULL;
+  }
+
+  ~__HttpRouteNode() {
+    for (__HttpRouteNode *child : this->children)
+      delete child;
+
+    delete this->param;
+    delete this->wildcard;
+  }
+
+public:
+  std::string prefix;
+  std::string indices;
+  std::vector<__HttpRouteNode *> children;
+  __HttpRouteNode *param;
+  __HttpRouteNode *wildcard;
+  std::string name;
+  http_route_t handler;
+};
+
+static inline bool __is_capture(const char *p) {
+  return (*p == ':' || *p == '*') && p[-1] == '/';
+}
+
+//*检查pattern并统计参数个数,非法返回-1
+static int __check_pattern(const char *p) {
+  int count = 0;
+  const char *name;
+
+  if (*p != '/')
+    return -1;
+
+  for (p++; *p; p++) {
+    if (!__is_capture(p))
+      continue;
+
+    name = p + 1;
+    while (*name && *name != '/')
+      name++;
+
+    if (name == p + 1 || (*p == '*' && *name))
+      return -1;
+
+    count++;
+    p = name - 1;
+  }
+
+  return count <= HTTP_ROUTE_PARAMS_MAX ? count : -1;
+}
+
+static void __split_node(__HttpRouteNode *node, size_t len) {
+  __HttpRouteNode *child = new __HttpRouteNode;
+
+  child->prefix = node->prefix.substr(len);
+  child->indices.swap(node->indices);
+  child->children.swap(node->children);
+  child->param = node->param;
+  child->wildcard = node->wildcard;
+  child->handler.swap(node->handler);
+  node->param = NULL;
+  node->wildcard = NULL;
+  node->prefix.resize(len);
+  node->indices.push_back(child->prefix[0]);
+  node->children.push_back(child);
+}
+
+//*node已经完全匹配,p为pattern剩余部分,返回pattern结束处的节点
+static __HttpRouteNode *__insert(__HttpRouteNode *node, const char *p) {
+  __HttpRouteNode **pchild;
+  __HttpRouteNode *child;
+  const char *end;
+  size_t pos;
+  size_t len;
+
+  while (*p) {
+    if (__is_capture(p)) {
+      pchild = *p == ':' ? &node->param : &node->wildcard;
+      end = p + 1;
+      while (*end && *end != '/')
+        end++;
+
+      if (!*pchild) {
+        *pchild = new __HttpRouteNode;
+        (*pchild)->name.assign(p + 1, end - p - 1);
+      } else if ((*pchild)->name.compare(0, std::string::npos, p + 1,
+                                         end - p - 1) != 0)
+        return NULL;
+
+      node = *pchild;
+      p = end;
+      continue;
+    }
+
+    end = p + 1;
+    while (*end && !__is_capture(end))
+      end++;
+
+    pos = node->indices.find(*p);
+    if (pos == std::string::npos) {
+      child = new __HttpRouteNode;
+      child->prefix.assign(p, end - p);
+      node->indices.push_back(*p);
+      node->children.push_back(child);
+      node = child;
+      p = end;
+      continue;
+    }
+
+    child = node->children[pos];
+    for (len = 1; len < child->prefix.size() && p + len < end; len++) {
+      if (child->prefix[len] != p[len])
+        break;
+    }
+
+    if (len < child->prefix.size())
+      __split_node(child, len);
+
+    node = child;
+    p += len;
+  }
+
+  return node;
+}
+
+static const http_route_t *__match(const __HttpRouteNode *node, const char *p,
+                                   const char *end,
+                                   WFHttpRouteParams *params) {
+  const http_route_t *handler;
+  const __HttpRouteNode *child;
+  WFHttpRouteParam *param;
+  const char *pos;
+
+  if (p == end && node->handler)
+    return &node->handler;
+
+  if (p < end) {
+    pos = (const char *)memchr(node->indices.data(), *p, node->indices.size());
+    if (pos) {
+      child = node->children[pos - node->indices.data()];
+      if ((size_t)(end - p) >= child->prefix.size() &&
+          memcmp(child->prefix.data(), p, child->prefix.size()) == 0) {
+        handler = __match(child, p + child->prefix.size(), end, params);
+        if (handler)
+          return handler;
+      }
+    }
+  }
+
+  if (node->param) {
+    pos = p;
+    while (pos < end && *pos != '/')
+      pos++;
+
+    if (pos > p) {
+      param = &params->params[params->count++];
+      param->name = node->param->name.data();
+      param->name_len = node->param->name.size();
+      param->value = p;
+      param->value_len = pos - p;
+      handler = __match(node->param, pos, end, params);
+      if (handler)
+        return handler;
+
+      params->count--;
+    }
+  }
+
+  if (node->wildcard && node->wildcard->handler) {
+    param = &params->params[params->count++];
+    param->name = node->wildcard->name.data();
+    param->name_len = node->wildcard->name.size();
+    param->value = p;
+    param->value_len = end - p;
+    return &node->wildcard->handler;
+  }
+
+  return NULL;
+}
+
+WFHttpRouter::~WFHttpRouter() {
+  for (RouteTable &table : this->tables)
+    delete table.root;
+}
+
+int WFHttpRouter::add(const char *method, const char *pattern,
+                      http_route_t handler) {
+  __HttpRouteNode *root = NULL;
+  __HttpRouteNode *node;
+
+  if (!handler || __check_pattern(pattern) < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  for (RouteTable &table : this->tables) {
+    if (table.method == method) {
+      root = table.root;
+      break;
+    }
+  }
+
+  if (!root) {
+    root = new __HttpRouteNode;
+    this->tables.push_back({method, root});
+  }
+
+  node = __insert(root, pattern);
+  if (!node) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (node->handler) {
+    errno = EEXIST;
+    return -1;
+  }
+
+  node->handler = std::move(handler);
+  return 0;
+}
+
+const http_route_t *WFHttpRouter::match(const char *method, const char *uri,
+                                        size_t len,
+                                        WFHttpRouteParams *params) const {
+  const char *end = uri + len;
+  const char *path = uri;
+  const char *pos;
+
+  params->count = 0;
+  //*absolute-form: scheme://authority/path
+  if (path < end && *path != '/') {
+    pos = (const char *)memchr(path, ':', end - path);
+    if (!pos || end - pos < 3 || pos[1] != '/' || pos[2] != '/')
+      return NULL;
+
+    pos += 3;
+    path = (const char *)memchr(pos, '/', end - pos);
+    if (!path)
+      path = end;
+  }
+
+  for (pos = path; pos < end; pos++) {
+    if (*pos == '?' || *pos == '#')
+      break;
+  }
+
+  if (path == pos) {
+    path = "/";
+    pos = path + 1;
+  }
+
+  for (const RouteTable &table : this->tables) {
+    if (table.method == method)
+      return __match(table.root, path, pos, params);
+  }
+
+  return NULL;
+}
+
+void WFHttpRouter::process(WFHttpTask *task) const {
+  HttpRequest *req = task->get_req();
+  const char *uri = req->get_request_uri();
+  const http_route_t *handler;
+  WFHttpRouteParams params;
+
+  if (uri && req->get_method())
+    handler = this->match(req->get_method(), uri, &params);
+  else
+    handler = NULL;
+
+  if (handler)
+    (*handler)(task, &params);
+  else {
+    HttpResponse *resp = task->get_resp();
+
+    resp->set_status_code("404");
+    resp->set_reason_phrase("Not Found");
+  }
+}
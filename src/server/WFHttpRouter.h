@@ -0,0 +1,114 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/server/WFHttpRouter.h
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#ifndef _WFHTTPROUTER_H_
+#define _WFHTTPROUTER_H_
+
+#include "WFHttpServer.h"
+#include <functional>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/**
+ * @file   WFHttpRouter.h
+ * @brief  Radix-tree request router for WFHttpServer
+ */
+
+#define HTTP_ROUTE_PARAMS_MAX 16
+
+//*name指向路由里保存的参数名,value指向请求的request uri,都不以'\0'结尾
+//*value是原始字节,没有做百分号解码
+struct WFHttpRouteParam {
+  const char *name;
+  size_t name_len;
+  const char *value;
+  size_t value_len;
+};
+
+struct WFHttpRouteParams {
+  WFHttpRouteParam params[HTTP_ROUTE_PARAMS_MAX];
+  size_t count;
+
+  const WFHttpRouteParam *find(const char *name) const {
+    size_t len = strlen(name);
+    size_t i;
+
+    for (i = 0; i < this->count; i++) {
+      if (this->params[i].name_len == len &&
+          memcmp(this->params[i].name, name, len) == 0)
+        return &this->params[i];
+    }
+
+    return NULL;
+  }
+
+  std::string get(const char *name) const {
+    const WFHttpRouteParam *param = this->find(name);
+
+    if (!param)
+      return std::string();
+
+    return std::string(param->value, param->value_len);
+  }
+};
+
+using http_route_t =
+    std::function<void(WFHttpTask *, const WFHttpRouteParams *)>;
+
+class __HttpRouteNode;
+
+//*pattern以'/'开头,一个路径段以':'开头表示捕获该段,以'*'开头表示捕获剩余的全部路径
+//*  /user/:id/profile    /static/*path    /api/v1/items
+//*同一位置的匹配优先级: 静态 > :param > *wildcard,匹配失败会回溯
+//*匹配只读取request uri的原始字节,到'?'或'#'为止,不分配内存
+//*用法:
+//*  WFHttpRouter router;
+//*  router.add("GET", "/user/:id", handler);
+//*  WFHttpServer server(router.get_process());
+class WFHttpRouter {
+public:
+  WFHttpRouter() = default;
+  virtual ~WFHttpRouter();
+
+  //*成功返回0;pattern非法或与已有路由冲突返回-1并设置errno(EINVAL/EEXIST)
+  int add(const char *method, const char *pattern, http_route_t handler);
+
+  //*没有匹配时返回NULL,params的内容只在返回非NULL时有效
+  const http_route_t *match(const char *method, const char *uri, size_t len,
+                            WFHttpRouteParams *params) const;
+
+  const http_route_t *match(const char *method, const char *uri,
+                            WFHttpRouteParams *params) const {
+    return this->match(method, uri, strlen(uri), params);
+  }
+
+  //*匹配失败时返回404
+  http_process_t get_process() {
+    return [this](WFHttpTask *task) { this->process(task); };
+  }
+
+private:
+  void process(WFHttpTask *task) const;
+
+private:
+  struct RouteTable {
+    std::string method;
+    __HttpRouteNode *root;
+  };
+
+  std::vector<RouteTable> tables;
+
+  WFHttpRouter(const WFHttpRouter &) = delete;
+  WFHttpRouter &operator=(const WFHttpRouter &) = delete;
+};
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/util/AlignedBufferPool.cc
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include <sys/mman.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "AlignedBufferPool.h"
+
+AlignedBufferPool::AlignedBufferPool()
+{
+	int i;
+
+	for (i = 0; i < CLASSES; i++)
+		this->free_list[i] = NULL;
+
+	this->cur = NULL;
+	this->left = 0;
+	this->chunks = NULL;
+	this->nchunks = 0;
+	this->chunks_max = 0;
+	pthread_mutex_init(&this->mutex, NULL);
+}
+
+AlignedBufferPool::~AlignedBufferPool()
+{
+	int i;
+
+	for (i = 0; i < this->nchunks; i++)
+		munmap(this->chunks[i], CHUNK_SIZE);
+
+	free(this->chunks);
+	pthread_mutex_destroy(&this->mutex);
+}
+
+size_t AlignedBufferPool::buffer_size(size_t size)
+{
+	size_t n = ALIGNMENT;
+
+	if (size > MAX_POOLED_SIZE)
+		return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+	while (n < size)
+		n <<= 1;
+
+	return n;
+}
+
+int AlignedBufferPool::class_of(size_t size)
+{
+	int i = 0;
+
+	while ((ALIGNMENT << i) < size)
+		i++;
+
+	return i;
+}
+
+/* Huge pages if reserved, or else transparent huge pages, which need the
+ * chunk to be aligned to its size. */
+char *AlignedBufferPool::alloc_chunk()
+{
+	char **chunks;
+	char *chunk;
+	uintptr_t aligned;
+	char *end;
+
+	if (this->nchunks == this->chunks_max)
+	{
+		chunks = (char **)realloc(this->chunks, (2 * this->chunks_max + 8) *
+												sizeof (char *));
+		if (!chunks)
+			return NULL;
+
+		this->chunks = chunks;
+		this->chunks_max = 2 * this->chunks_max + 8;
+	}
+
+	chunk = (char *)mmap(NULL, CHUNK_SIZE, PROT_READ | PROT_WRITE,
+						 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (chunk == MAP_FAILED)
+	{
+		chunk = (char *)mmap(NULL, 2 * CHUNK_SIZE, PROT_READ | PROT_WRITE,
+							 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (chunk == MAP_FAILED)
+			return NULL;
+
+		aligned = ((uintptr_t)chunk + CHUNK_SIZE - 1) & ~(CHUNK_SIZE - 1);
+		end = chunk + 2 * CHUNK_SIZE;
+		if ((char *)aligned != chunk)
+			munmap(chunk, (char *)aligned - chunk);
+
+		chunk = (char *)aligned;
+		if (chunk + CHUNK_SIZE != end)
+			munmap(chunk + CHUNK_SIZE, end - chunk - CHUNK_SIZE);
+
+		madvise(chunk, CHUNK_SIZE, MADV_HUGEPAGE);
+	}
+
+	this->chunks[this->nchunks++] = chunk;
+	return chunk;
+}
+
+void *AlignedBufferPool::get(size_t size)
+{
+	struct FreeBuffer *buf;
+	size_t n = buffer_size(size);
+	int i = class_of(n);
+	void *ptr;
+
+	if (size > MAX_POOLED_SIZE)
+	{
+		ptr = mmap(NULL, n, PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			return NULL;
+
+		madvise(ptr, n, MADV_HUGEPAGE);
+		return ptr;
+	}
+
+	pthread_mutex_lock(&this->mutex);
+	buf = this->free_list[i];
+	if (buf)
+		this->free_list[i] = buf->next;
+	else
+	{
+		if (this->left < n)
+		{
+			/* What is left of the chunk goes to the smaller classes. */
+			while (this->left >= ALIGNMENT)
+			{
+				i = class_of(this->left);
+				if ((ALIGNMENT << i) > this->left)
+					i--;
+
+				buf = (struct FreeBuffer *)this->cur;
+				buf->next = this->free_list[i];
+				this->free_list[i] = buf;
+				this->cur += ALIGNMENT << i;
+				this->left -= ALIGNMENT << i;
+			}
+
+			this->cur = this->alloc_chunk();
+			this->left = this->cur ? CHUNK_SIZE : 0;
+		}
+
+		buf = (struct FreeBuffer *)this->cur;
+		if (buf)
+		{
+			this->cur += n;
+			this->left -= n;
+		}
+		else
+			errno = ENOMEM;
+	}
+
+	pthread_mutex_unlock(&this->mutex);
+	return buf;
+}
+
+void AlignedBufferPool::put(void *buf, size_t size)
+{
+	struct FreeBuffer *entry = (struct FreeBuffer *)buf;
+	int i;
+
+	if (size > MAX_POOLED_SIZE)
+	{
+		munmap(buf, buffer_size(size));
+		return;
+	}
+
+	i = class_of(buffer_size(size));
+	pthread_mutex_lock(&this->mutex);
+	entry->next = this->free_list[i];
+	this->free_list[i] = entry;
+	pthread_mutex_unlock(&this->mutex);
+}
@@ -0,0 +1,74 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/util/AlignedBufferPool.h
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#ifndef _ALIGNEDBUFFERPOOL_H_
+#define _ALIGNEDBUFFERPOOL_H_
+
+#include <stddef.h>
+#include <pthread.h>
+
+/**
+ * @file   AlignedBufferPool.h
+ * @brief  Pool of page aligned buffers for O_DIRECT
+ */
+
+/*
+ * Buffers are aligned to 4 KB and sized in powers of two from 4 KB to 1 MB.
+ * They are cut from 2 MB chunks backed by huge pages when the system has
+ * them (MAP_HUGETLB, or transparent huge pages), and go back to the pool,
+ * not to the system, when put. Larger buffers are mapped at every get().
+ * Thread safe.
+ */
+class AlignedBufferPool
+{
+public:
+	static const size_t ALIGNMENT = 4096;
+	static const size_t MAX_POOLED_SIZE = 1 << 20;
+	static const size_t CHUNK_SIZE = 2 << 20;
+
+public:
+	/* NULL with errno set on failure. */
+	void *get(size_t size);
+
+	/* 'size' as given to get(). */
+	void put(void *buf, size_t size);
+
+	/* The size of the buffer get() returns for 'size'. */
+	static size_t buffer_size(size_t size);
+
+public:
+	AlignedBufferPool();
+	~AlignedBufferPool();
+
+private:
+	enum
+	{
+		CLASSES = 9,	/* 4 KB to 1 MB */
+	};
+
+	struct FreeBuffer
+	{
+		struct FreeBuffer *next;
+	};
+
+	static int class_of(size_t size);
+	char *alloc_chunk();
+
+private:
+	struct FreeBuffer *free_list[CLASSES];
+	char *cur;
+	size_t left;
+	char **chunks;
+	int nchunks;
+	int chunks_max;
+	pthread_mutex_t mutex;
+};
+
+#endif
@@ -0,0 +1,459 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/util/CachePolicy.h
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#ifndef _CACHEPOLICY_H_
+#define _CACHEPOLICY_H_
+
+#include "../kernel/list.h"
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file   CachePolicy.h
+ * @brief  Eviction and admission policies for LRUCache
+ */
+
+// Eviction policy interface (all methods called by LRUCache only):
+//   void init(size_t max_size);
+//   void insert(CachePolicyNode *node, const KEY &key);  new entry, pinned
+//   void access(CachePolicyNode *node);                  cache hit
+//   void pin(CachePolicyNode *node);    first unreleased handle taken
+//   void unpin(CachePolicyNode *node);  last handle released
+//   void erase(CachePolicyNode *node);                   del/replace/prune
+//   void evict(CachePolicyNode *node);                   victim removed
+//   CachePolicyNode *victim();  next entry to evict, NULL if all pinned
+//   CachePolicyNode *peek_victim();  like victim(), without side effects
+//
+// Admission policy interface:
+//   void init(size_t max_size);
+//   void record(const KEY &key);  every get(), hit or miss
+//   bool admit(const KEY &candidate, const KEY &victim);
+//
+// A pinned node is referenced by an unreleased handle. It is kept off the
+// policy queues, so victim() never has to skip it; unpin() puts it back at
+// the tail of its queue.
+
+struct CachePolicyNode {
+  struct list_head list;
+  size_t hash;
+  unsigned char freq;
+  unsigned char queue;
+  bool pinned; // off the queue, maintained by the policy
+};
+
+static inline size_t __cache_hash_mix(size_t h) {
+  uint64_t x = (uint64_t)h;
+
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static inline size_t __cache_roundup_pow2(size_t n) {
+  size_t size = 1;
+
+  while (size < n)
+    size <<= 1;
+
+  return size;
+}
+
+// Classic LRU: a released entry goes to the tail, victims come from the
+// head. A hit needs no list operation, since the handle taken pins it.
+template <typename KEY> class LRUPolicy {
+public:
+  LRUPolicy() { INIT_LIST_HEAD(&this->queue); }
+
+  void init(size_t max_size) {}
+
+  void insert(CachePolicyNode *node, const KEY &key) { node->pinned = true; }
+
+  void access(CachePolicyNode *node) {}
+
+  void pin(CachePolicyNode *node) {
+    list_del(&node->list);
+    node->pinned = true;
+  }
+
+  void unpin(CachePolicyNode *node) {
+    list_add_tail(&node->list, &this->queue);
+    node->pinned = false;
+  }
+
+  void erase(CachePolicyNode *node) {
+    if (!node->pinned)
+      list_del(&node->list);
+  }
+
+  void evict(CachePolicyNode *node) { list_del(&node->list); }
+
+  CachePolicyNode *victim() { return this->peek_victim(); }
+
+  CachePolicyNode *peek_victim() {
+    if (list_empty(&this->queue))
+      return NULL;
+
+    return list_entry(this->queue.next, CachePolicyNode, list);
+  }
+
+private:
+  struct list_head queue;
+};
+
+// CLOCK (second chance): hits only set a reference bit, so a hit costs no
+// list operation. The hand sweeps from the head, clearing bits and rotating
+// referenced entries to the tail.
+template <typename KEY> class ClockPolicy {
+public:
+  ClockPolicy() {
+    INIT_LIST_HEAD(&this->queue);
+    this->count = 0;
+  }
+
+  void init(size_t max_size) {}
+
+  void insert(CachePolicyNode *node, const KEY &key) {
+    node->freq = 0;
+    node->pinned = true;
+  }
+
+  void access(CachePolicyNode *node) { node->freq = 1; }
+
+  void pin(CachePolicyNode *node) {
+    list_del(&node->list);
+    node->pinned = true;
+    this->count--;
+  }
+
+  void unpin(CachePolicyNode *node) {
+    list_add_tail(&node->list, &this->queue);
+    node->pinned = false;
+    this->count++;
+  }
+
+  void erase(CachePolicyNode *node) {
+    if (!node->pinned)
+      this->pin(node);
+  }
+
+  void evict(CachePolicyNode *node) { this->pin(node); }
+
+  // Every turn clears a bit, so the hand stops within count + 1 turns.
+  CachePolicyNode *victim() {
+    CachePolicyNode *node;
+
+    while (this->count > 0) {
+      node = list_entry(this->queue.next, CachePolicyNode, list);
+      if (node->freq == 0)
+        return node;
+
+      node->freq = 0;
+      list_move_tail(&node->list, &this->queue);
+    }
+
+    return NULL;
+  }
+
+  // The first unreferenced entry from the hand, or the hand itself when
+  // all are referenced (the sweep clears them all and comes back to it).
+  CachePolicyNode *peek_victim() {
+    struct list_head *pos;
+    CachePolicyNode *node;
+
+    if (this->count == 0)
+      return NULL;
+
+    list_for_each(pos, &this->queue) {
+      node = list_entry(pos, CachePolicyNode, list);
+      if (node->freq == 0)
+        return node;
+    }
+
+    return list_entry(this->queue.next, CachePolicyNode, list);
+  }
+
+private:
+  struct list_head queue;
+  size_t count;
+};
+
+// S3-FIFO (SOSP'23): a small probationary FIFO (10% of capacity), a main
+// FIFO with lazy reinsertion, and a ghost FIFO of recently evicted keys.
+// New keys enter the small queue and are evicted from there unless hit
+// again, so one-hit wonders never reach the main queue. The ghost queue is
+// a direct-mapped table of key hashes; collisions only forget history.
+template <typename KEY, class HASH = std::hash<KEY>> class S3FIFOPolicy {
+public:
+  S3FIFOPolicy() {
+    INIT_LIST_HEAD(&this->small);
+    INIT_LIST_HEAD(&this->main);
+    this->small_count = 0;
+    this->main_count = 0;
+    this->small_target = 1;
+    this->ghost = NULL;
+    this->ghost_mask = 0;
+  }
+
+  ~S3FIFOPolicy() { delete[] this->ghost; }
+
+  void init(size_t max_size) {
+    size_t size = __cache_roundup_pow2(max_size);
+
+    delete[] this->ghost;
+    this->ghost = NULL;
+    this->ghost_mask = 0;
+    this->small_target = max_size / 10 > 0 ? max_size / 10 : 1;
+    if (max_size > 0) {
+      this->ghost = new size_t[size];
+      memset(this->ghost, 0, size * sizeof(size_t));
+      this->ghost_mask = size - 1;
+    }
+  }
+
+  void insert(CachePolicyNode *node, const KEY &key) {
+    node->hash = __cache_hash_mix(this->hasher(key)) | 1;
+    node->freq = 0;
+    node->pinned = true;
+    if (this->ghost &&
+        this->ghost[node->hash & this->ghost_mask] == node->hash) {
+      this->ghost[node->hash & this->ghost_mask] = 0;
+      node->queue = S3FIFO_MAIN;
+    } else
+      node->queue = S3FIFO_SMALL;
+  }
+
+  void access(CachePolicyNode *node) {
+    if (node->freq < 3)
+      node->freq++;
+  }
+
+  void pin(CachePolicyNode *node) {
+    list_del(&node->list);
+    node->pinned = true;
+    if (node->queue == S3FIFO_SMALL)
+      this->small_count--;
+    else
+      this->main_count--;
+  }
+
+  void unpin(CachePolicyNode *node) {
+    node->pinned = false;
+    if (node->queue == S3FIFO_SMALL) {
+      list_add_tail(&node->list, &this->small);
+      this->small_count++;
+    } else {
+      list_add_tail(&node->list, &this->main);
+      this->main_count++;
+    }
+  }
+
+  void erase(CachePolicyNode *node) {
+    if (!node->pinned)
+      this->pin(node);
+  }
+
+  void evict(CachePolicyNode *node) {
+    if (node->queue == S3FIFO_SMALL && this->ghost)
+      this->ghost[node->hash & this->ghost_mask] = node->hash;
+
+    this->pin(node);
+  }
+
+  // Every turn returns, promotes a small entry or lowers a frequency, so
+  // the loop ends.
+  CachePolicyNode *victim() {
+    CachePolicyNode *node;
+
+    while (this->small_count + this->main_count > 0) {
+      if (this->small_count > 0 && (this->small_count >= this->small_target ||
+                                    this->main_count == 0)) {
+        node = list_entry(this->small.next, CachePolicyNode, list);
+        if (node->freq == 0)
+          return node;
+
+        node->freq = 0;
+        node->queue = S3FIFO_MAIN;
+        list_move_tail(&node->list, &this->main);
+        this->small_count--;
+        this->main_count++;
+      } else {
+        node = list_entry(this->main.next, CachePolicyNode, list);
+        if (node->freq == 0)
+          return node;
+
+        node->freq--;
+        list_move_tail(&node->list, &this->main);
+      }
+    }
+
+    return NULL;
+  }
+
+  // The first unreferenced entry of the queue victim() would take from,
+  // without promoting or aging anything; the head of that queue if all are
+  // referenced.
+  CachePolicyNode *peek_victim() {
+    struct list_head *head;
+    struct list_head *pos;
+    CachePolicyNode *node;
+
+    if (this->small_count > 0 &&
+        (this->small_count >= this->small_target || this->main_count == 0))
+      head = &this->small;
+    else if (this->main_count > 0)
+      head = &this->main;
+    else
+      return NULL;
+
+    list_for_each(pos, head) {
+      node = list_entry(pos, CachePolicyNode, list);
+      if (node->freq == 0)
+        return node;
+    }
+
+    return list_entry(head->next, CachePolicyNode, list);
+  }
+
+private:
+  enum {
+    S3FIFO_SMALL = 0,
+    S3FIFO_MAIN = 1,
+  };
+
+  struct list_head small;
+  struct list_head main;
+  size_t small_count;
+  size_t main_count;
+  size_t small_target;
+  size_t *ghost;
+  size_t ghost_mask;
+  HASH hasher;
+
+  S3FIFOPolicy(const S3FIFOPolicy &) = delete;
+  S3FIFOPolicy &operator=(const S3FIFOPolicy &) = delete;
+};
+
+// Default admission: every put() is stored.
+template <typename KEY> class AlwaysAdmit {
+public:
+  void init(size_t max_size) {}
+  void record(const KEY &key) {}
+  bool admit(const KEY &candidate, const KEY &victim) { return true; }
+};
+
+// TinyLFU: a 4-row count-min sketch of 4-bit-saturating counters records
+// the popularity of every key looked up by get(), hit or miss; put() does
+// not count, so a key is popular only if it is asked for. When the cache is
+// full a new key is admitted only if it is estimated to be more popular than
+// the victim it would displace. All counters are halved every 10 * max_size
+// records so the estimate follows shifting popularity.
+template <typename KEY, class HASH = std::hash<KEY>> class TinyLFUAdmit {
+public:
+  TinyLFUAdmit() {
+    this->table = NULL;
+    this->mask = 0;
+    this->additions = 0;
+    this->sample_size = 0;
+  }
+
+  ~TinyLFUAdmit() { delete[] this->table; }
+
+  void init(size_t max_size) {
+    size_t width = __cache_roundup_pow2(max_size < 16 ? 16 : max_size);
+
+    delete[] this->table;
+    this->table = NULL;
+    if (max_size > 0) {
+      this->table = new uint8_t[TINYLFU_DEPTH * width];
+      memset(this->table, 0, TINYLFU_DEPTH * width);
+      this->mask = width - 1;
+      this->sample_size = 10 * max_size;
+      this->additions = 0;
+    }
+  }
+
+  void record(const KEY &key) {
+    size_t h = __cache_hash_mix(this->hasher(key));
+    uint8_t *counter;
+    bool added = false;
+    int i;
+
+    if (!this->table)
+      return;
+
+    for (i = 0; i < TINYLFU_DEPTH; i++) {
+      counter = this->counter_at(i, h);
+      if (*counter < 15) {
+        (*counter)++;
+        added = true;
+      }
+    }
+
+    if (added && ++this->additions >= this->sample_size)
+      this->reset();
+  }
+
+  bool admit(const KEY &candidate, const KEY &victim) {
+    if (!this->table)
+      return true;
+
+    return this->estimate(candidate) > this->estimate(victim);
+  }
+
+  unsigned int estimate(const KEY &key) {
+    size_t h = __cache_hash_mix(this->hasher(key));
+    unsigned int min = 15;
+    int i;
+
+    for (i = 0; i < TINYLFU_DEPTH; i++) {
+      if (*this->counter_at(i, h) < min)
+        min = *this->counter_at(i, h);
+    }
+
+    return min;
+  }
+
+private:
+  enum {
+    TINYLFU_DEPTH = 4,
+  };
+
+  uint8_t *counter_at(int row, size_t h) {
+    size_t step = (h >> 32) | 1;
+
+    return &this->table[row * (this->mask + 1) +
+                        ((h + row * step) & this->mask)];
+  }
+
+  void reset() {
+    size_t i;
+
+    for (i = 0; i < TINYLFU_DEPTH * (this->mask + 1); i++)
+      this->table[i] >>= 1;
+
+    this->additions /= 2;
+  }
+
+  uint8_t *table;
+  size_t mask;
+  size_t additions;
+  size_t sample_size;
+  HASH hasher;
+
+  TinyLFUAdmit(const TinyLFUAdmit &) = delete;
+  TinyLFUAdmit &operator=(const TinyLFUAdmit &) = delete;
+};
+
+#endif
@@ -24,16 +24,87 @@
 
 #define ALIGN(x,a) (((x)+(a)-1)&~((a)-1))
 #define ENCODE_BUF_SIZE		1024
+#define ENCODE_POOL_MAX		64
 
 struct EncodeBuf
 {
 	struct list_head list;
 	char *pos;
+	size_t size;
 	char data[ENCODE_BUF_SIZE];
 };
 
+/* 1 while the pool of the thread is alive, -1 once it is destroyed. Plain
+ * data, so it is still valid after the thread-local destructors have run. */
+static thread_local int __encode_buf_pool_state;
+
+/* Buffers of ENCODE_BUF_SIZE freed by the streams of a thread, for the next
+ * streams of the same thread. Encoding allocates nothing once it is warm. */
+class EncodeBufPool
+{
+public:
+	EncodeBufPool()
+	{
+		INIT_LIST_HEAD(&this->list);
+		this->count = 0;
+		__encode_buf_pool_state = 1;
+	}
+
+	~EncodeBufPool()
+	{
+		struct list_head *pos, *tmp;
+
+		__encode_buf_pool_state = -1;
+		list_for_each_safe(pos, tmp, &this->list)
+			delete [](char *)list_entry(pos, struct EncodeBuf, list);
+	}
+
+public:
+	struct list_head list;
+	int count;
+};
+
+static thread_local EncodeBufPool __encode_buf_pool;
+
+/* A stream destroyed after the pool, e.g. a static one at exit, allocates
+ * and frees its buffers directly. */
+static inline EncodeBufPool *__get_encode_buf_pool()
+{
+	if (__encode_buf_pool_state < 0)
+		return NULL;
+
+	return &__encode_buf_pool;
+}
+
+static struct EncodeBuf *__alloc_encode_buf(size_t size)
+{
+	EncodeBufPool *pool = __get_encode_buf_pool();
+	struct EncodeBuf *buf;
+
+	if (size > ENCODE_BUF_SIZE)
+	{
+		size = ALIGN(size, 8);
+		buf = (struct EncodeBuf *)new char[offsetof(struct EncodeBuf, data) + size];
+		buf->size = size;
+	}
+	else if (pool && pool->count > 0)
+	{
+		buf = list_entry(pool->list.next, struct EncodeBuf, list);
+		list_del(&buf->list);
+		pool->count--;
+	}
+	else
+	{
+		buf = (struct EncodeBuf *)new char[sizeof (struct EncodeBuf)];
+		buf->size = ENCODE_BUF_SIZE;
+	}
+
+	return buf;
+}
+
 void EncodeStream::clear_buf_data()
 {
+	EncodeBufPool *pool = __get_encode_buf_pool();
 	struct list_head *pos, *tmp;
 	struct EncodeBuf *entry;
 
@@ -41,7 +112,14 @@ void EncodeStream::clear_buf_data()
 	{
 		entry = list_entry(pos, struct EncodeBuf, list);
 		list_del(pos);
-		delete [](char *)entry;
+		if (pool && entry->size == ENCODE_BUF_SIZE &&
+			pool->count < ENCODE_POOL_MAX)
+		{
+			list_add(pos, &pool->list);
+			pool->count++;
+		}
+		else
+			delete [](char *)entry;
 	}
 }
 
@@ -49,16 +127,10 @@ void EncodeStream::merge()
 {
 	size_t len = bytes_ - merged_bytes_;
 	struct EncodeBuf *buf;
-	size_t n;
 	char *p;
 	int i;
 
-	if (len > ENCODE_BUF_SIZE)
-		n = offsetof(struct EncodeBuf, data) + ALIGN(len, 8);
-	else
-		n = sizeof (struct EncodeBuf);
-
-	buf = (struct EncodeBuf *)new char[n];
+	buf = __alloc_encode_buf(len);
 	p = buf->data;
 	for (i = merged_size_; i < size_; i++)
 	{
@@ -95,8 +167,25 @@ void EncodeStream::append_nocopy(const char *data, size_t len)
 	bytes_ += len;
 }
 
-void EncodeStream::append_copy(const char *data, size_t len)
+char *EncodeStream::reserve(size_t size)
+{
+	struct EncodeBuf *buf = list_entry(buf_list_.prev, struct EncodeBuf, list);
+
+	if (list_empty(&buf_list_) || buf->pos + size > buf->data + ENCODE_BUF_SIZE)
+	{
+		buf = __alloc_encode_buf(size);
+		buf->pos = buf->data;
+		list_add_tail(&buf->list, &buf_list_);
+	}
+
+	return buf->pos;
+}
+
+void EncodeStream::commit(size_t size)
 {
+	if (size_ > max_)
+		return;
+
 	if (size_ >= max_)
 	{
 		if (merged_size_ + 1 < max_)
@@ -108,30 +197,21 @@ void EncodeStream::append_copy(const char *data, size_t len)
 		}
 	}
 
+	/* merge() adds its buffer to the head, the reserved one is still last. */
 	struct EncodeBuf *buf = list_entry(buf_list_.prev, struct EncodeBuf, list);
 
-	if (list_empty(&buf_list_) || buf->pos + len > buf->data + ENCODE_BUF_SIZE)
-	{
-		size_t n;
-
-		if (len > ENCODE_BUF_SIZE)
-			n = offsetof(struct EncodeBuf, data) + ALIGN(len, 8);
-		else
-			n = sizeof (struct EncodeBuf);
-
-		buf = (struct EncodeBuf *)new char[n];
-		buf->pos = buf->data;
-		list_add_tail(&buf->list, &buf_list_);
-	}
-
-	memcpy(buf->pos, data, len);
 	vec_[size_].iov_base = buf->pos;
-	vec_[size_].iov_len = len;
+	vec_[size_].iov_len = size;
 	size_++;
-	bytes_ += len;
+	bytes_ += size;
 
-	buf->pos += ALIGN(len, 8);
+	buf->pos += ALIGN(size, 8);
 	if (buf->pos >= buf->data + ENCODE_BUF_SIZE)
 		list_move(&buf->list, &buf_list_);
 }
 
+void EncodeStream::append_copy(const char *data, size_t len)
+{
+	memcpy(reserve(len), data, len);
+	commit(len);
+}
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <string>
 #include "../kernel/list.h"
+#include "StringUtil.h"
 
 /**
  * @file   EncodeStream.h
@@ -82,6 +83,12 @@ public:
 		append_copy(data.c_str(), data.size());
 	}
 
+	// append_copy() without the copy: write up to 'size' bytes into the
+	// buffer returned by reserve(), then commit() the bytes written.
+	// Nothing else may be appended in between.
+	char *reserve(size_t size);
+	void commit(size_t size);
+
 private:
 	void init_vec(struct iovec *vectors, int max)
 	{
@@ -130,7 +137,7 @@ static inline EncodeStream& operator << (EncodeStream& stream,
 static inline EncodeStream& operator << (EncodeStream& stream,
 										 int64_t intv)
 {
-	stream.append_copy(std::to_string(intv));
+	stream.commit(StringUtil::format_int64(intv, stream.reserve(20)));
 	return stream;
 }
 
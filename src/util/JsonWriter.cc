@@ -0,0 +1,567 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/util/JsonWriter.cc
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "HttpMessage.h"
+#include "EncodeStream.h"
+#include "StringUtil.h"
+#include "json_parser.h"
+#include "JsonWriter.h"
+
+/*
+ * Output is written into chunks reserved from the sink. They start small,
+ * so that a short reply takes one small block, and double up to the max.
+ */
+#define JSON_WRITER_CHUNK_MIN	512
+#define JSON_WRITER_CHUNK_MAX	16384
+
+static inline bool __json_plain(char c)
+{
+	return c != '\"' && c != '\\' && (unsigned char)c >= 0x20;
+}
+
+/*
+ * SIMD spans. Each returns how many leading bytes of the full 16/32-byte
+ * blocks need no escaping, stopping at the first byte that does.
+ */
+#ifdef __SSE2__
+# include <immintrin.h>
+
+static size_t __sse2_span_plain(const char *s, size_t len)
+{
+	__m128i quote = _mm_set1_epi8('\"');
+	__m128i backslash = _mm_set1_epi8('\\');
+	__m128i ctrl_min = _mm_set1_epi8(-1);
+	__m128i ctrl_max = _mm_set1_epi8(0x20);
+	__m128i x, m;
+	size_t i;
+	int mask;
+
+	for (i = 0; i + 16 <= len; i += 16)
+	{
+		x = _mm_loadu_si128((const __m128i *)(s + i));
+		m = _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash));
+		m = _mm_or_si128(m, _mm_and_si128(_mm_cmpgt_epi8(x, ctrl_min),
+										  _mm_cmplt_epi8(x, ctrl_max)));
+		mask = _mm_movemask_epi8(m);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i;
+}
+
+# if defined(__GNUC__) && defined(__x86_64__)
+#  define JSON_WRITER_AVX2
+
+__attribute__((target("avx2")))
+static size_t __avx2_span_plain(const char *s, size_t len)
+{
+	__m256i quote = _mm256_set1_epi8('\"');
+	__m256i backslash = _mm256_set1_epi8('\\');
+	__m256i ctrl_min = _mm256_set1_epi8(-1);
+	__m256i ctrl_max = _mm256_set1_epi8(0x20);
+	unsigned int mask;
+	__m256i x, m;
+	size_t i;
+
+	for (i = 0; i + 32 <= len; i += 32)
+	{
+		x = _mm256_loadu_si256((const __m256i *)(s + i));
+		m = _mm256_or_si256(_mm256_cmpeq_epi8(x, quote),
+							_mm256_cmpeq_epi8(x, backslash));
+		m = _mm256_or_si256(m, _mm256_and_si256(_mm256_cmpgt_epi8(x, ctrl_min),
+												_mm256_cmpgt_epi8(ctrl_max, x)));
+		mask = _mm256_movemask_epi8(m);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i;
+}
+# endif
+#endif
+
+static size_t __json_span_plain(const char *s, size_t len)
+{
+	size_t i = 0;
+
+	/* Most keys and values are too short for a SIMD block. */
+	if (len >= 16)
+	{
+#ifdef JSON_WRITER_AVX2
+		if (__builtin_cpu_supports("avx2"))
+			i = __avx2_span_plain(s, len);
+		else
+#endif
+#ifdef __SSE2__
+		i = __sse2_span_plain(s, len);
+#endif
+	}
+
+	while (i < len && __json_plain(s[i]))
+		i++;
+
+	return i;
+}
+
+static const double __power_of_10[10] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+/*
+ * Shortest text that reads back as the same double. Integers and short
+ * decimals, which are most numbers in practice, are m / 10^k for a small k
+ * and an integer m below 2^53. Both are exact, so the division is rounded
+ * exactly like reading the text back. Otherwise print 15, 16 and then 17
+ * significant digits until the text reads back.
+ */
+static size_t __format_double(double num, char *buf)
+{
+	double scaled;
+	int64_t m;
+	size_t n;
+	int k;
+
+	if (!isfinite(num))
+	{
+		memcpy(buf, "null", 4);
+		return 4;
+	}
+
+	/* -0.0 equals 0, the loop below would print it without the sign. */
+	if (num == 0)
+	{
+		if (!signbit(num))
+		{
+			*buf = '0';
+			return 1;
+		}
+
+		memcpy(buf, "-0", 2);
+		return 2;
+	}
+
+	for (k = 0; k < 10 && fabs(num) * __power_of_10[k] < 1e15; k++)
+	{
+		scaled = num * __power_of_10[k];
+		m = (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+		if ((double)m / __power_of_10[k] != num)
+			continue;
+
+		if (k == 0)
+			return StringUtil::format_int64(m, buf);
+
+		char digits[24];
+		char *p = buf;
+
+		if (m < 0)
+		{
+			*p++ = '-';
+			m = -m;
+		}
+
+		n = StringUtil::format_uint64(m, digits);
+		if (n <= (size_t)k)
+		{
+			*p++ = '0';
+			*p++ = '.';
+			memset(p, '0', k - n);
+			p += k - n;
+			memcpy(p, digits, n);
+			p += n;
+		}
+		else
+		{
+			memcpy(p, digits, n - k);
+			p += n - k;
+			*p++ = '.';
+			memcpy(p, digits + n - k, k);
+			p += k;
+		}
+
+		return p - buf;
+	}
+
+	/* Subnormals have fewer digits of precision. */
+	for (k = fabs(num) < DBL_MIN ? 1 : 15; k < 17; k++)
+	{
+		n = snprintf(buf, 32, "%.*g", k, num);
+		if (strtod(buf, NULL) == num)
+			return n;
+	}
+
+	return snprintf(buf, 32, "%.17g", num);
+}
+
+JsonWriter::JsonWriter(protocol::HttpMessage *msg)
+{
+	this->sink_type = SINK_HTTP_MESSAGE;
+	this->sink = msg;
+	this->begin = NULL;
+	this->cur = NULL;
+	this->end = NULL;
+	this->chunk_size = JSON_WRITER_CHUNK_MIN;
+	this->comma = false;
+	this->error = false;
+}
+
+JsonWriter::JsonWriter(EncodeStream *stream)
+{
+	this->sink_type = SINK_ENCODE_STREAM;
+	this->sink = stream;
+	this->begin = NULL;
+	this->cur = NULL;
+	this->end = NULL;
+	this->chunk_size = JSON_WRITER_CHUNK_MIN;
+	this->comma = false;
+	this->error = false;
+}
+
+JsonWriter::JsonWriter(std::string *str)
+{
+	this->sink_type = SINK_STRING;
+	this->sink = str;
+	this->begin = NULL;
+	this->cur = NULL;
+	this->end = NULL;
+	this->chunk_size = JSON_WRITER_CHUNK_MIN;
+	this->comma = false;
+	this->error = false;
+}
+
+bool JsonWriter::flush()
+{
+	size_t n = this->cur - this->begin;
+	std::string *str;
+
+	if (this->begin)
+	{
+		switch (this->sink_type)
+		{
+		case SINK_HTTP_MESSAGE:
+			((protocol::HttpMessage *)this->sink)->commit_output_body(n);
+			break;
+
+		case SINK_ENCODE_STREAM:
+			if (n > 0)
+				((EncodeStream *)this->sink)->commit(n);
+			break;
+
+		case SINK_STRING:
+			str = (std::string *)this->sink;
+			str->resize(this->begin - &(*str)[0] + n);
+			break;
+		}
+
+		this->begin = NULL;
+		this->cur = NULL;
+		this->end = NULL;
+	}
+
+	return !this->error;
+}
+
+bool JsonWriter::grow(size_t size)
+{
+	size_t n = this->chunk_size;
+	std::string *str;
+	size_t off;
+	char *p;
+
+	if (this->error)
+		return false;
+
+	this->flush();
+	if (n < size)
+		n = size;
+
+	switch (this->sink_type)
+	{
+	case SINK_HTTP_MESSAGE:
+		p = (char *)((protocol::HttpMessage *)this->sink)->reserve_output_body(n);
+		break;
+
+	case SINK_ENCODE_STREAM:
+		p = ((EncodeStream *)this->sink)->reserve(n);
+		break;
+
+	default:
+		str = (std::string *)this->sink;
+		off = str->size();
+		str->resize(off + n);
+		p = &(*str)[off];
+		break;
+	}
+
+	if (!p)
+	{
+		this->error = true;
+		return false;
+	}
+
+	this->begin = p;
+	this->cur = p;
+	this->end = p + n;
+	if (this->chunk_size < JSON_WRITER_CHUNK_MAX)
+		this->chunk_size *= 2;
+
+	return true;
+}
+
+void JsonWriter::put(const char *data, size_t len)
+{
+	size_t n;
+
+	while (len > 0)
+	{
+		if (this->cur == this->end && !this->grow(len))
+			return;
+
+		n = this->end - this->cur;
+		if (n > len)
+			n = len;
+
+		memcpy(this->cur, data, n);
+		this->cur += n;
+		data += n;
+		len -= n;
+	}
+}
+
+void JsonWriter::put_string(const char *str, size_t len)
+{
+	const char *end = str + len;
+	char esc[6] = { '\\', 'u', '0', '0' };
+	size_t n;
+
+	this->put_char('\"');
+	while (str < end)
+	{
+		n = __json_span_plain(str, end - str);
+		this->put(str, n);
+		str += n;
+		if (str == end)
+			break;
+
+		switch (*str)
+		{
+		case '\"':
+		case '\\':
+			esc[1] = *str;
+			n = 2;
+			break;
+		case '\b':
+			esc[1] = 'b';
+			n = 2;
+			break;
+		case '\f':
+			esc[1] = 'f';
+			n = 2;
+			break;
+		case '\n':
+			esc[1] = 'n';
+			n = 2;
+			break;
+		case '\r':
+			esc[1] = 'r';
+			n = 2;
+			break;
+		case '\t':
+			esc[1] = 't';
+			n = 2;
+			break;
+		default:
+			esc[1] = 'u';
+			esc[4] = "0123456789abcdef"[*str >> 4];
+			esc[5] = "0123456789abcdef"[*str & 15];
+			n = 6;
+			break;
+		}
+
+		this->put(esc, n);
+		str++;
+	}
+
+	this->put_char('\"');
+}
+
+void JsonWriter::put_value(const json_value_t *val)
+{
+	const json_value_t *child;
+	json_object_t *obj;
+	json_array_t *arr;
+	const char *name;
+	const char *str;
+	bool first = true;
+	char buf[32];
+
+	switch (json_value_type(val))
+	{
+	case JSON_VALUE_STRING:
+		str = json_value_string(val);
+		this->put_string(str, strlen(str));
+		break;
+
+	case JSON_VALUE_NUMBER:
+		this->put(buf, __format_double(json_value_number(val), buf));
+		break;
+
+	case JSON_VALUE_OBJECT:
+		obj = json_value_object(val);
+		name = NULL;
+		child = NULL;
+		this->put_char('{');
+		while ((name = json_object_next_name(name, obj)) != NULL)
+		{
+			child = json_object_next_value(child, obj);
+			if (!first)
+				this->put_char(',');
+
+			first = false;
+			this->put_string(name, strlen(name));
+			this->put_char(':');
+			this->put_value(child);
+		}
+
+		this->put_char('}');
+		break;
+
+	case JSON_VALUE_ARRAY:
+		arr = json_value_array(val);
+		child = NULL;
+		this->put_char('[');
+		while ((child = json_array_next_value(child, arr)) != NULL)
+		{
+			if (!first)
+				this->put_char(',');
+
+			first = false;
+			this->put_value(child);
+		}
+
+		this->put_char(']');
+		break;
+
+	case JSON_VALUE_TRUE:
+		this->put("true", 4);
+		break;
+
+	case JSON_VALUE_FALSE:
+		this->put("false", 5);
+		break;
+
+	default:
+		this->put("null", 4);
+		break;
+	}
+}
+
+JsonWriter& JsonWriter::begin_object()
+{
+	this->separate();
+	this->put_char('{');
+	this->comma = false;
+	return *this;
+}
+
+JsonWriter& JsonWriter::end_object()
+{
+	this->put_char('}');
+	this->comma = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::begin_array()
+{
+	this->separate();
+	this->put_char('[');
+	this->comma = false;
+	return *this;
+}
+
+JsonWriter& JsonWriter::end_array()
+{
+	this->put_char(']');
+	this->comma = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::key(const char *name, size_t len)
+{
+	this->separate();
+	this->put_string(name, len);
+	this->put_char(':');
+	this->comma = false;
+	return *this;
+}
+
+JsonWriter& JsonWriter::string(const char *str, size_t len)
+{
+	this->separate();
+	this->put_string(str, len);
+	return *this;
+}
+
+JsonWriter& JsonWriter::number(double num)
+{
+	char buf[32];
+
+	this->separate();
+	this->put(buf, __format_double(num, buf));
+	return *this;
+}
+
+JsonWriter& JsonWriter::integer(int64_t num)
+{
+	char buf[24];
+
+	this->separate();
+	this->put(buf, StringUtil::format_int64(num, buf));
+	return *this;
+}
+
+JsonWriter& JsonWriter::boolean(bool b)
+{
+	this->separate();
+	if (b)
+		this->put("true", 4);
+	else
+		this->put("false", 5);
+
+	return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+	this->separate();
+	this->put("null", 4);
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const json_value_t *val)
+{
+	this->separate();
+	this->put_value(val);
+	return *this;
+}
+
+JsonWriter& JsonWriter::raw(const char *json, size_t len)
+{
+	this->separate();
+	this->put(json, len);
+	return *this;
+}
+
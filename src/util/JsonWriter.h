@@ -0,0 +1,141 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/src/util/JsonWriter.h
+ * @Description  :
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#ifndef _JSONWRITER_H_
+#define _JSONWRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "EncodeStream.h"
+#include "json_parser.h"
+
+/**
+ * @file   JsonWriter.h
+ * @brief  Streaming JSON serializer
+ */
+
+namespace protocol
+{
+class HttpMessage;
+}
+
+/*
+ * Writes JSON text straight into the output body of an HttpMessage, an
+ * EncodeStream or a std::string, a chunk at a time, without building the
+ * text anywhere else first.
+ *
+ *   JsonWriter writer(resp);
+ *   writer.begin_object().key("code").integer(0).key("data").value(val);
+ *   writer.end_object();
+ *   if (!writer.flush())
+ *       ...
+ *
+ * The calls are not checked: a key is expected before every value inside
+ * an object, and every begin_*() needs its end_*(). Numbers that are not
+ * finite are written as null. Strings are expected to be UTF-8 and only
+ * '"', '\\' and control characters are escaped.
+ */
+class JsonWriter
+{
+public:
+	JsonWriter(protocol::HttpMessage *msg);
+	JsonWriter(EncodeStream *stream);
+	JsonWriter(std::string *str);
+	~JsonWriter() { this->flush(); }
+
+	JsonWriter& begin_object();
+	JsonWriter& end_object();
+	JsonWriter& begin_array();
+	JsonWriter& end_array();
+
+	JsonWriter& key(const char *name, size_t len);
+
+	JsonWriter& key(const char *name)
+	{
+		return this->key(name, strlen(name));
+	}
+
+	JsonWriter& key(const std::string& name)
+	{
+		return this->key(name.c_str(), name.size());
+	}
+
+	JsonWriter& string(const char *str, size_t len);
+
+	JsonWriter& string(const char *str)
+	{
+		return this->string(str, strlen(str));
+	}
+
+	JsonWriter& string(const std::string& str)
+	{
+		return this->string(str.c_str(), str.size());
+	}
+
+	JsonWriter& number(double num);
+	JsonWriter& integer(int64_t num);
+	JsonWriter& boolean(bool b);
+	JsonWriter& null();
+
+	// A whole json_value_t, e.g. one from json_value_parse().
+	JsonWriter& value(const json_value_t *val);
+
+	// JSON text that is already encoded, written as one value.
+	JsonWriter& raw(const char *json, size_t len);
+
+	// Hands the buffered text over to the output. false if anything
+	// failed to allocate since the writer was created.
+	bool flush();
+
+private:
+	bool grow(size_t size);
+	void put(const char *data, size_t len);
+	void put_string(const char *str, size_t len);
+	void put_value(const json_value_t *val);
+
+	void put_char(char c)
+	{
+		if (this->cur < this->end || this->grow(1))
+			*this->cur++ = c;
+	}
+
+	void separate()
+	{
+		if (this->comma)
+			this->put_char(',');
+
+		this->comma = true;
+	}
+
+private:
+	enum
+	{
+		SINK_HTTP_MESSAGE,
+		SINK_ENCODE_STREAM,
+		SINK_STRING,
+	};
+
+	int sink_type;
+	void *sink;
+	char *begin;
+	char *cur;
+	char *end;
+	size_t chunk_size;
+	bool comma;
+	bool error;
+
+	JsonWriter(const JsonWriter&) = delete;
+	JsonWriter& operator = (const JsonWriter&) = delete;
+};
+
+#endif
+
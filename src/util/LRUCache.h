@@ -22,6 +22,7 @@
 
 #include "../kernel/list.h"
 #include "../kernel/rbtree.h"
+#include "CachePolicy.h"
 #include <assert.h>
 
 /**
@@ -39,20 +40,30 @@ public:
 private:
   LRUHandle(const KEY &k, const VALUE &v) : value(v), key(k) {}
 
+  static LRUHandle *of(CachePolicyNode *node) {
+    return list_entry(node, LRUHandle, node);
+  }
+
   KEY key;
   struct list_head list;
   struct rb_node rb;
+  struct CachePolicyNode node;
   bool in_cache;
   int ref;
 
-  template <typename, typename, class> friend class LRUCache;
+  template <typename, typename, class, class, class> friend class LRUCache;
 };
 
 // RAII: NO. Release ref by LRUCache::release
 // Define ValueDeleter(VALUE& v) for value deleter
 // Thread safety: NO
 // Make sure KEY operator< usable
-template <typename KEY, typename VALUE, class ValueDeleter> class LRUCache {
+// Policy chooses victims: LRUPolicy, ClockPolicy or S3FIFOPolicy.
+// Admission filters put() on a full cache: AlwaysAdmit or TinyLFUAdmit.
+// S3FIFOPolicy and TinyLFUAdmit also need a KEY hash (std::hash by default).
+template <typename KEY, typename VALUE, class ValueDeleter,
+          class Policy = LRUPolicy<KEY>, class Admission = AlwaysAdmit<KEY>>
+class LRUCache {
 protected:
   typedef LRUHandle<KEY, VALUE> Handle;
 
@@ -82,7 +93,12 @@ public:
 
   // default max_size=0 means no-limit cache
   // max_size means max cache number of key-value pairs
-  void set_max_size(size_t max_size) { this->max_size = max_size; }
+  // Call before the first put, resizing drops policy history.
+  void set_max_size(size_t max_size) {
+    this->max_size = max_size;
+    this->policy.init(max_size);
+    this->admission.init(max_size);
+  }
 
   // Remove all cache that are not actively in use.
   void prune() {
@@ -105,29 +121,21 @@ public:
   // get handler
   // Need call release when handle no longer needed
   const Handle *get(const KEY &key) {
-    struct rb_node *p = this->cache_map.rb_node;
-    Handle *bound = NULL;
-    Handle *e;
-
-    while (p) {
-      e = rb_entry(p, Handle, rb);
-      if (!(e->key < key)) {
-        bound = e;
-        p = p->rb_left;
-      } else
-        p = p->rb_right;
-    }
+    Handle *e = this->find(key);
 
-    if (bound && !(key < bound->key)) {
-      this->ref(bound);
-      return bound;
+    this->admission.record(key);
+    if (e) {
+      this->policy.access(&e->node);
+      this->ref(e);
     }
 
-    return NULL;
+    return e;
   }
 
   // put copy
   // Need call release when handle no longer needed
+  // If Admission rejects the key, the returned handle is not in the cache
+  // and its value is deleted on release.
   const Handle *put(const KEY &key, VALUE value) {
     struct rb_node **p = &this->cache_map.rb_node;
     struct rb_node *parent = NULL;
@@ -144,13 +152,27 @@ public:
         p = &(*p)->rb_right;
     }
 
+    if (bound && key < bound->key)
+      bound = NULL;
+
+    if (!bound && this->max_size > 0 && this->size >= this->max_size) {
+      CachePolicyNode *node = this->policy.peek_victim();
+
+      if (node && !this->admission.admit(key, Handle::of(node)->key)) {
+        e = new Handle(key, value);
+        e->in_cache = false;
+        e->ref = 1;
+        return e;
+      }
+    }
+
     e = new Handle(key, value);
     e->in_cache = true;
     e->ref = 2;
     list_add_tail(&e->list, &this->in_use);
     this->size++;
 
-    if (bound && !(key < bound->key)) {
+    if (bound) {
       rb_replace_node(&bound->rb, &e->rb, &this->cache_map);
       this->erase_node(bound);
     } else {
@@ -158,12 +180,17 @@ public:
       rb_insert_color(&e->rb, &this->cache_map);
     }
 
+    this->policy.insert(&e->node, key);
     if (this->max_size > 0) {
-      while (this->size > this->max_size && !list_empty(&this->not_use)) {
-        Handle *tmp = list_entry(this->not_use.next, Handle, list);
+      CachePolicyNode *node;
+
+      while (this->size > this->max_size &&
+             (node = this->policy.victim()) != NULL) {
+        Handle *tmp = Handle::of(node);
         assert(tmp->ref == 1);
         rb_erase(&tmp->rb, &this->cache_map);
-        this->erase_node(tmp);
+        this->policy.evict(&tmp->node);
+        this->unlink_node(tmp);
       }
     }
 
@@ -172,19 +199,40 @@ public:
 
   // delete from cache, deleter delay called when all inuse-handle release.
   void del(const KEY &key) {
-    Handle *e = const_cast<Handle *>(this->get(key));
+    Handle *e = this->find(key);
 
     if (e) {
-      this->unref(e);
       rb_erase(&e->rb, &this->cache_map);
       this->erase_node(e);
     }
   }
 
 private:
+  Handle *find(const KEY &key) {
+    struct rb_node *p = this->cache_map.rb_node;
+    Handle *bound = NULL;
+    Handle *e;
+
+    while (p) {
+      e = rb_entry(p, Handle, rb);
+      if (!(e->key < key)) {
+        bound = e;
+        p = p->rb_left;
+      } else
+        p = p->rb_right;
+    }
+
+    if (bound && !(key < bound->key))
+      return bound;
+
+    return NULL;
+  }
+
   void ref(Handle *e) {
-    if (e->in_cache && e->ref == 1)
+    if (e->in_cache && e->ref == 1) {
       list_move_tail(&e->list, &this->in_use);
+      this->policy.pin(&e->node);
+    }
 
     e->ref++;
   }
@@ -195,11 +243,18 @@ private:
       assert(!e->in_cache);
       this->value_deleter(e->value);
       delete e;
-    } else if (e->in_cache && e->ref == 1)
+    } else if (e->in_cache && e->ref == 1) {
       list_move_tail(&e->list, &this->not_use);
+      this->policy.unpin(&e->node);
+    }
   }
 
   void erase_node(Handle *e) {
+    this->policy.erase(&e->node);
+    this->unlink_node(e);
+  }
+
+  void unlink_node(Handle *e) {
     assert(e->in_cache);
     list_del(&e->list);
     e->in_cache = false;
@@ -214,6 +269,8 @@ private:
   struct list_head in_use;
   struct rb_root cache_map;
 
+  Policy policy;
+  Admission admission;
   ValueDeleter value_deleter;
 };
 
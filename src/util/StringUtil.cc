@@ -17,28 +17,23 @@
 */
 
 #include <ctype.h>
+#include <stdint.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include "StringUtil.h"
 
-static int __htoi(unsigned char *s)
+static inline int __hexval(char c)
 {
-	int value;
-	int c;
+	if (c >= '0' && c <= '9')
+		return c - '0';
 
-	c = s[0];
-	if (isupper(c))
-		c = tolower(c);
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
 
-	value = (c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10) * 16;
-
-	c = s[1];
-	if (isupper(c))
-		c = tolower(c);
-
-	value += (c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10);
-	return value;
+	return -1;
 }
 
 static inline char __itoh(int n)
@@ -49,96 +44,330 @@ static inline char __itoh(int n)
 	return n + '0';
 }
 
-static size_t __url_decode(char *str)
+static inline bool __url_unreserved(char c, bool component)
 {
-	char *dest = str;
-	char *data = str;
+	if (isalnum((unsigned char)c))
+		return true;
 
-	while (*data)
+	switch (c)
 	{
-		if (*data == '%' && isxdigit(data[1]) && isxdigit(data[2]))
-		{
-			*dest = __htoi((unsigned char *)data + 1);
-			data += 2;
-		}
-		else if (*data == '+')
-			*dest = ' ';
-		else
-			*dest = *data;
+	case '-': case '_': case '.': case '!': case '~':
+	case '*': case '\'': case '(': case ')':
+		return true;
+	case ':': case '/': case '@': case '?': case '#': case '&':
+		return !component;
+	default:
+		return false;
+	}
+}
 
-		data++;
-		dest++;
+/*
+ * SIMD spans. Each returns how many leading bytes of the full 16/32-byte
+ * blocks are unreserved (or are neither '%' nor '+'), stopping at the first
+ * byte that is not. The byte loop of the caller finishes the tail.
+ * SSE2 is always there on x86_64; AVX2 is picked at run time.
+ */
+#ifdef __SSE2__
+# include <immintrin.h>
+
+/*
+ * Unreserved bytes as 5 ranges and 4 single bytes, indexed by 'component'.
+ * Ranges and bytes are repeated to fill the slots.
+ */
+static const char __url_ranges[2][5][2] = {
+	/* alnum -_.!~*'() :/@?#& */
+	{ {'a', 'z'}, {'&', '*'}, {'-', ':'}, {'?', 'Z'}, {'?', 'Z'} },
+	/* alnum -_.!~*'() */
+	{ {'a', 'z'}, {'\'', '*'}, {'-', '.'}, {'0', '9'}, {'A', 'Z'} },
+};
+
+static const char __url_singles[2][4] = {
+	{ '~', '_', '!', '#' },
+	{ '~', '_', '!', '!' },
+};
+
+#define SSE2_IN_RANGE(x, i) \
+	_mm_and_si128(_mm_cmpgt_epi8(x, lo##i), _mm_cmpgt_epi8(hi##i, x))
+
+static size_t __sse2_span_unreserved(const char *s, size_t len, bool component)
+{
+	const char (*r)[2] = __url_ranges[component];
+	const char *e = __url_singles[component];
+	__m128i lo0 = _mm_set1_epi8(r[0][0] - 1), hi0 = _mm_set1_epi8(r[0][1] + 1);
+	__m128i lo1 = _mm_set1_epi8(r[1][0] - 1), hi1 = _mm_set1_epi8(r[1][1] + 1);
+	__m128i lo2 = _mm_set1_epi8(r[2][0] - 1), hi2 = _mm_set1_epi8(r[2][1] + 1);
+	__m128i lo3 = _mm_set1_epi8(r[3][0] - 1), hi3 = _mm_set1_epi8(r[3][1] + 1);
+	__m128i lo4 = _mm_set1_epi8(r[4][0] - 1), hi4 = _mm_set1_epi8(r[4][1] + 1);
+	__m128i e0 = _mm_set1_epi8(e[0]), e1 = _mm_set1_epi8(e[1]);
+	__m128i e2 = _mm_set1_epi8(e[2]), e3 = _mm_set1_epi8(e[3]);
+	__m128i x, m;
+	size_t i;
+	int mask;
+
+	for (i = 0; i + 16 <= len; i += 16)
+	{
+		x = _mm_loadu_si128((const __m128i *)(s + i));
+		m = _mm_or_si128(SSE2_IN_RANGE(x, 0), SSE2_IN_RANGE(x, 1));
+		m = _mm_or_si128(m, _mm_or_si128(SSE2_IN_RANGE(x, 2), SSE2_IN_RANGE(x, 3)));
+		m = _mm_or_si128(m, SSE2_IN_RANGE(x, 4));
+		m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(x, e0), _mm_cmpeq_epi8(x, e1)));
+		m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(x, e2), _mm_cmpeq_epi8(x, e3)));
+		mask = _mm_movemask_epi8(m) ^ 0xffff;
+		if (mask)
+			return i + __builtin_ctz(mask);
 	}
 
-	*dest = '\0';
-	return dest - str;
+	return i;
 }
 
-void StringUtil::url_decode(std::string& str)
+static size_t __sse2_span_plain(const char *s, size_t len)
 {
-	if (str.empty())
-		return;
+	__m128i pct = _mm_set1_epi8('%');
+	__m128i plus = _mm_set1_epi8('+');
+	__m128i x;
+	size_t i;
+	int mask;
 
-	size_t sz = __url_decode(const_cast<char *>(str.c_str()));
+	for (i = 0; i + 16 <= len; i += 16)
+	{
+		x = _mm_loadu_si128((const __m128i *)(s + i));
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, pct),
+											  _mm_cmpeq_epi8(x, plus)));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
 
-	str.resize(sz);
+	return i;
 }
 
-std::string StringUtil::url_encode(const std::string& str)
+# if defined(__GNUC__) && defined(__x86_64__)
+#  define URL_CODEC_AVX2
+
+#define AVX2_IN_RANGE(x, i) \
+	_mm256_and_si256(_mm256_cmpgt_epi8(x, lo##i), _mm256_cmpgt_epi8(hi##i, x))
+
+__attribute__((target("avx2")))
+static size_t __avx2_span_unreserved(const char *s, size_t len, bool component)
 {
-	const char *cur = str.c_str();
-	const char *ed = cur + str.size();
-	std::string res;
+	const char (*r)[2] = __url_ranges[component];
+	const char *e = __url_singles[component];
+	__m256i lo0 = _mm256_set1_epi8(r[0][0] - 1), hi0 = _mm256_set1_epi8(r[0][1] + 1);
+	__m256i lo1 = _mm256_set1_epi8(r[1][0] - 1), hi1 = _mm256_set1_epi8(r[1][1] + 1);
+	__m256i lo2 = _mm256_set1_epi8(r[2][0] - 1), hi2 = _mm256_set1_epi8(r[2][1] + 1);
+	__m256i lo3 = _mm256_set1_epi8(r[3][0] - 1), hi3 = _mm256_set1_epi8(r[3][1] + 1);
+	__m256i lo4 = _mm256_set1_epi8(r[4][0] - 1), hi4 = _mm256_set1_epi8(r[4][1] + 1);
+	__m256i e0 = _mm256_set1_epi8(e[0]), e1 = _mm256_set1_epi8(e[1]);
+	__m256i e2 = _mm256_set1_epi8(e[2]), e3 = _mm256_set1_epi8(e[3]);
+	__m256i x, m;
+	unsigned int mask;
+	size_t i;
+
+	for (i = 0; i + 32 <= len; i += 32)
+	{
+		x = _mm256_loadu_si256((const __m256i *)(s + i));
+		m = _mm256_or_si256(AVX2_IN_RANGE(x, 0), AVX2_IN_RANGE(x, 1));
+		m = _mm256_or_si256(m, _mm256_or_si256(AVX2_IN_RANGE(x, 2), AVX2_IN_RANGE(x, 3)));
+		m = _mm256_or_si256(m, AVX2_IN_RANGE(x, 4));
+		m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(x, e0),
+											   _mm256_cmpeq_epi8(x, e1)));
+		m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(x, e2),
+											   _mm256_cmpeq_epi8(x, e3)));
+		mask = ~(unsigned int)_mm256_movemask_epi8(m);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i;
+}
 
-	while (cur < ed)
+__attribute__((target("avx2")))
+static size_t __avx2_span_plain(const char *s, size_t len)
+{
+	__m256i pct = _mm256_set1_epi8('%');
+	__m256i plus = _mm256_set1_epi8('+');
+	unsigned int mask;
+	__m256i x;
+	size_t i;
+
+	for (i = 0; i + 32 <= len; i += 32)
+	{
+		x = _mm256_loadu_si256((const __m256i *)(s + i));
+		mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, pct),
+													_mm256_cmpeq_epi8(x, plus)));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i;
+}
+# endif
+#endif
+
+static size_t __url_span_unreserved(const char *s, size_t len, bool component)
+{
+#ifdef URL_CODEC_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return __avx2_span_unreserved(s, len, component);
+#endif
+#ifdef __SSE2__
+	return __sse2_span_unreserved(s, len, component);
+#else
+	return 0;
+#endif
+}
+
+static size_t __url_span_plain(const char *s, size_t len)
+{
+#ifdef URL_CODEC_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return __avx2_span_plain(s, len);
+#endif
+#ifdef __SSE2__
+	return __sse2_span_plain(s, len);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Escaped bytes tend to come in runs (UTF-8 text, form data), so the codec
+ * goes byte by byte and only switches to the SIMD spans after URL_SIMD_RUN
+ * bytes in a row passed through unchanged.
+ */
+#define URL_SIMD_RUN	16
+
+/* 'out' may be 'str' itself. */
+static size_t __url_decode(const char *str, size_t len, char *out)
+{
+	const char *end = str + len;
+	char *dest = out;
+	int run = 0;
+	size_t n;
+
+	int hi, lo;
+
+	while (str < end)
 	{
-		if (*cur == ' ')
-			res += '+';
-		else if (isalnum(*cur) || *cur == '-' || *cur == '_' || *cur == '.' ||
-				 *cur == '!' || *cur == '~' || *cur == '*' || *cur == '\'' ||
-				 *cur == '(' || *cur == ')' || *cur == ':' || *cur == '/' ||
-				 *cur == '@' || *cur == '?' || *cur == '#' || *cur == '&')
-			res += *cur;
+		if (*str == '%' && end - str > 2 &&
+			(hi = __hexval(str[1])) >= 0 && (lo = __hexval(str[2])) >= 0)
+		{
+			*dest = hi * 16 + lo;
+			str += 2;
+		}
+		else if (*str == '+')
+			*dest = ' ';
 		else
 		{
-			res += '%';
-			res += __itoh(((const unsigned char)(*cur)) >> 4);
-			res += __itoh(((const unsigned char)(*cur)) % 16);
+			*dest++ = *str++;
+			if (++run == URL_SIMD_RUN)
+			{
+				n = __url_span_plain(str, end - str);
+				if (dest != str)
+					memmove(dest, str, n);
+
+				dest += n;
+				str += n;
+				run = 0;
+			}
+
+			continue;
 		}
 
-		cur++;
+		run = 0;
+		str++;
+		dest++;
 	}
 
-	return res;
+	return dest - out;
 }
 
-std::string StringUtil::url_encode_component(const std::string& str)
+static size_t __url_encode(const char *str, size_t len, char *out,
+						   bool component)
 {
-	const char *cur = str.c_str();
-	const char *ed = cur + str.size();
-	std::string res;
+	const char *end = str + len;
+	char *dest = out;
+	int run = 0;
+	size_t n;
 
-	while (cur < ed)
+	while (str < end)
 	{
-		if (*cur == ' ')
-			res += '+';
-		else if (isalnum(*cur) || *cur == '-' || *cur == '_' || *cur == '.' ||
-				 *cur == '!' || *cur == '~' || *cur == '*' || *cur == '\'' ||
-				 *cur == '(' || *cur == ')')
-			res += *cur;
+		if (__url_unreserved(*str, component))
+		{
+			*dest++ = *str++;
+			if (++run == URL_SIMD_RUN)
+			{
+				n = __url_span_unreserved(str, end - str, component);
+				memcpy(dest, str, n);
+				dest += n;
+				str += n;
+				run = 0;
+			}
+
+			continue;
+		}
+
+		if (*str == ' ')
+			*dest++ = '+';
 		else
 		{
-			res += '%';
-			res += __itoh(((const unsigned char)(*cur)) >> 4);
-			res += __itoh(((const unsigned char)(*cur)) % 16);
+			*dest++ = '%';
+			*dest++ = __itoh(((const unsigned char)(*str)) >> 4);
+			*dest++ = __itoh(((const unsigned char)(*str)) % 16);
 		}
 
-		cur++;
+		run = 0;
+		str++;
 	}
 
+	return dest - out;
+}
+
+void StringUtil::url_decode(std::string& str)
+{
+	if (str.empty())
+		return;
+
+	str.resize(__url_decode(&str[0], str.size(), &str[0]));
+}
+
+size_t StringUtil::url_decode(char *str, size_t len)
+{
+	return __url_decode(str, len, str);
+}
+
+size_t StringUtil::url_decode(const char *str, size_t len, char *out)
+{
+	return __url_decode(str, len, out);
+}
+
+std::string StringUtil::url_encode(const std::string& str)
+{
+	std::string res;
+
+	res.resize(str.size() * 3);
+	res.resize(__url_encode(str.c_str(), str.size(), &res[0], false));
+	return res;
+}
+
+size_t StringUtil::url_encode(const char *str, size_t len, char *out)
+{
+	return __url_encode(str, len, out, false);
+}
+
+std::string StringUtil::url_encode_component(const std::string& str)
+{
+	std::string res;
+
+	res.resize(str.size() * 3);
+	res.resize(__url_encode(str.c_str(), str.size(), &res[0], true));
 	return res;
 }
 
+size_t StringUtil::url_encode_component(const char *str, size_t len, char *out)
+{
+	return __url_encode(str, len, out, true);
+}
+
 std::vector<std::string> StringUtil::split(const std::string& str, char sep)
 {
 	std::string::const_iterator start = str.begin();
@@ -228,3 +457,90 @@ bool StringUtil::start_with(const std::string& str, const std::string& prefix)
 	return true;
 }
 
+static const char __decimal_pairs[201] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const char __hex_pairs[513] =
+	"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+	"202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+	"404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+	"606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+	"808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+	"a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+	"c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+	"e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/* 10^n, except 0 for n = 0 so that 0 has one digit. */
+static const uint64_t __power_of_10[20] = {
+	0ULL,					10ULL,
+	100ULL,					1000ULL,
+	10000ULL,				100000ULL,
+	1000000ULL,				10000000ULL,
+	100000000ULL,			1000000000ULL,
+	10000000000ULL,			100000000000ULL,
+	1000000000000ULL,		10000000000000ULL,
+	100000000000000ULL,		1000000000000000ULL,
+	10000000000000000ULL,	100000000000000000ULL,
+	1000000000000000000ULL,	10000000000000000000ULL,
+};
+
+/* log10 from the bit length (1233 / 4096 ~ log10(2)), off by one at most. */
+static inline size_t __decimal_digits(uint64_t num)
+{
+	size_t n = (64 - __builtin_clzll(num | 1)) * 1233 >> 12;
+
+	return n + 1 - (num < __power_of_10[n]);
+}
+
+size_t StringUtil::format_uint64(uint64_t num, char *buf)
+{
+	size_t n = __decimal_digits(num);
+	char *p = buf + n;
+
+	while (num >= 100)
+	{
+		p -= 2;
+		memcpy(p, __decimal_pairs + num % 100 * 2, 2);
+		num /= 100;
+	}
+
+	if (num >= 10)
+		memcpy(p - 2, __decimal_pairs + num * 2, 2);
+	else
+		p[-1] = '0' + num;
+
+	return n;
+}
+
+size_t StringUtil::format_int64(int64_t num, char *buf)
+{
+	if (num < 0)
+	{
+		*buf = '-';
+		return 1 + format_uint64(0 - (uint64_t)num, buf + 1);
+	}
+
+	return format_uint64(num, buf);
+}
+
+size_t StringUtil::format_hex(uint64_t num, char *buf)
+{
+	size_t n = (64 - __builtin_clzll(num | 1) + 3) / 4;
+	char *p = buf + n;
+
+	while (num >= 0x100)
+	{
+		p -= 2;
+		memcpy(p, __hex_pairs + (num & 0xff) * 2, 2);
+		num >>= 8;
+	}
+
+	if (num >= 0x10)
+		memcpy(p - 2, __hex_pairs + num * 2, 2);
+	else
+		p[-1] = __hex_pairs[num * 2 + 1];
+
+	return n;
+}
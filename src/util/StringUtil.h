@@ -19,6 +19,8 @@
 #ifndef _STRINGUTIL_H_
 #define _STRINGUTIL_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -34,6 +36,22 @@ public:
 	static void url_decode(std::string& str);
 	static std::string url_encode(const std::string& str);
 	static std::string url_encode_component(const std::string& str);
+
+	// No-allocation variants. None of them append '\0'.
+	// Decode in place, return the decoded length.
+	static size_t url_decode(char *str, size_t len);
+	// 'out' must have room for 'len' bytes. Return the decoded length.
+	static size_t url_decode(const char *str, size_t len, char *out);
+	// 'out' must have room for '3 * len' bytes. Return the encoded length.
+	static size_t url_encode(const char *str, size_t len, char *out);
+	static size_t url_encode_component(const char *str, size_t len, char *out);
+
+	// Integer to text in place, without '\0'. Return the length. 'buf' must
+	// have room for 20 bytes, or 16 for format_hex() (lower case, no "0x").
+	static size_t format_uint64(uint64_t num, char *buf);
+	static size_t format_int64(int64_t num, char *buf);
+	static size_t format_hex(uint64_t num, char *buf);
+
 	static std::vector<std::string> split(const std::string& str, char sep);
 	static std::string strip(const std::string& str);
 	static bool start_with(const std::string& str, const std::string& prefix);
@@ -241,47 +241,51 @@ void ParsedURI::copy(const ParsedURI& uri)
 	}
 }
 
-int URIParser::parse(const char *str, ParsedURI& uri)
+// Find the [start, end) offset of every part. With 'origin_form', a string
+// beginning with '/' is accepted as "path[?query][#fragment]" (the form of an
+// HTTP request target). Return 0 on success, -1 on invalid uri.
+static int __parse_uri(const char *str, bool origin_form,
+					   int start_idx[], int end_idx[])
 {
-	uri.state = URI_STATE_INVALID;
-
-	int start_idx[URI_PART_ELEMENTS] = {0};
-	int end_idx[URI_PART_ELEMENTS] = {0};
-	int pre_state = URI_SCHEME;
+	int pre_state = URI_PATH;
 	bool in_ipv6 = false;
-	int i;
+	bool authority = false;
+	int i = 0;
 
-	for (i = 0; str[i]; i++)
+	if (origin_form && str[0] == '/')
+		start_idx[URI_PATH] = 0;
+	else
 	{
-		if (str[i] == ':')
+		for (i = 0; str[i]; i++)
 		{
-			end_idx[URI_SCHEME] = i++;
-			break;
+			if (str[i] == ':')
+			{
+				end_idx[URI_SCHEME] = i++;
+				break;
+			}
 		}
-	}
 
-	if (end_idx[URI_SCHEME] == 0)
-		return -1;
+		if (end_idx[URI_SCHEME] == 0)
+			return -1;
 
-	if (str[i] == '/' && str[i + 1] == '/')
-	{
-		pre_state = URI_HOST;
-		i += 2;
-		if (str[i] == '[')
-			in_ipv6 = true;
-		else
-			start_idx[URI_USERINFO] = i;
+		if (str[i] == '/' && str[i + 1] == '/')
+		{
+			authority = true;
+			pre_state = URI_HOST;
+			i += 2;
+			if (str[i] == '[')
+				in_ipv6 = true;
+			else
+				start_idx[URI_USERINFO] = i;
 
-		start_idx[URI_HOST] = i;
-	}
-	else
-	{
-		pre_state = URI_PATH;
-		start_idx[URI_PATH] = i;
+			start_idx[URI_HOST] = i;
+		}
+		else
+			start_idx[URI_PATH] = i;
 	}
 
 	bool skip_path = false;
-	if (start_idx[URI_PATH] == 0)
+	if (authority)
 	{
 		for (; ; i++)
 		{
@@ -383,6 +387,18 @@ int URIParser::parse(const char *str, ParsedURI& uri)
 		}
 	}
 
+	return 0;
+}
+
+int URIParser::parse(const char *str, ParsedURI& uri)
+{
+	int start_idx[URI_PART_ELEMENTS] = {0};
+	int end_idx[URI_PART_ELEMENTS] = {0};
+
+	uri.state = URI_STATE_INVALID;
+	if (__parse_uri(str, false, start_idx, end_idx) < 0)
+		return -1;
+
 	char **dst[URI_PART_ELEMENTS] = {&uri.scheme, &uri.userinfo, &uri.host, &uri.port,
 					 &uri.query, &uri.fragment, &uri.path};
 
@@ -422,6 +438,95 @@ int URIParser::parse(const char *str, ParsedURI& uri)
 	return 0;
 }
 
+int URIParser::parse(const char *str, ParsedURIView& uri)
+{
+	int start_idx[URI_PART_ELEMENTS] = {0};
+	int end_idx[URI_PART_ELEMENTS] = {0};
+
+	uri.str = str;
+	uri.state = URI_STATE_INVALID;
+	if (__parse_uri(str, true, start_idx, end_idx) < 0)
+		return -1;
+
+	ParsedURIView::Part *dst[URI_PART_ELEMENTS] = {&uri.scheme, &uri.userinfo, &uri.host, &uri.port,
+												   &uri.query, &uri.fragment, &uri.path};
+
+	for (int i = 0; i < URI_PART_ELEMENTS; i++)
+	{
+		if (end_idx[i] > start_idx[i])
+		{
+			dst[i]->offset = start_idx[i];
+			dst[i]->length = end_idx[i] - start_idx[i];
+			if (i == URI_HOST && str[start_idx[i]] == '[' &&
+				str[end_idx[i] - 1] == ']')
+			{
+				dst[i]->offset++;
+				dst[i]->length -= 2;
+			}
+		}
+		else
+		{
+			dst[i]->offset = 0;
+			dst[i]->length = 0;
+		}
+	}
+
+	uri.state = URI_STATE_SUCCESS;
+	return 0;
+}
+
+bool URIQueryCursor::next(struct URIQueryPair *pair)
+{
+	const char *item;
+	const char *eq;
+
+	while (this->pos < this->end)
+	{
+		item = this->pos;
+		this->pos = (const char *)memchr(item, '&', this->end - item);
+		if (!this->pos)
+			this->pos = this->end;
+
+		eq = (const char *)memchr(item, '=', this->pos - item);
+		if (!eq)
+			eq = this->pos;
+
+		if (eq > item)
+		{
+			pair->key = item;
+			pair->key_len = eq - item;
+			pair->value = eq < this->pos ? eq + 1 : this->pos;
+			pair->value_len = this->pos - pair->value;
+		}
+
+		if (this->pos < this->end)
+			this->pos++;
+
+		if (eq > item)
+			return true;
+	}
+
+	return false;
+}
+
+bool URIQueryCursor::find(struct URIQueryPair *pair)
+{
+	struct URIQueryPair tmp;
+
+	while (this->next(&tmp))
+	{
+		if (tmp.key_len == pair->key_len &&
+			memcmp(tmp.key, pair->key, tmp.key_len) == 0)
+		{
+			pair->value = tmp.value;
+			pair->value_len = tmp.value_len;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 std::map<std::string, std::vector<std::string>>
 URIParser::split_query_strict(const std::string &query)
 {
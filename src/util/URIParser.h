@@ -99,6 +99,80 @@ private:
 	void copy(const ParsedURI& uri);
 };
 
+// Zero-copy result of URIParser::parse(). Every part is an offset/length pair
+// into the parsed string, which must outlive the view. Parsing allocates
+// nothing. A part that is absent or empty has length 0, which are the cases
+// where ParsedURI has NULL.
+class ParsedURIView
+{
+public:
+	struct Part
+	{
+		size_t offset;
+		size_t length;
+	};
+
+	const char *str;
+	Part scheme;
+	Part userinfo;
+	Part host;		// IPv6 literal without '[' and ']'
+	Part port;
+	Part path;
+	Part query;
+	Part fragment;
+	int state;
+
+	ParsedURIView() :
+		str(NULL), scheme(), userinfo(), host(), port(), path(), query(),
+		fragment(), state(URI_STATE_INIT)
+	{
+	}
+
+	const char *data(const Part& part) const { return str + part.offset; }
+
+	std::string to_string(const Part& part) const
+	{
+		return std::string(str + part.offset, part.length);
+	}
+};
+
+struct URIQueryPair
+{
+	const char *key;
+	size_t key_len;
+	const char *value;
+	size_t value_len;
+};
+
+// Iterate over "k1=v1&k2=v2" without building a std::map. Keys and values
+// point into the query string and are not percent-decoded. Empty items and
+// items with an empty key are skipped, like split_query() does.
+class URIQueryCursor
+{
+public:
+	URIQueryCursor(const char *query, size_t len)
+	{
+		this->start = query;
+		this->end = query + len;
+		this->pos = query;
+	}
+
+	URIQueryCursor(const ParsedURIView& uri) :
+		URIQueryCursor(uri.data(uri.query), uri.query.length)
+	{
+	}
+
+	bool next(struct URIQueryPair *pair);
+	// Search forward for pair->key/key_len and fill value/value_len.
+	bool find(struct URIQueryPair *pair);
+	void rewind() { this->pos = this->start; }
+
+private:
+	const char *start;
+	const char *end;
+	const char *pos;
+};
+
 // static class
 class URIParser
 {
@@ -110,6 +184,14 @@ public:
 		return parse(str.c_str(), uri);
 	}
 
+	// Also accepts an origin-form request target ("/path?query#fragment"),
+	// leaving scheme and authority empty.
+	static int parse(const char *str, ParsedURIView& uri);
+	static int parse(const std::string& str, ParsedURIView& uri)
+	{
+		return parse(str.c_str(), uri);
+	}
+
 	static std::map<std::string, std::vector<std::string>>
 	split_query_strict(const std::string &query);
 
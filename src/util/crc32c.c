@@ -50,6 +50,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <pthread.h>
+#include "crc32c.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <emmintrin.h>
+#define WITH_CRC32C_HW 1
+#endif
+
+#ifndef RD_INLINE
+#define RD_INLINE inline
+#endif
 
 /**
  * Provides portable endian-swapping macros/functions.
@@ -269,6 +280,7 @@ static uint32_t crc32c_sw(uint32_t crci, const void *buf, size_t len)
 
 #if WITH_CRC32C_HW
 static int sse42;  /* Cached SSE42 support */
+static int pclmul;  /* Cached PCLMULQDQ support */
 
 /* Multiply a matrix times a vector over the Galois field of two elements,
    GF(2).  Each element is a bit in an unsigned integer.  mat must have at
@@ -377,11 +389,70 @@ static RD_INLINE uint32_t crc32c_shift(uint32_t zeros[][256], uint32_t crc)
 static uint32_t crc32c_long[4][256];
 static uint32_t crc32c_short[4][256];
 
+/* Constants for shifting a crc by 2*LONG and LONG zeros (2*SHORT and SHORT)
+   with a carry-less multiply, see crc32c_combine(). */
+static uint64_t crc32c_long_k[2];
+static uint64_t crc32c_short_k[2];
+
+/* x^n modulo the CRC-32C polynomial, in reversed bit order like the crc. */
+static uint32_t crc32c_xpow(size_t n)
+{
+    uint32_t row = 0x80000000;      /* x^0 */
+
+    while (n--)
+        row = row & 1 ? (row >> 1) ^ POLY : row >> 1;
+    return row;
+}
+
 /* Initialize tables for shifting crcs. */
 static void crc32c_init_hw(void)
 {
     crc32c_zeros(crc32c_long, LONG);
     crc32c_zeros(crc32c_short, SHORT);
+
+    /* The product of a crc and x^(8n-33), reduced by a crc32q of it, is the
+       crc shifted by n zero bytes: the multiply adds 32 - 1 to the degree
+       and the crc32q another 64 - 32, instead of 8n. */
+    crc32c_long_k[0] = crc32c_xpow(LONG*2*8 - 33);
+    crc32c_long_k[1] = crc32c_xpow(LONG*8 - 33);
+    crc32c_short_k[0] = crc32c_xpow(SHORT*2*8 - 33);
+    crc32c_short_k[1] = crc32c_xpow(SHORT*8 - 33);
+}
+
+/* Carry-less multiply of two 32-bit values. */
+static RD_INLINE uint64_t crc32c_clmul(uint64_t a, uint64_t b)
+{
+    __m128i x = _mm_cvtsi64_si128(a);
+    __m128i y = _mm_cvtsi64_si128(b);
+
+    __asm__("pclmulqdq\t$0x00, %1, %0"
+            : "+x"(x)
+            : "x"(y));
+    return _mm_cvtsi128_si64(x);
+}
+
+/* Combine the crcs of three consecutive blocks of len bytes each, crc0 of
+   the first one carrying the crc of everything before it.  With PCLMULQDQ,
+   crc0 and crc1 are shifted by 2*len and len zeros at the same time with one
+   multiply each and reduced with a single crc32q, instead of two dependent
+   table shifts of 4 lookups each. */
+static RD_INLINE uint64_t crc32c_combine(uint32_t zeros[][256],
+                                         const uint64_t *k, uint64_t crc0,
+                                         uint64_t crc1, uint64_t crc2)
+{
+    uint64_t prod;
+
+    if (pclmul) {
+        prod = crc32c_clmul(crc0, k[0]) ^ crc32c_clmul(crc1, k[1]);
+        crc0 = 0;
+        __asm__("crc32q\t%1, %0"
+                : "+r"(crc0)
+                : "r"(prod));
+        return crc0 ^ crc2;
+    }
+
+    crc0 = crc32c_shift(zeros, crc0) ^ crc1;
+    return crc32c_shift(zeros, crc0) ^ crc2;
 }
 
 /* Compute CRC-32C using the Intel hardware instruction. */
@@ -420,8 +491,7 @@ static uint32_t crc32c_hw(uint32_t crc, const void *buf, size_t len)
                     : "r"(next), "0"(crc0), "1"(crc1), "2"(crc2));
             next += 8;
         } while (next < end);
-        crc0 = crc32c_shift(crc32c_long, crc0) ^ crc1;
-        crc0 = crc32c_shift(crc32c_long, crc0) ^ crc2;
+        crc0 = crc32c_combine(crc32c_long, crc32c_long_k, crc0, crc1, crc2);
         next += LONG*2;
         len -= LONG*3;
     }
@@ -440,8 +510,7 @@ static uint32_t crc32c_hw(uint32_t crc, const void *buf, size_t len)
                     : "r"(next), "0"(crc0), "1"(crc1), "2"(crc2));
             next += 8;
         } while (next < end);
-        crc0 = crc32c_shift(crc32c_short, crc0) ^ crc1;
-        crc0 = crc32c_shift(crc32c_short, crc0) ^ crc2;
+        crc0 = crc32c_combine(crc32c_short, crc32c_short_k, crc0, crc1, crc2);
         next += SHORT*2;
         len -= SHORT*3;
     }
@@ -486,12 +555,29 @@ static uint32_t crc32c_hw(uint32_t crc, const void *buf, size_t len)
         (have) = (ecx >> 20) & 1; \
     } while (0)
 
+/* PCLMULQDQ is bit 1 of the same cpuid leaf. */
+#define PCLMUL(have) \
+    do { \
+        uint32_t eax, ecx; \
+        eax = 1; \
+        __asm__("cpuid" \
+                : "=c"(ecx) \
+                : "a"(eax) \
+                : "%ebx", "%edx"); \
+        (have) = (ecx >> 1) & 1; \
+    } while (0)
+
 #endif /* WITH_CRC32C_HW */
 
 /* Compute a CRC-32C.  If the crc32 instruction is available, use the hardware
    version.  Otherwise, use the software version. */
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init(void);
+
 uint32_t crc32c(uint32_t crc, const void *buf, size_t len)
 {
+        pthread_once(&crc32c_once, crc32c_init);
 #if WITH_CRC32C_HW
         if (sse42)
                 return crc32c_hw(crc, buf, len);
@@ -505,15 +591,20 @@ uint32_t crc32c(uint32_t crc, const void *buf, size_t len)
 
 
 
-/**
- * @brief Populate shift tables once
- */
-void crc32c_global_init (void) {
+static void crc32c_init(void) {
 #if WITH_CRC32C_HW
         SSE42(sse42);
+        PCLMUL(pclmul);
         if (sse42)
                 crc32c_init_hw();
         else
 #endif
                 crc32c_init_sw();
 }
+
+/**
+ * @brief Populate shift tables once. Optional, crc32c() does it on first use.
+ */
+void crc32c_global_init (void) {
+        pthread_once(&crc32c_once, crc32c_init);
+}
@@ -17,6 +17,7 @@
 */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
@@ -28,16 +29,22 @@
 
 #define JSON_DEPTH_LIMIT	1024
 
+typedef struct __json_arena json_arena_t;
+typedef struct __json_hash json_hash_t;
+
 struct __json_object
 {
 	struct list_head head;
 	struct rb_root root;
+	json_arena_t *arena;
+	json_hash_t *hash;
 	int size;
 };
 
 struct __json_array
 {
 	struct list_head head;
+	json_arena_t *arena;
 	int size;
 };
 
@@ -70,6 +77,119 @@ struct __json_element
 typedef struct __json_member json_member_t;
 typedef struct __json_element json_element_t;
 
+/*
+ * Arena of json_value_parse_arena(). Nodes and strings are carved out of
+ * blocks that double in size, and the whole DOM is freed block by block.
+ * Every object and array remembers its arena (NULL if malloc'ed), so that
+ * nodes added to an arena DOM later come from the same arena and nothing
+ * inside an arena is ever passed to free().
+ */
+struct __json_arena_block
+{
+	struct __json_arena_block *next;
+};
+
+struct __json_arena
+{
+	struct __json_arena_block *blocks;
+	char *cur;
+	char *end;
+	size_t block_size;
+	json_value_t *root;
+	json_hash_t *hashes;
+};
+
+#define JSON_ARENA_ALIGN(n)		(((n) + 7) & ~(size_t)7)
+
+static json_arena_t *__json_arena_create(size_t size)
+{
+	struct __json_arena_block *block;
+	json_arena_t *arena;
+
+	size += sizeof (struct __json_arena_block) +
+			JSON_ARENA_ALIGN(sizeof (json_arena_t));
+	block = (struct __json_arena_block *)malloc(size);
+	if (!block)
+		return NULL;
+
+	block->next = NULL;
+	arena = (json_arena_t *)(block + 1);
+	arena->blocks = block;
+	arena->cur = (char *)arena + JSON_ARENA_ALIGN(sizeof (json_arena_t));
+	arena->end = (char *)block + size;
+	arena->block_size = size;
+	arena->root = NULL;
+	arena->hashes = NULL;
+	return arena;
+}
+
+static void __json_hash_destroy(json_hash_t *hash);
+
+static void __json_arena_destroy(json_arena_t *arena)
+{
+	struct __json_arena_block *block = arena->blocks;
+	struct __json_arena_block *next;
+
+	if (arena->hashes)
+		__json_hash_destroy(arena->hashes);
+
+	/* The arena itself lives in the first block, which is freed last. */
+	while (block)
+	{
+		next = block->next;
+		free(block);
+		block = next;
+	}
+}
+
+static void *__json_alloc(size_t size, json_arena_t *arena)
+{
+	struct __json_arena_block *block;
+	size_t block_size;
+	void *ptr;
+
+	if (!arena)
+		return malloc(size);
+
+	size = JSON_ARENA_ALIGN(size);
+	if ((size_t)(arena->end - arena->cur) < size)
+	{
+		block_size = 2 * arena->block_size;
+		if (block_size < sizeof (struct __json_arena_block) + size)
+			block_size = sizeof (struct __json_arena_block) + size;
+
+		block = (struct __json_arena_block *)malloc(block_size);
+		if (!block)
+			return NULL;
+
+		block->next = arena->blocks;
+		arena->blocks = block;
+		arena->cur = (char *)(block + 1);
+		arena->end = (char *)block + block_size;
+		arena->block_size = block_size;
+	}
+
+	ptr = arena->cur;
+	arena->cur += size;
+	return ptr;
+}
+
+static inline void __json_free(void *ptr, json_arena_t *arena)
+{
+	if (!arena)
+		free(ptr);
+}
+
+static inline json_arena_t *__json_value_arena(const json_value_t *val)
+{
+	if (val->type == JSON_VALUE_OBJECT)
+		return val->value.object.arena;
+	else if (val->type == JSON_VALUE_ARRAY)
+		return val->value.array.arena;
+	else
+		return NULL;
+}
+
 static int __json_string_length(const char *cursor)
 {
 	int len = 0;
@@ -486,12 +606,14 @@ static void __insert_json_member(json_member_t *memb, struct list_head *pos,
 }
 
 static int __parse_json_value(const char *cursor, const char **end,
-							  int depth, json_value_t *val);
+							  int depth, json_value_t *val,
+							  json_arena_t *arena);
 
 static void __destroy_json_value(json_value_t *val);
 
 static int __parse_json_member(const char *cursor, const char **end,
-							   int depth, json_member_t *memb)
+							   int depth, json_member_t *memb,
+							   json_arena_t *arena)
 {
 	int ret;
 
@@ -509,7 +631,7 @@ static int __parse_json_member(const char *cursor, const char **end,
 	while (isspace(*cursor))
 		cursor++;
 
-	ret = __parse_json_value(cursor, &cursor, depth, &memb->value);
+	ret = __parse_json_value(cursor, &cursor, depth, &memb->value, arena);
 	if (ret < 0)
 		return ret;
 
@@ -543,14 +665,15 @@ static int __parse_json_members(const char *cursor, const char **end,
 		if (ret < 0)
 			return ret;
 
-		memb = (json_member_t *)malloc(offsetof(json_member_t, name) + ret + 1);
+		memb = (json_member_t *)__json_alloc(offsetof(json_member_t, name) +
+											 ret + 1, obj->arena);
 		if (!memb)
 			return -1;
 
-		ret = __parse_json_member(cursor, &cursor, depth, memb);
+		ret = __parse_json_member(cursor, &cursor, depth, memb, obj->arena);
 		if (ret < 0)
 		{
-			free(memb);
+			__json_free(memb, obj->arena);
 			return ret;
 		}
 
@@ -581,6 +704,12 @@ static void __destroy_json_members(json_object_t *obj)
 	struct list_head *pos, *tmp;
 	json_member_t *memb;
 
+	if (obj->arena)
+		return;
+
+	if (obj->hash)
+		__json_hash_destroy(obj->hash);
+
 	list_for_each_safe(pos, tmp, &obj->head)
 	{
 		memb = list_entry(pos, json_member_t, list);
@@ -590,7 +719,8 @@ static void __destroy_json_members(json_object_t *obj)
 }
 
 static int __parse_json_object(const char *cursor, const char **end,
-							   int depth, json_object_t *obj)
+							   int depth, json_object_t *obj,
+							   json_arena_t *arena)
 {
 	int ret;
 
@@ -599,6 +729,8 @@ static int __parse_json_object(const char *cursor, const char **end,
 
 	INIT_LIST_HEAD(&obj->head);
 	obj->root.rb_node = NULL;
+	obj->arena = arena;
+	obj->hash = NULL;
 	ret = __parse_json_members(cursor, end, depth + 1, obj);
 	if (ret < 0)
 	{
@@ -628,14 +760,16 @@ static int __parse_json_elements(const char *cursor, const char **end,
 
 	while (1)
 	{
-		elem = (json_element_t *)malloc(sizeof (json_element_t));
+		elem = (json_element_t *)__json_alloc(sizeof (json_element_t),
+											  arr->arena);
 		if (!elem)
 			return -1;
 
-		ret = __parse_json_value(cursor, &cursor, depth, &elem->value);
+		ret = __parse_json_value(cursor, &cursor, depth, &elem->value,
+								 arr->arena);
 		if (ret < 0)
 		{
-			free(elem);
+			__json_free(elem, arr->arena);
 			return ret;
 		}
 
@@ -666,6 +800,9 @@ static void __destroy_json_elements(json_array_t *arr)
 	struct list_head *pos, *tmp;
 	json_element_t *elem;
 
+	if (arr->arena)
+		return;
+
 	list_for_each_safe(pos, tmp, &arr->head)
 	{
 		elem = list_entry(pos, json_element_t, list);
@@ -675,7 +812,8 @@ static void __destroy_json_elements(json_array_t *arr)
 }
 
 static int __parse_json_array(const char *cursor, const char **end,
-							  int depth, json_array_t *arr)
+							  int depth, json_array_t *arr,
+							  json_arena_t *arena)
 {
 	int ret;
 
@@ -683,6 +821,7 @@ static int __parse_json_array(const char *cursor, const char **end,
 		return -3;
 
 	INIT_LIST_HEAD(&arr->head);
+	arr->arena = arena;
 	ret = __parse_json_elements(cursor, end, depth + 1, arr);
 	if (ret < 0)
 	{
@@ -695,7 +834,8 @@ static int __parse_json_array(const char *cursor, const char **end,
 }
 
 static int __parse_json_value(const char *cursor, const char **end,
-							  int depth, json_value_t *val)
+							  int depth, json_value_t *val,
+							  json_arena_t *arena)
 {
 	int ret;
 
@@ -707,14 +847,14 @@ static int __parse_json_value(const char *cursor, const char **end,
 		if (ret < 0)
 			return ret;
 
-		val->value.string = (char *)malloc(ret + 1);
+		val->value.string = (char *)__json_alloc(ret + 1, arena);
 		if (!val->value.string)
 			return -1;
 
 		ret = __parse_json_string(cursor, end, val->value.string);
 		if (ret < 0)
 		{
-			free(val->value.string);
+			__json_free(val->value.string, arena);
 			return ret;
 		}
 
@@ -741,7 +881,8 @@ static int __parse_json_value(const char *cursor, const char **end,
 
 	case '{':
 		cursor++;
-		ret = __parse_json_object(cursor, end, depth, &val->value.object);
+		ret = __parse_json_object(cursor, end, depth, &val->value.object,
+								  arena);
 		if (ret < 0)
 			return ret;
 
@@ -750,7 +891,8 @@ static int __parse_json_value(const char *cursor, const char **end,
 
 	case '[':
 		cursor++;
-		ret = __parse_json_array(cursor, end, depth, &val->value.array);
+		ret = __parse_json_array(cursor, end, depth, &val->value.array,
+								 arena);
 		if (ret < 0)
 			return ret;
 
@@ -817,7 +959,7 @@ json_value_t *json_value_parse(const char *cursor)
 	while (isspace(*cursor))
 		cursor++;
 
-	if (__parse_json_value(cursor, &cursor, 0, val) >= 0)
+	if (__parse_json_value(cursor, &cursor, 0, val, NULL) >= 0)
 	{
 		while (isspace(*cursor))
 			cursor++;
@@ -832,6 +974,40 @@ json_value_t *json_value_parse(const char *cursor)
 	return NULL;
 }
 
+json_value_t *json_value_parse_arena(const char *cursor)
+{
+	json_arena_t *arena;
+	json_value_t *val;
+	size_t len;
+
+	while (isspace(*cursor))
+		cursor++;
+
+	/* Only an object or an array can own an arena. */
+	if (*cursor != '{' && *cursor != '[')
+		return json_value_parse(cursor);
+
+	/* A DOM usually takes about twice the size of its text. */
+	len = strlen(cursor);
+	arena = __json_arena_create(2 * len + 256);
+	if (!arena)
+		return NULL;
+
+	val = (json_value_t *)__json_alloc(sizeof (json_value_t), arena);
+	arena->root = val;
+	if (__parse_json_value(cursor, &cursor, 0, val, arena) >= 0)
+	{
+		while (isspace(*cursor))
+			cursor++;
+
+		if (*cursor == '\0')
+			return val;
+	}
+
+	__json_arena_destroy(arena);
+	return NULL;
+}
+
 static void __move_json_value(json_value_t *src, json_value_t *dest)
 {
 	switch (src->type)
@@ -848,12 +1024,15 @@ static void __move_json_value(json_value_t *src, json_value_t *dest)
 		INIT_LIST_HEAD(&dest->value.object.head);
 		list_splice(&src->value.object.head, &dest->value.object.head);
 		dest->value.object.root.rb_node = src->value.object.root.rb_node;
+		dest->value.object.arena = src->value.object.arena;
+		dest->value.object.hash = src->value.object.hash;
 		dest->value.object.size = src->value.object.size;
 		break;
 
 	case JSON_VALUE_ARRAY:
 		INIT_LIST_HEAD(&dest->value.array.head);
 		list_splice(&src->value.array.head, &dest->value.array.head);
+		dest->value.array.arena = src->value.array.arena;
 		dest->value.array.size = src->value.array.size;
 		break;
 	}
@@ -861,7 +1040,11 @@ static void __move_json_value(json_value_t *src, json_value_t *dest)
 	dest->type = src->type;
 }
 
-static int __set_json_value(int type, va_list ap, json_value_t *val)
+static int __copy_json_value(const json_value_t *src, json_value_t *dest,
+							 json_arena_t *arena);
+
+static int __set_json_value(int type, va_list ap, json_value_t *val,
+							json_arena_t *arena)
 {
 	json_value_t *src;
 	const char *str;
@@ -871,14 +1054,24 @@ static int __set_json_value(int type, va_list ap, json_value_t *val)
 	{
 	case 0:
 		src = va_arg(ap, json_value_t *);
-		__move_json_value(src, val);
-		free(src);
+		if (__json_value_arena(src) == arena)
+		{
+			__move_json_value(src, val);
+			free(src);
+			return 0;
+		}
+
+		/* Moving between malloc and arena memory takes a copy. */
+		if (__copy_json_value(src, val, arena) < 0)
+			return -1;
+
+		json_value_destroy(src);
 		return 0;
 
 	case JSON_VALUE_STRING:
 		str = va_arg(ap, const char *);
 		len = strlen(str);
-		val->value.string = (char *)malloc(len + 1);
+		val->value.string = (char *)__json_alloc(len + 1, arena);
 		if (!val->value.string)
 			return -1;
 
@@ -892,11 +1085,14 @@ static int __set_json_value(int type, va_list ap, json_value_t *val)
 	case JSON_VALUE_OBJECT:
 		INIT_LIST_HEAD(&val->value.object.head);
 		val->value.object.root.rb_node = NULL;
+		val->value.object.arena = arena;
+		val->value.object.hash = NULL;
 		val->value.object.size = 0;
 		break;
 
 	case JSON_VALUE_ARRAY:
 		INIT_LIST_HEAD(&val->value.array.head);
+		val->value.array.arena = arena;
 		val->value.array.size = 0;
 		break;
 	}
@@ -916,7 +1112,7 @@ json_value_t *json_value_create(int type, ...)
 		return NULL;
 
 	va_start(ap, type);
-	ret = __set_json_value(type, ap, val);
+	ret = __set_json_value(type, ap, val, NULL);
 	va_end(ap);
 	if (ret < 0)
 	{
@@ -927,8 +1123,6 @@ json_value_t *json_value_create(int type, ...)
 	return val;
 }
 
-static int __copy_json_value(const json_value_t *src, json_value_t *dest);
-
 static int __copy_json_members(const json_object_t *src, json_object_t *dest)
 {
 	struct list_head *pos;
@@ -940,13 +1134,14 @@ static int __copy_json_members(const json_object_t *src, json_object_t *dest)
 	{
 		entry = list_entry(pos, json_member_t, list);
 		len = strlen(entry->name);
-		memb = (json_member_t *)malloc(offsetof(json_member_t, name) + len + 1);
+		memb = (json_member_t *)__json_alloc(offsetof(json_member_t, name) +
+											 len + 1, dest->arena);
 		if (!memb)
 			return -1;
 
-		if (__copy_json_value(&entry->value, &memb->value) < 0)
+		if (__copy_json_value(&entry->value, &memb->value, dest->arena) < 0)
 		{
-			free(memb);
+			__json_free(memb, dest->arena);
 			return -1;
 		}
 
@@ -965,14 +1160,15 @@ static int __copy_json_elements(const json_array_t *src, json_array_t *dest)
 
 	list_for_each(pos, &src->head)
 	{
-		elem = (json_element_t *)malloc(sizeof (json_element_t));
+		elem = (json_element_t *)__json_alloc(sizeof (json_element_t),
+											  dest->arena);
 		if (!elem)
 			return -1;
 
 		entry = list_entry(pos, json_element_t, list);
-		if (__copy_json_value(&entry->value, &elem->value) < 0)
+		if (__copy_json_value(&entry->value, &elem->value, dest->arena) < 0)
 		{
-			free(elem);
+			__json_free(elem, dest->arena);
 			return -1;
 		}
 
@@ -982,7 +1178,8 @@ static int __copy_json_elements(const json_array_t *src, json_array_t *dest)
 	return src->size;
 }
 
-static int __copy_json_value(const json_value_t *src, json_value_t *dest)
+static int __copy_json_value(const json_value_t *src, json_value_t *dest,
+							 json_arena_t *arena)
 {
 	int len;
 
@@ -990,7 +1187,7 @@ static int __copy_json_value(const json_value_t *src, json_value_t *dest)
 	{
 	case JSON_VALUE_STRING:
 		len = strlen(src->value.string);
-		dest->value.string = (char *)malloc(len + 1);
+		dest->value.string = (char *)__json_alloc(len + 1, arena);
 		if (!dest->value.string)
 			return -1;
 
@@ -1004,6 +1201,8 @@ static int __copy_json_value(const json_value_t *src, json_value_t *dest)
 	case JSON_VALUE_OBJECT:
 		INIT_LIST_HEAD(&dest->value.object.head);
 		dest->value.object.root.rb_node = NULL;
+		dest->value.object.arena = arena;
+		dest->value.object.hash = NULL;
 		if (__copy_json_members(&src->value.object, &dest->value.object) < 0)
 		{
 			__destroy_json_members(&dest->value.object);
@@ -1015,6 +1214,7 @@ static int __copy_json_value(const json_value_t *src, json_value_t *dest)
 
 	case JSON_VALUE_ARRAY:
 		INIT_LIST_HEAD(&dest->value.array.head);
+		dest->value.array.arena = arena;
 		if (__copy_json_elements(&src->value.array, &dest->value.array) < 0)
 		{
 			__destroy_json_elements(&dest->value.array);
@@ -1037,7 +1237,7 @@ json_value_t *json_value_copy(const json_value_t *val)
 	if (!copy)
 		return NULL;
 
-	if (__copy_json_value(val, copy) < 0)
+	if (__copy_json_value(val, copy, NULL) < 0)
 	{
 		free(copy);
 		return NULL;
@@ -1048,6 +1248,16 @@ json_value_t *json_value_copy(const json_value_t *val)
 
 void json_value_destroy(json_value_t *val)
 {
+	json_arena_t *arena = __json_value_arena(val);
+
+	if (arena)
+	{
+		if (arena->root == val)
+			__json_arena_destroy(arena);
+
+		return;
+	}
+
 	__destroy_json_value(val);
 	free(val);
 }
@@ -1089,26 +1299,276 @@ json_array_t *json_value_array(const json_value_t *val)
 	return (json_array_t *)&val->value.array;
 }
 
+/*
+ * Hash index of a big object. The first lookup in an object of at least
+ * JSON_HASH_THRESHOLD members builds a linear probing table of the members,
+ * so that later lookups compare one hash instead of strings all the way
+ * down the rbtree. Lookups are on const objects, so threads may race to
+ * build the table of the same object: each builds its own and the first to
+ * publish it wins. Inserting and removing members keep the table up to
+ * date, or drop it to be built again. Tables are malloc'ed. The object owns
+ * its table, except in an arena, where the tables are chained on the arena
+ * and freed with it.
+ */
+#define JSON_HASH_THRESHOLD		16
+
+struct __json_hash_entry
+{
+	unsigned int hash;
+	json_member_t *memb;
+};
+
+struct __json_hash
+{
+	json_hash_t *next;
+	unsigned int mask;
+	int used;
+	struct __json_hash_entry entries[1];
+};
+
+static void __json_hash_destroy(json_hash_t *hash)
+{
+	json_hash_t *next;
+
+	do
+	{
+		next = hash->next;
+		free(hash);
+		hash = next;
+	} while (hash);
+}
+
+/* Eight bytes at a time, as member names are mostly longer than that. */
+static inline unsigned int __json_hash_name(const char *name, size_t len)
+{
+	uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+	uint64_t w;
+
+	while (len >= 8)
+	{
+		memcpy(&w, name, 8);
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 32;
+		name += 8;
+		len -= 8;
+	}
+
+	w = 0;
+	memcpy(&w, name, len);
+	h = (h ^ w) * 0xc4ceb9fe1a85ec53ULL;
+	return (unsigned int)(h ^ (h >> 29));
+}
+
+/* The table is half full at most. Of the members with the same name, the
+ * one added to the table first is found, and deleting keeps their order. */
+static void __json_hash_add(json_member_t *memb, unsigned int h,
+							json_hash_t *hash)
+{
+	unsigned int i = h & hash->mask;
+
+	while (hash->entries[i].memb)
+		i = (i + 1) & hash->mask;
+
+	hash->entries[i].hash = h;
+	hash->entries[i].memb = memb;
+	hash->used++;
+}
+
+static void __json_hash_del(const json_member_t *memb, json_hash_t *hash)
+{
+	unsigned int mask = hash->mask;
+	unsigned int i, j, k;
+
+	i = __json_hash_name(memb->name, strlen(memb->name)) & mask;
+	while (hash->entries[i].memb != memb)
+		i = (i + 1) & mask;
+
+	/* Shift back the entries that probed past the removed one. */
+	j = i;
+	while (1)
+	{
+		j = (j + 1) & mask;
+		if (!hash->entries[j].memb)
+			break;
+
+		k = hash->entries[j].hash & mask;
+		if (((j - k) & mask) >= ((j - i) & mask))
+		{
+			hash->entries[i] = hash->entries[j];
+			i = j;
+		}
+	}
+
+	hash->entries[i].memb = NULL;
+	hash->used--;
+}
+
+static json_hash_t *__json_hash_build(json_object_t *obj)
+{
+	unsigned int n = 2 * JSON_HASH_THRESHOLD;
+	struct rb_node *p;
+	json_member_t *memb;
+	json_hash_t *hash;
+	json_hash_t *old = NULL;
+	size_t size;
+
+	while (n < 2 * (unsigned int)obj->size)
+		n *= 2;
+
+	size = offsetof(json_hash_t, entries) + n * sizeof (struct __json_hash_entry);
+	hash = (json_hash_t *)malloc(size);
+	if (!hash)
+		return NULL;
+
+	memset(hash->entries, 0, n * sizeof (struct __json_hash_entry));
+	hash->mask = n - 1;
+	hash->used = 0;
+	hash->next = NULL;
+	/* In tree order, where members of the same name are in the order they
+	 * were added, not in list order that insert_before() may change. */
+	for (p = rb_first(&obj->root); p; p = rb_next(p))
+	{
+		memb = rb_entry(p, json_member_t, rb);
+		__json_hash_add(memb, __json_hash_name(memb->name, strlen(memb->name)),
+						hash);
+	}
+
+	if (!__atomic_compare_exchange_n(&obj->hash, &old, hash, 0,
+									 __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+	{
+		free(hash);
+		return old;
+	}
+
+	if (obj->arena)
+	{
+		hash->next = __atomic_load_n(&obj->arena->hashes, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&obj->arena->hashes, &hash->next,
+											hash, 1, __ATOMIC_RELAXED,
+											__ATOMIC_RELAXED))
+			;
+	}
+
+	return hash;
+}
+
+/* Not thread safe, like any change to the object. */
+static void __json_hash_drop(json_object_t *obj)
+{
+	if (!obj->arena)
+		free(obj->hash);
+
+	obj->hash = NULL;
+}
+
+static void __json_hash_insert(json_member_t *memb, json_object_t *obj)
+{
+	json_hash_t *hash = obj->hash;
+
+	if (2 * (hash->used + 1) > hash->mask + 1)
+		__json_hash_drop(obj);
+	else
+		__json_hash_add(memb, __json_hash_name(memb->name, strlen(memb->name)),
+						hash);
+}
+
+static const json_value_t *__json_hash_find(const char *name, size_t len,
+											const json_hash_t *hash)
+{
+	unsigned int h = __json_hash_name(name, len);
+	unsigned int i = h & hash->mask;
+	const json_member_t *memb;
+
+	while ((memb = hash->entries[i].memb) != NULL)
+	{
+		if (hash->entries[i].hash == h && memcmp(memb->name, name, len) == 0 &&
+			memb->name[len] == '\0')
+		{
+			return &memb->value;
+		}
+
+		i = (i + 1) & hash->mask;
+	}
+
+	return NULL;
+}
+
+static inline const json_hash_t *__json_object_hash(const json_object_t *obj)
+{
+	const json_hash_t *hash = __atomic_load_n(&obj->hash, __ATOMIC_ACQUIRE);
+
+	if (!hash)
+		hash = __json_hash_build((json_object_t *)obj);
+
+	return hash;
+}
+
+const json_value_t *json_object_find_n(const char *name, size_t len,
+									   const json_object_t *obj)
+{
+	struct rb_node *p = obj->root.rb_node;
+	const json_value_t *val = NULL;
+	const json_hash_t *hash;
+	json_member_t *memb;
+	int n;
+
+	if (obj->size >= JSON_HASH_THRESHOLD)
+	{
+		hash = __json_object_hash(obj);
+		if (hash)
+			return __json_hash_find(name, len, hash);
+	}
+
+	/* A member of the same name added later is linked to the right, so the
+	 * leftmost match is the first added, as in the hash table. */
+	while (p)
+	{
+		memb = rb_entry(p, json_member_t, rb);
+		n = strncmp(name, memb->name, len);
+		if (n == 0 && memb->name[len] != '\0')
+			n = -1;
+
+		if (n > 0)
+			p = p->rb_right;
+		else
+		{
+			if (n == 0)
+				val = &memb->value;
+
+			p = p->rb_left;
+		}
+	}
+
+	return val;
+}
+
 const json_value_t *json_object_find(const char *name,
 									 const json_object_t *obj)
 {
 	struct rb_node *p = obj->root.rb_node;
+	const json_value_t *val = NULL;
 	json_member_t *memb;
 	int n;
 
+	if (obj->size >= JSON_HASH_THRESHOLD)
+		return json_object_find_n(name, strlen(name), obj);
+
 	while (p)
 	{
 		memb = rb_entry(p, json_member_t, rb);
 		n = strcmp(name, memb->name);
-		if (n < 0)
-			p = p->rb_left;
-		else if (n > 0)
+		if (n > 0)
 			p = p->rb_right;
 		else
-			return &memb->value;
+		{
+			if (n == 0)
+				val = &memb->value;
+
+			p = p->rb_left;
+		}
 	}
 
-	return NULL;
+	return val;
 }
 
 int json_object_size(const json_object_t *obj)
@@ -1189,18 +1649,22 @@ static const json_value_t *__json_object_insert(const char *name,
 	int len;
 
 	len = strlen(name);
-	memb = (json_member_t *)malloc(offsetof(json_member_t, name) + len + 1);
+	memb = (json_member_t *)__json_alloc(offsetof(json_member_t, name) +
+										 len + 1, obj->arena);
 	if (!memb)
 		return NULL;
 
 	memcpy(memb->name, name, len + 1);
-	if (__set_json_value(type, ap, &memb->value) < 0)
+	if (__set_json_value(type, ap, &memb->value, obj->arena) < 0)
 	{
-		free(memb);
+		__json_free(memb, obj->arena);
 		return NULL;
 	}
 
 	__insert_json_member(memb, pos, obj);
+	if (obj->hash)
+		__json_hash_insert(memb, obj);
+
 	obj->size++;
 	return &memb->value;
 }
@@ -1261,16 +1725,28 @@ json_value_t *json_object_remove(const json_value_t *val,
 {
 	json_member_t *memb = list_entry(val, json_member_t, value);
 
-	val = (json_value_t *)malloc(sizeof (json_value_t));
+	/* Arena nodes can not be handed out. The caller gets a copy. */
+	if (obj->arena)
+		val = json_value_copy(&memb->value);
+	else
+		val = (json_value_t *)malloc(sizeof (json_value_t));
+
 	if (!val)
 		return NULL;
 
+	if (obj->hash)
+		__json_hash_del(memb, obj->hash);
+
 	list_del(&memb->list);
 	rb_erase(&memb->rb, &obj->root);
 	obj->size--;
 
-	__move_json_value(&memb->value, (json_value_t *)val);
-	free(memb);
+	if (!obj->arena)
+	{
+		__move_json_value(&memb->value, (json_value_t *)val);
+		free(memb);
+	}
+
 	return (json_value_t *)val;
 }
 
@@ -1317,13 +1793,14 @@ static const json_value_t *__json_array_insert(int type, va_list ap,
 {
 	json_element_t *elem;
 
-	elem = (json_element_t *)malloc(sizeof (json_element_t));
+	elem = (json_element_t *)__json_alloc(sizeof (json_element_t),
+										  arr->arena);
 	if (!elem)
 		return NULL;
 
-	if (__set_json_value(type, ap, &elem->value) < 0)
+	if (__set_json_value(type, ap, &elem->value, arr->arena) < 0)
 	{
-		free(elem);
+		__json_free(elem, arr->arena);
 		return NULL;
 	}
 
@@ -1385,15 +1862,508 @@ json_value_t *json_array_remove(const json_value_t *val,
 {
 	json_element_t *elem = list_entry(val, json_element_t, value);
 
-	val = (json_value_t *)malloc(sizeof (json_value_t));
+	if (arr->arena)
+		val = json_value_copy(&elem->value);
+	else
+		val = (json_value_t *)malloc(sizeof (json_value_t));
+
 	if (!val)
 		return NULL;
 
 	list_del(&elem->list);
 	arr->size--;
 
-	__move_json_value(&elem->value, (json_value_t *)val);
-	free(elem);
+	if (!arr->arena)
+	{
+		__move_json_value(&elem->value, (json_value_t *)val);
+		free(elem);
+	}
+
 	return (json_value_t *)val;
 }
 
+
+/*
+ * Incremental parser. Text is fed in pieces of any size. Strings and
+ * scalars are collected in 'buf' until they end, and everything else is
+ * handled byte by byte as it arrives, so the DOM or the last event is ready
+ * right after the last piece.
+ */
+enum
+{
+	JSON_STREAM_VALUE,			/* a value */
+	JSON_STREAM_FIRST_VALUE,	/* a value or ']' right after '[' */
+	JSON_STREAM_FIRST_NAME,		/* a name or '}' right after '{' */
+	JSON_STREAM_NAME,			/* a name after ',' */
+	JSON_STREAM_COLON,
+	JSON_STREAM_NEXT,			/* ',' or the closing bracket */
+	JSON_STREAM_STRING,
+	JSON_STREAM_SCALAR,			/* a number, true, false or null */
+	JSON_STREAM_DONE,
+};
+
+struct __json_stream
+{
+	json_event_t callback;
+	void *context;
+	int state;
+	int ret;
+	int escape;
+	int is_name;
+	int has_name;
+	int depth;
+	char *buf;
+	size_t len;
+	size_t size;
+	char *name;
+	size_t name_size;
+	json_value_t *root;
+	char types[JSON_DEPTH_LIMIT];
+	json_value_t *stack[JSON_DEPTH_LIMIT];
+};
+
+json_stream_t *json_stream_create(json_event_t callback, void *context)
+{
+	json_stream_t *stream = (json_stream_t *)malloc(sizeof (json_stream_t));
+
+	if (!stream)
+		return NULL;
+
+	stream->callback = callback;
+	stream->context = context;
+	stream->state = JSON_STREAM_VALUE;
+	stream->ret = 0;
+	stream->escape = 0;
+	stream->is_name = 0;
+	stream->has_name = 0;
+	stream->depth = 0;
+	stream->buf = NULL;
+	stream->len = 0;
+	stream->size = 0;
+	stream->name = NULL;
+	stream->name_size = 0;
+	stream->root = NULL;
+	return stream;
+}
+
+void json_stream_destroy(json_stream_t *stream)
+{
+	if (stream->root)
+		json_value_destroy(stream->root);
+
+	free(stream->buf);
+	free(stream->name);
+	free(stream);
+}
+
+/* Keeps room for a closing quote and a '\0'. */
+static int __json_stream_append(const char *data, size_t n,
+								json_stream_t *stream)
+{
+	size_t size = stream->size ? stream->size : 64;
+	char *buf;
+
+	if (stream->len + n + 2 > stream->size)
+	{
+		while (size < stream->len + n + 2)
+			size *= 2;
+
+		buf = (char *)realloc(stream->buf, size);
+		if (!buf)
+			return -1;
+
+		stream->buf = buf;
+		stream->size = size;
+	}
+
+	memcpy(stream->buf + stream->len, data, n);
+	stream->len += n;
+	return 0;
+}
+
+/* Adds an object, an array or a scalar to the DOM under construction. */
+static int __json_stream_build(int event, const char *name,
+							   const json_value_t *val, json_stream_t *stream)
+{
+	json_value_t *parent = stream->depth ? stream->stack[stream->depth - 1]
+										 : NULL;
+	const json_value_t *child;
+	int type;
+
+	if (event == JSON_EVENT_OBJECT_END || event == JSON_EVENT_ARRAY_END)
+		return 0;
+
+	if (event == JSON_EVENT_OBJECT_BEGIN)
+		type = JSON_VALUE_OBJECT;
+	else if (event == JSON_EVENT_ARRAY_BEGIN)
+		type = JSON_VALUE_ARRAY;
+	else
+		type = val->type;
+
+	if (!parent)
+	{
+		if (type == JSON_VALUE_STRING)
+			stream->root = json_value_create(type, val->value.string);
+		else if (type == JSON_VALUE_NUMBER)
+			stream->root = json_value_create(type, val->value.number);
+		else
+			stream->root = json_value_create(type);
+
+		child = stream->root;
+	}
+	else if (parent->type == JSON_VALUE_OBJECT)
+	{
+		if (type == JSON_VALUE_STRING)
+			child = json_object_append(&parent->value.object, name, type,
+									   val->value.string);
+		else if (type == JSON_VALUE_NUMBER)
+			child = json_object_append(&parent->value.object, name, type,
+									   val->value.number);
+		else
+			child = json_object_append(&parent->value.object, name, type);
+	}
+	else
+	{
+		if (type == JSON_VALUE_STRING)
+			child = json_array_append(&parent->value.array, type,
+									  val->value.string);
+		else if (type == JSON_VALUE_NUMBER)
+			child = json_array_append(&parent->value.array, type,
+									  val->value.number);
+		else
+			child = json_array_append(&parent->value.array, type);
+	}
+
+	if (!child)
+		return -1;
+
+	if (type == JSON_VALUE_OBJECT || type == JSON_VALUE_ARRAY)
+		stream->stack[stream->depth] = (json_value_t *)child;
+
+	return 0;
+}
+
+static int __json_stream_emit(int event, const json_value_t *val,
+							  json_stream_t *stream)
+{
+	const char *name = stream->has_name ? stream->name : NULL;
+
+	stream->has_name = 0;
+	if (stream->callback)
+		return stream->callback(event, name, val, stream->context);
+
+	return __json_stream_build(event, name, val, stream);
+}
+
+static void __json_stream_value_end(json_stream_t *stream)
+{
+	if (stream->depth > 0)
+		stream->state = JSON_STREAM_NEXT;
+	else
+		stream->state = JSON_STREAM_DONE;
+}
+
+static int __json_stream_begin(int type, json_stream_t *stream)
+{
+	int ret;
+
+	if (stream->depth == JSON_DEPTH_LIMIT)
+		return -3;
+
+	ret = __json_stream_emit(type == '{' ? JSON_EVENT_OBJECT_BEGIN :
+											JSON_EVENT_ARRAY_BEGIN,
+							 NULL, stream);
+	if (ret < 0)
+		return ret;
+
+	stream->types[stream->depth++] = type;
+	if (type == '{')
+		stream->state = JSON_STREAM_FIRST_NAME;
+	else
+		stream->state = JSON_STREAM_FIRST_VALUE;
+
+	return 0;
+}
+
+static int __json_stream_end(json_stream_t *stream)
+{
+	int type = stream->types[--stream->depth];
+	int ret;
+
+	ret = __json_stream_emit(type == '{' ? JSON_EVENT_OBJECT_END :
+											JSON_EVENT_ARRAY_END,
+							 NULL, stream);
+	if (ret < 0)
+		return ret;
+
+	__json_stream_value_end(stream);
+	return 0;
+}
+
+static int __json_stream_string(json_stream_t *stream)
+{
+	json_value_t val;
+	const char *end;
+	size_t len;
+	int ret;
+
+	/* Decode in place, as escapes never make a string longer. */
+	stream->buf[stream->len] = '\"';
+	stream->buf[stream->len + 1] = '\0';
+	ret = __json_string_length(stream->buf);
+	if (ret < 0)
+		return ret;
+
+	ret = __parse_json_string(stream->buf, &end, stream->buf);
+	if (ret < 0)
+		return ret;
+
+	if (stream->is_name)
+	{
+		len = strlen(stream->buf) + 1;
+		if (len > stream->name_size)
+		{
+			free(stream->name);
+			stream->name = (char *)malloc(len);
+			if (!stream->name)
+			{
+				stream->name_size = 0;
+				return -1;
+			}
+
+			stream->name_size = len;
+		}
+
+		memcpy(stream->name, stream->buf, len);
+		stream->has_name = 1;
+		stream->state = JSON_STREAM_COLON;
+		return 0;
+	}
+
+	val.type = JSON_VALUE_STRING;
+	val.value.string = stream->buf;
+	ret = __json_stream_emit(JSON_EVENT_VALUE, &val, stream);
+	if (ret < 0)
+		return ret;
+
+	__json_stream_value_end(stream);
+	return 0;
+}
+
+static int __json_stream_scalar(json_stream_t *stream)
+{
+	json_value_t val;
+	const char *end;
+	int ret;
+
+	stream->buf[stream->len] = '\0';
+	if (strcmp(stream->buf, "true") == 0)
+		val.type = JSON_VALUE_TRUE;
+	else if (strcmp(stream->buf, "false") == 0)
+		val.type = JSON_VALUE_FALSE;
+	else if (strcmp(stream->buf, "null") == 0)
+		val.type = JSON_VALUE_NULL;
+	else
+	{
+		ret = __parse_json_number(stream->buf, &end, &val.value.number);
+		if (ret < 0)
+			return ret;
+
+		if (*end != '\0')
+			return -2;
+
+		val.type = JSON_VALUE_NUMBER;
+	}
+
+	ret = __json_stream_emit(JSON_EVENT_VALUE, &val, stream);
+	if (ret < 0)
+		return ret;
+
+	__json_stream_value_end(stream);
+	return 0;
+}
+
+static int __json_stream_char(char c, json_stream_t *stream)
+{
+	switch (stream->state)
+	{
+	case JSON_STREAM_FIRST_VALUE:
+		if (c == ']')
+			return __json_stream_end(stream);
+
+		/* fall through */
+	case JSON_STREAM_VALUE:
+		if (c == '{' || c == '[')
+			return __json_stream_begin(c, stream);
+
+		stream->len = 0;
+		if (c == '\"')
+		{
+			stream->is_name = 0;
+			stream->state = JSON_STREAM_STRING;
+			return 0;
+		}
+
+		if (c != '-' && !isalnum((unsigned char)c))
+			return -2;
+
+		stream->state = JSON_STREAM_SCALAR;
+		return __json_stream_append(&c, 1, stream);
+
+	case JSON_STREAM_FIRST_NAME:
+		if (c == '}')
+			return __json_stream_end(stream);
+
+		/* fall through */
+	case JSON_STREAM_NAME:
+		if (c != '\"')
+			return -2;
+
+		stream->len = 0;
+		stream->is_name = 1;
+		stream->state = JSON_STREAM_STRING;
+		return 0;
+
+	case JSON_STREAM_COLON:
+		if (c != ':')
+			return -2;
+
+		stream->state = JSON_STREAM_VALUE;
+		return 0;
+
+	case JSON_STREAM_NEXT:
+		if (c == ',')
+		{
+			if (stream->types[stream->depth - 1] == '{')
+				stream->state = JSON_STREAM_NAME;
+			else
+				stream->state = JSON_STREAM_VALUE;
+
+			return 0;
+		}
+
+		if ((c == '}' || c == ']') && stream->types[stream->depth - 1] == c - 2)
+			return __json_stream_end(stream);
+
+		return -2;
+
+	default:
+		return -2;
+	}
+}
+
+static inline int __json_stream_delimiter(char c)
+{
+	switch (c)
+	{
+	case ',': case ']': case '}': case ':': case '[': case '{': case '\"':
+		return 1;
+	default:
+		return isspace(c);
+	}
+}
+
+int json_stream_feed(const char *text, size_t size, json_stream_t *stream)
+{
+	const char *end = text + size;
+	const char *p;
+	int ret = 0;
+
+	if (stream->ret < 0)
+		return stream->ret;
+
+	while (text < end)
+	{
+		if (stream->state == JSON_STREAM_STRING)
+		{
+			if (stream->escape)
+			{
+				stream->escape = 0;
+				ret = __json_stream_append(text++, 1, stream);
+			}
+			else
+			{
+				p = text;
+				while (p < end && *p != '\"' && *p != '\\')
+					p++;
+
+				ret = __json_stream_append(text, p - text, stream);
+				text = p;
+				if (ret >= 0 && p < end)
+				{
+					text++;
+					if (*p == '\\')
+					{
+						stream->escape = 1;
+						ret = __json_stream_append(p, 1, stream);
+					}
+					else
+						ret = __json_stream_string(stream);
+				}
+			}
+		}
+		else if (stream->state == JSON_STREAM_SCALAR)
+		{
+			p = text;
+			while (p < end && !__json_stream_delimiter(*p))
+				p++;
+
+			ret = __json_stream_append(text, p - text, stream);
+			text = p;
+			if (ret >= 0 && p < end)
+				ret = __json_stream_scalar(stream);
+		}
+		else if (isspace(*text))
+			text++;
+		else
+			ret = __json_stream_char(*text++, stream);
+
+		if (ret < 0)
+		{
+			stream->ret = ret;
+			return ret;
+		}
+	}
+
+	return stream->state == JSON_STREAM_DONE;
+}
+
+int json_stream_end(json_stream_t *stream)
+{
+	int ret;
+
+	if (stream->ret < 0)
+		return stream->ret;
+
+	/* A number at the top level ends with the text. */
+	if (stream->state == JSON_STREAM_SCALAR && stream->depth == 0)
+	{
+		ret = __json_stream_scalar(stream);
+		if (ret < 0)
+		{
+			stream->ret = ret;
+			return ret;
+		}
+	}
+
+	if (stream->state != JSON_STREAM_DONE)
+	{
+		stream->ret = -2;
+		return -2;
+	}
+
+	return 1;
+}
+
+json_value_t *json_stream_release(json_stream_t *stream)
+{
+	json_value_t *root = NULL;
+
+	if (stream->state == JSON_STREAM_DONE && stream->ret >= 0)
+	{
+		root = stream->root;
+		stream->root = NULL;
+	}
+
+	return root;
+}
@@ -32,6 +32,7 @@
 typedef struct __json_value json_value_t;
 typedef struct __json_object json_object_t;
 typedef struct __json_array json_array_t;
+typedef struct __json_stream json_stream_t;
 
 #ifdef __cplusplus
 extern "C"
@@ -39,6 +40,11 @@ extern "C"
 #endif
 
 json_value_t *json_value_parse(const char *text);
+/* Same as json_value_parse(), but the whole DOM of an object or array is
+ * put in one growable arena, and json_value_destroy() frees it in one go.
+ * The DOM can still be modified. Values removed from it are returned as
+ * malloc'ed copies. */
+json_value_t *json_value_parse_arena(const char *text);
 json_value_t *json_value_create(int type, ...);
 json_value_t *json_value_copy(const json_value_t *val);
 void json_value_destroy(json_value_t *val);
@@ -49,8 +55,13 @@ double json_value_number(const json_value_t *val);
 json_object_t *json_value_object(const json_value_t *val);
 json_array_t *json_value_array(const json_value_t *val);
 
+/* Of the members named 'name', the one added to the object first, which is
+ * the first in the text for a parsed object. */
 const json_value_t *json_object_find(const char *name,
 									 const json_object_t *obj);
+/* Same as json_object_find(), 'name' needs not be null-terminated. */
+const json_value_t *json_object_find_n(const char *name, size_t len,
+									   const json_object_t *obj);
 int json_object_size(const json_object_t *obj);
 const char *json_object_next_name(const char *name,
 								  const json_object_t *obj);
@@ -90,6 +101,35 @@ const json_value_t *json_array_insert_before(const json_value_t *val,
 json_value_t *json_array_remove(const json_value_t *val,
 								json_array_t *arr);
 
+/* Incremental parsing, for text that arrives in pieces. */
+#define JSON_EVENT_VALUE		1	/* string, number, true, false or null */
+#define JSON_EVENT_OBJECT_BEGIN	2
+#define JSON_EVENT_OBJECT_END	3
+#define JSON_EVENT_ARRAY_BEGIN	4
+#define JSON_EVENT_ARRAY_END	5
+
+/* 'name' is the member name of the value inside an object, and NULL
+ * otherwise. 'val' is the scalar of JSON_EVENT_VALUE, and NULL otherwise.
+ * Both are only valid during the call. Returning a negative number stops
+ * parsing, and json_stream_feed() returns it from then on. */
+typedef int (*json_event_t)(int event, const char *name,
+							const json_value_t *val, void *context);
+
+/* With a NULL 'callback', a DOM is built for json_stream_release().
+ * Otherwise nothing is kept but the string being parsed, so a text of
+ * any size can be handled with the events. */
+json_stream_t *json_stream_create(json_event_t callback, void *context);
+/* Returns 1 once the value is complete, 0 if more text is expected, -1 on
+ * a system error, -2 on a bad format and -3 if nested too deep. Only white
+ * spaces may follow a complete value. */
+int json_stream_feed(const char *text, size_t size, json_stream_t *stream);
+/* No more text. A number at the top level is only complete here. Returns
+ * 1 if the value is complete, or the negative error. */
+int json_stream_end(json_stream_t *stream);
+/* The DOM, after json_stream_end() returned 1. Caller destroys it. */
+json_value_t *json_stream_release(json_stream_t *stream);
+void json_stream_destroy(json_stream_t *stream);
+
 #ifdef __cplusplus
 }
 #endif
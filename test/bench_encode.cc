@@ -0,0 +1,97 @@
+/*
+  Benchmark for EncodeStream.
+
+  Encodes 1M small RESP-style protocol messages: integers through
+  operator<<, a key built on the stack through append_copy() and constant
+  strings through append_nocopy(). Few vectors are given so that some
+  messages are merged as well. Two ways:
+    reset    one stream, reset() for every message;
+    fresh    a new stream for every message.
+  Reports the time per message and the heap allocations per message,
+  counted by a replaced operator new.
+
+  USAGE: bench_encode [messages]
+*/
+
+#include "../src/util/EncodeStream.h"
+#include <assert.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static long allocations;
+
+void *operator new(size_t size) {
+  void *ptr = malloc(size);
+
+  if (!ptr)
+    throw std::bad_alloc();
+
+  allocations++;
+  return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+static void encode_message(EncodeStream &stream, long i) {
+  char key[32];
+  int len = sprintf(key, "user:%ld:profile", i);
+
+  stream << "*" << (int64_t)4 << "\r\n";
+  stream << "$" << (int64_t)3 << "\r\n" << "SET" << "\r\n";
+  stream << "$" << (int64_t)len << "\r\n";
+  stream.append_copy(key, len);
+  stream << "\r\n" << "$" << (int64_t)(i * 7919) << "\r\n";
+  stream << "$" << (int64_t)2 << "\r\n" << "EX" << "\r\n";
+}
+
+int main(int argc, char *argv[]) {
+  long messages = argc > 1 ? atol(argv[1]) : 1000000;
+  struct iovec vectors[16];
+  size_t bytes = 0;
+  long i;
+
+  for (int mode = 0; mode < 2; mode++) {
+    EncodeStream stream;
+
+    /* Warm up the buffer pool. */
+    for (i = 0; i < 1000; i++) {
+      stream.reset(vectors, 16);
+      encode_message(stream, i);
+    }
+
+    long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+
+    for (i = 0; i < messages; i++) {
+      if (mode == 0) {
+        stream.reset(vectors, 16);
+        encode_message(stream, i);
+        assert(stream.size() <= 16);
+        bytes += stream.bytes();
+      } else {
+        EncodeStream fresh(vectors, 16);
+
+        encode_message(fresh, i);
+        assert(fresh.size() <= 16);
+        bytes += fresh.bytes();
+      }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    printf("%-6s %8.1f ns/message %8.3f allocations/message\n",
+           mode == 0 ? "reset" : "fresh", ns / messages,
+           (double)(allocations - before) / messages);
+  }
+
+  printf("%zu bytes encoded\n", bytes);
+  return 0;
+}
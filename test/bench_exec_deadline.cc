@@ -0,0 +1,109 @@
+/*
+  Benchmark for compute sessions with a queue timeout under overload.
+
+  Offers twice the capacity of the compute threads for 2 seconds: tasks of
+  200 us, requested every millisecond in batches. Two ways:
+    none        no queue timeout, the backlog grows for the whole run;
+    5 ms        set_queue_timeout(5), expired tasks are dropped at dequeue.
+  Reports the tasks run and dropped, the latency from request to execute()
+  of the tasks run, the backlog when the offered load stops and the time
+  to drain it.
+
+  USAGE: bench_exec_deadline [seconds]
+*/
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/kernel/Executor.h"
+#include "../src/manager/WFGlobal.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static long long now_nsec() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void spin(long long nsec) {
+  long long end = now_nsec() + nsec;
+
+  while (now_nsec() < end)
+    ;
+}
+
+static std::mutex latency_mutex;
+static std::vector<long long> latency;
+static std::atomic<long> pending;
+static std::atomic<long> dropped;
+
+int main(int argc, char *argv[]) {
+  int seconds = argc > 1 ? atoi(argv[1]) : 2;
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int batch = 2 * threads * 1000000 / 200000;
+  Executor *executor = WFGlobal::get_compute_executor();
+  struct ExecQueueStats stats;
+
+  printf("%7s %8s %8s %10s %10s %9s %10s\n", "timeout", "run", "dropped",
+         "p50 ms", "p99 ms", "backlog", "drain ms");
+  for (int timeout : {-1, 5}) {
+    std::string name = "overload" + std::to_string(timeout);
+    ExecQueue *queue = WFGlobal::get_exec_queue(name);
+    long long end = now_nsec() + seconds * 1000000000LL;
+
+    latency.clear();
+    dropped = 0;
+    while (now_nsec() < end) {
+      for (int i = 0; i < batch; i++) {
+        long long submit = now_nsec();
+        WFGoTask *task = WFTaskFactory::create_go_task(queue, [submit]() {
+          long long wait = now_nsec() - submit;
+
+          spin(200000);
+          std::lock_guard<std::mutex> lock(latency_mutex);
+          latency.push_back(wait);
+        });
+
+        task->set_queue_timeout(timeout);
+        task->set_callback([](WFGoTask *task) {
+          if (task->get_state() == WFT_STATE_ABORTED)
+            dropped++;
+
+          pending--;
+        });
+
+        pending++;
+        task->start();
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    executor->get_queue_stats(queue, &stats);
+    size_t backlog = stats.depth;
+    long long drain = now_nsec();
+
+    while (pending > 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    drain = now_nsec() - drain;
+    std::sort(latency.begin(), latency.end());
+    executor->get_queue_stats(queue, &stats);
+    printf("%7s %8llu %8llu %10.2f %10.2f %9zu %10.1f\n",
+           timeout < 0 ? "none" : "5 ms", stats.executed, stats.expired,
+           latency[latency.size() / 2] / 1e6,
+           latency[latency.size() * 99 / 100] / 1e6, backlog, drain / 1e6);
+    if ((long)stats.expired != dropped)
+      return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+  Benchmark for weighted fair scheduling of compute queues.
+
+  16 batch queues are kept full of 200 us tasks, while one interactive queue
+  gets a 10 us task every millisecond. Two ways:
+    equal       every queue at the default priority and weight;
+    priority    the interactive queue at EXEC_PRIORITY_HIGH, the batch queues
+                at EXEC_PRIORITY_LOW.
+  Then two batch queues with weights 3 and 1 run alone, to show their share
+  of the compute threads.
+  Reports the latency of the interactive tasks from request to execute(),
+  the batch tasks done per second, and the queue stats of the executor.
+
+  USAGE: bench_exec_priority [interactive tasks]
+*/
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/kernel/Executor.h"
+#include "../src/manager/WFGlobal.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+static long long now_nsec() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void spin(long long nsec) {
+  long long end = now_nsec() + nsec;
+
+  while (now_nsec() < end)
+    ;
+}
+
+static std::atomic<bool> batch_stop;
+static std::atomic<long> batch_running;
+static std::atomic<long> batch_done[16];
+
+static void batch(ExecQueue *queue, int i) {
+  WFGoTask *task = WFTaskFactory::create_go_task(queue, [i]() {
+    spin(200000);
+    batch_done[i]++;
+  });
+
+  task->set_callback([queue, i](WFGoTask *) {
+    if (!batch_stop)
+      batch(queue, i);
+    else
+      batch_running--;
+  });
+
+  task->start();
+}
+
+static void start_batch(const std::vector<ExecQueue *> &queues, int depth) {
+  batch_stop = false;
+  for (size_t i = 0; i < queues.size(); i++) {
+    batch_done[i] = 0;
+    for (int j = 0; j < depth; j++) {
+      batch_running++;
+      batch(queues[i], i);
+    }
+  }
+}
+
+static void stop_batch() {
+  batch_stop = true;
+  while (batch_running > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+int main(int argc, char *argv[]) {
+  int samples = argc > 1 ? atoi(argv[1]) : 1000;
+  Executor *executor = WFGlobal::get_compute_executor();
+  ExecQueue *interactive = WFGlobal::get_exec_queue("interactive");
+  std::vector<ExecQueue *> queues;
+  struct ExecQueueStats stats;
+  int i;
+
+  for (i = 0; i < 16; i++)
+    queues.push_back(WFGlobal::get_exec_queue("batch" + std::to_string(i)));
+
+  printf("%9s %10s %10s %10s %12s\n", "mode", "p50 us", "p99 us", "max us",
+         "batch/s");
+  for (int mode = 0; mode < 2; mode++) {
+    std::vector<long long> latency(samples);
+    std::atomic<int> done(0);
+    long batch_total = 0;
+
+    executor->set_queue_priority(interactive, mode ? EXEC_PRIORITY_HIGH
+                                                   : EXEC_PRIORITY_NORMAL);
+    for (ExecQueue *queue : queues)
+      executor->set_queue_priority(queue, mode ? EXEC_PRIORITY_LOW
+                                               : EXEC_PRIORITY_NORMAL);
+
+    start_batch(queues, 4);
+    long long start = now_nsec();
+
+    for (i = 0; i < samples; i++) {
+      long long submit = now_nsec();
+      long long *slot = &latency[i];
+
+      WFGoTask *task =
+          WFTaskFactory::create_go_task(interactive, [submit, slot]() {
+            *slot = now_nsec() - submit;
+            spin(10000);
+          });
+
+      task->set_callback([&done](WFGoTask *) { done++; });
+      task->start();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    while (done < samples)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    double seconds = (now_nsec() - start) / 1e9;
+
+    for (i = 0; i < 16; i++)
+      batch_total += batch_done[i];
+
+    stop_batch();
+    std::sort(latency.begin(), latency.end());
+    printf("%9s %10.1f %10.1f %10.1f %12.0f\n", mode ? "priority" : "equal",
+           latency[samples / 2] / 1e3, latency[samples * 99 / 100] / 1e3,
+           latency[samples - 1] / 1e3, batch_total / seconds);
+  }
+
+  executor->set_queue_priority(queues[0], EXEC_PRIORITY_NORMAL);
+  executor->set_queue_priority(queues[1], EXEC_PRIORITY_NORMAL);
+  executor->set_queue_weight(queues[0], 3);
+  start_batch(std::vector<ExecQueue *>(queues.begin(), queues.begin() + 2), 64);
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  long share0 = batch_done[0];
+  long share1 = batch_done[1];
+
+  stop_batch();
+  printf("weights 3:1 ran %ld:%ld tasks\n", share0, share1);
+
+  executor->get_queue_stats(interactive, &stats);
+  printf("interactive: depth %zu, requests %llu, executed %llu, "
+         "wait avg %.1f us, max %.1f us\n",
+         stats.depth, stats.requests, stats.executed,
+         stats.wait_total / 1e3 / stats.executed, stats.wait_max / 1e3);
+  executor->get_queue_stats(queues[0], &stats);
+  printf("batch0: depth %zu, requests %llu, executed %llu, "
+         "wait avg %.1f us, max %.1f us\n",
+         stats.depth, stats.requests, stats.executed,
+         stats.wait_total / 1e3 / stats.executed, stats.wait_max / 1e3);
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+  Benchmark for compute queue lookup by name.
+
+  Looks up 16 queue names from 1 to 4 threads at once. Two ways:
+    rwlock      an unordered_map under a pthread_rwlock_t, the way
+                WFGlobal::get_exec_queue() used to;
+    global      WFGlobal::get_exec_queue(), append-only hash chains read
+                without a lock.
+  A queue handle kept from WFGlobal::get_exec_queue() costs nothing per
+  task. Reports the time per lookup as seen by each thread.
+
+  USAGE: bench_exec_queue [lookups]
+*/
+
+#include "../src/kernel/Executor.h"
+#include "../src/manager/WFGlobal.h"
+#include <assert.h>
+#include <chrono>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static std::unordered_map<std::string, ExecQueue *> queue_map;
+
+static ExecQueue *rwlock_get_exec_queue(const std::string &queue_name) {
+  ExecQueue *queue = NULL;
+
+  pthread_rwlock_rdlock(&rwlock);
+  auto iter = queue_map.find(queue_name);
+  if (iter != queue_map.cend())
+    queue = iter->second;
+
+  pthread_rwlock_unlock(&rwlock);
+  return queue;
+}
+
+int main(int argc, char *argv[]) {
+  long lookups = argc > 1 ? atol(argv[1]) : 2000000;
+  std::vector<std::string> names;
+  std::vector<ExecQueue *> queues;
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    names.push_back("compute_queue_" + std::to_string(i));
+    queues.push_back(WFGlobal::get_exec_queue(names[i]));
+    queue_map[names[i]] = queues[i];
+  }
+
+  printf("%8s %12s %12s\n", "threads", "rwlock ns", "global ns");
+  for (int threads = 1; threads <= 4; threads *= 2) {
+    double ns[2];
+
+    for (int mode = 0; mode < 2; mode++) {
+      std::vector<std::thread> workers;
+      auto start = std::chrono::steady_clock::now();
+
+      for (i = 0; i < threads; i++) {
+        workers.emplace_back([&names, &queues, lookups, mode]() {
+          uintptr_t sum = 0;
+          uintptr_t expected = 0;
+          long j;
+
+          for (j = 0; j < lookups; j++) {
+            const std::string &name = names[j & 15];
+
+            if (mode == 0)
+              sum += (uintptr_t)rwlock_get_exec_queue(name);
+            else
+              sum += (uintptr_t)WFGlobal::get_exec_queue(name);
+          }
+
+          for (j = 0; j < lookups; j++)
+            expected += (uintptr_t)queues[j & 15];
+
+          assert(sum == expected);
+          (void)sum;
+          (void)expected;
+        });
+      }
+
+      for (auto &worker : workers)
+        worker.join();
+
+      auto end = std::chrono::steady_clock::now();
+      ns[mode] = std::chrono::duration<double, std::nano>(end - start).count() /
+                 lookups;
+    }
+
+    printf("%8d %12.1f %12.1f\n", threads, ns[0], ns[1]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*
+  Benchmark for file IO tasks.
+
+  Reads 4 KB blocks at random offsets of a 64 MB file, in the page cache
+  after the first pass, with pread tasks. QD tasks are in flight at a time:
+  the first ones start from main(), and every callback starts the next one
+  from a handler thread, where requests are submitted together when the
+  callback returns. Reports the reads per second for every queue depth.
+
+  USAGE: bench_file_io [reads] [file]
+*/
+
+#include "../src/factory/WFTaskFactory.h"
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#define BLOCK_SIZE 4096
+#define FILE_SIZE (64 << 20)
+
+static int fd;
+static std::atomic<long> issued;
+static std::atomic<long> finished;
+static long total;
+static std::mutex done_mutex;
+static std::condition_variable done_cond;
+
+static void read_next(char *buf);
+
+static void read_done(WFFileIOTask *task) {
+  char *buf = (char *)task->get_args()->buf;
+
+  assert(task->get_retval() == BLOCK_SIZE);
+  if (++finished == total) {
+    std::lock_guard<std::mutex> lock(done_mutex);
+    done_cond.notify_one();
+  }
+
+  read_next(buf);
+}
+
+static void read_next(char *buf) {
+  if (issued++ >= total)
+    return;
+
+  off_t offset = (off_t)(rand() % (FILE_SIZE / BLOCK_SIZE)) * BLOCK_SIZE;
+  WFTaskFactory::create_pread_task(fd, buf, BLOCK_SIZE, offset, read_done)
+      ->start();
+}
+
+int main(int argc, char *argv[]) {
+  long reads = argc > 1 ? atol(argv[1]) : 200000;
+  const char *path = argc > 2 ? argv[2] : "bench_file_io.dat";
+  static const int depths[] = {1, 16, 128};
+  std::vector<char> block(BLOCK_SIZE, 'x');
+  int i;
+
+  fd = open(path, O_RDWR | O_CREAT, 0644);
+  assert(fd >= 0);
+  for (i = 0; i < FILE_SIZE / BLOCK_SIZE; i++)
+    assert(pwrite(fd, block.data(), BLOCK_SIZE, (off_t)i * BLOCK_SIZE) ==
+           BLOCK_SIZE);
+
+  printf("%6s %14s\n", "QD", "reads/s");
+  for (int pass = 0; pass < 2; pass++) {
+    for (const int depth : depths) {
+      std::vector<char> bufs((size_t)depth * BLOCK_SIZE);
+      auto start = std::chrono::steady_clock::now();
+
+      issued = 0;
+      finished = 0;
+      total = reads;
+      for (i = 0; i < depth; i++)
+        read_next(&bufs[(size_t)i * BLOCK_SIZE]);
+
+      {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cond.wait(lock, [] { return finished == total; });
+      }
+
+      /* Every callback starts another read, the last ones start nothing. */
+      while (issued < total + depth)
+        usleep(1000);
+
+      auto end = std::chrono::steady_clock::now();
+      double s = std::chrono::duration<double>(end - start).count();
+
+      if (pass)
+        printf("%6d %14.0f\n", depth, reads / s);
+    }
+  }
+
+  close(fd);
+  unlink(path);
+  return 0;
+}
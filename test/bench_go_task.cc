@@ -0,0 +1,128 @@
+/*
+  Benchmark for go tasks.
+
+  Runs small CPU-bound closures on the compute threads, in waves of 1000
+  tasks. The closure captures 48 bytes, too big for the local buffer of a
+  std::function. Two ways:
+    typed       WFTaskFactory::create_go_task(), the closure stored in the
+                task;
+    function    a go task holding a std::function<void()>, the way a
+                type-erased go task would.
+  A first wave warms up the threads. Reports the time per task and the heap
+  allocations per task, counted by a replaced operator new and malloc(). A
+  started task allocates its series and an executor entry as well.
+
+  USAGE: bench_go_task [tasks]
+*/
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/manager/WFGlobal.h"
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+extern "C" void *__libc_malloc(size_t size);
+
+static std::atomic<long> allocations(0);
+
+extern "C" void *malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+
+void *operator new(size_t size) {
+  void *ptr = malloc(size);
+
+  if (!ptr)
+    throw std::bad_alloc();
+
+  return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+class FunctionGoTask : public WFGoTask {
+protected:
+  virtual void execute() { this->go(); }
+
+protected:
+  std::function<void()> go;
+
+public:
+  FunctionGoTask(ExecQueue *queue, Executor *executor,
+                 std::function<void()> &&func)
+      : WFGoTask(queue, executor), go(std::move(func)) {}
+};
+
+static std::mutex wave_mutex;
+static std::condition_variable wave_cond;
+static int running;
+static std::atomic<long> total(0);
+
+static void task_done(WFGoTask *) {
+  std::lock_guard<std::mutex> lock(wave_mutex);
+
+  if (--running == 0)
+    wave_cond.notify_one();
+}
+
+static void work(long a, long b, long c, long d, long e, long f) {
+  total += (a ^ b) + (c ^ d) + (e ^ f);
+}
+
+int main(int argc, char *argv[]) {
+  long tasks = argc > 1 ? atol(argv[1]) : 200000;
+  const int wave = 1000;
+  ExecQueue *queue = WFGlobal::get_exec_queue("bench");
+  Executor *executor = WFGlobal::get_compute_executor();
+
+  for (int mode = -1; mode < 2; mode++) {
+    long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    long i = 0;
+
+    while (i < tasks) {
+      running = wave;
+      for (int j = 0; j < wave; j++, i++) {
+        long a = i, b = i * 3, c = i * 5, d = i * 7, e = i * 11, f = i * 13;
+        auto go = [a, b, c, d, e, f]() { work(a, b, c, d, e, f); };
+        WFGoTask *task;
+
+        if (mode <= 0)
+          task = WFTaskFactory::create_go_task("bench", go);
+        else
+          task = new FunctionGoTask(queue, executor, go);
+
+        task->set_callback(task_done);
+        task->start();
+      }
+
+      std::unique_lock<std::mutex> lock(wave_mutex);
+      while (running > 0)
+        wave_cond.wait(lock);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    if (mode < 0)
+      continue;
+
+    printf("%-9s %8.1f ns/task %8.3f allocations/task\n",
+           mode == 0 ? "typed" : "function", ns / i,
+           (double)(allocations - before) / i);
+  }
+
+  assert(total != 0);
+  return 0;
+}
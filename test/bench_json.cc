@@ -0,0 +1,174 @@
+/*
+  Benchmark for json_parser.
+
+  Times parse + destroy of three synthetic corpora with the malloc'ed DOM
+  and with the arena DOM:
+    twitter   an API payload of records with nested objects, strings with
+              escapes, numbers and literals (twitter.json style);
+    numbers   a big array of floating point numbers;
+    nesting   arrays and objects nested close to the depth limit.
+  The arena DOM must be the same tree as the malloc'ed one.
+
+  USAGE: bench_json [records] [rounds]
+*/
+
+#include "../src/util/json_parser.h"
+#include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static std::string make_twitter(int records) {
+  std::string text = "{\"code\":0,\"message\":\"ok\",\"data\":[";
+  char buf[1024];
+  int i;
+
+  for (i = 0; i < records; i++) {
+    snprintf(buf, sizeof buf,
+             "%s{\"id\":%d,\"name\":\"user_%d\",\"email\":\"user%d@example.com\","
+             "\"score\":%d.%02d,\"active\":%s,\"tags\":[\"a\",\"b\\u00e9\",\"c\"],"
+             "\"text\":\"RT \\\"hello\\\" \\\\ world\\n\",\n  "
+             "\"address\":{\"city\":\"Beijing\",\"zip\":\"1000%02d\","
+             "\"geo\":{\"lat\":39.9%d,\"lng\":116.3%d}},\"note\":null}",
+             i ? "," : "", i, i, i, i % 100, i % 97, i % 2 ? "true" : "false",
+             i % 100, i % 10, i % 7);
+    text += buf;
+  }
+
+  text += "]}";
+  return text;
+}
+
+static std::string make_numbers(int records) {
+  std::string text = "[";
+  char buf[64];
+  int i;
+
+  for (i = 0; i < records * 40; i++) {
+    snprintf(buf, sizeof buf, "%s%ld.%06ld", i ? "," : "", i * 7919L % 100000,
+             i * 104729L % 1000000);
+    text += buf;
+  }
+
+  text += "]";
+  return text;
+}
+
+static std::string make_nesting(int records) {
+  std::string text = "[";
+  int i;
+  int j;
+
+  for (i = 0; i < records / 4; i++) {
+    if (i)
+      text += ',';
+
+    for (j = 0; j < 500; j++)
+      text += j % 2 ? "{\"k\":" : "[";
+
+    text += "1";
+    for (j = 499; j >= 0; j--)
+      text += j % 2 ? "}" : "]";
+  }
+
+  text += "]";
+  return text;
+}
+
+static bool equal(const json_value_t *a, const json_value_t *b) {
+  const json_value_t *va = NULL;
+  const json_value_t *vb = NULL;
+  const char *na = NULL;
+  const char *nb = NULL;
+  json_object_t *oa;
+  json_object_t *ob;
+
+  if (json_value_type(a) != json_value_type(b))
+    return false;
+
+  switch (json_value_type(a)) {
+  case JSON_VALUE_STRING:
+    return strcmp(json_value_string(a), json_value_string(b)) == 0;
+  case JSON_VALUE_NUMBER:
+    return json_value_number(a) == json_value_number(b);
+  case JSON_VALUE_OBJECT:
+    oa = json_value_object(a);
+    ob = json_value_object(b);
+    if (json_object_size(oa) != json_object_size(ob))
+      return false;
+
+    while ((na = json_object_next_name(na, oa)) &&
+           (nb = json_object_next_name(nb, ob))) {
+      va = json_object_next_value(va, oa);
+      vb = json_object_next_value(vb, ob);
+      if (strcmp(na, nb) != 0 || !equal(va, vb))
+        return false;
+    }
+
+    return true;
+  case JSON_VALUE_ARRAY:
+    if (json_array_size(json_value_array(a)) !=
+        json_array_size(json_value_array(b)))
+      return false;
+
+    while ((va = json_array_next_value(va, json_value_array(a))) &&
+           (vb = json_array_next_value(vb, json_value_array(b)))) {
+      if (!equal(va, vb))
+        return false;
+    }
+
+    return true;
+  default:
+    return true;
+  }
+}
+
+typedef json_value_t *(*parse_t)(const char *);
+
+static void run(const char *name, parse_t parse, const std::string &text,
+                int rounds) {
+  double parse_ms = 0;
+  double destroy_ms = 0;
+  json_value_t *expect = json_value_parse(text.c_str());
+  json_value_t *val;
+  int i;
+
+  for (i = 0; i < rounds; i++) {
+    auto t0 = std::chrono::steady_clock::now();
+    val = parse(text.c_str());
+    auto t1 = std::chrono::steady_clock::now();
+    assert(val);
+    if (i == 0)
+      assert(equal(val, expect));
+
+    json_value_destroy(val);
+    auto t2 = std::chrono::steady_clock::now();
+
+    parse_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    destroy_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+  }
+
+  json_value_destroy(expect);
+  printf("  %-24s parse %8.3f (%7.1f MB/s)  destroy %8.3f\n", name,
+         parse_ms / rounds, text.size() / (parse_ms / rounds) / 1e3,
+         destroy_ms / rounds);
+}
+
+static void run_corpus(const char *name, const std::string &text,
+                       int rounds) {
+  printf("%s: %zu bytes, ms per round\n", name, text.size());
+  run("json_value_parse", json_value_parse, text, rounds);
+  run("json_value_parse_arena", json_value_parse_arena, text, rounds);
+}
+
+int main(int argc, char *argv[]) {
+  int records = argc > 1 ? atoi(argv[1]) : 4000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+  run_corpus("twitter", make_twitter(records), rounds);
+  run_corpus("numbers", make_numbers(records), rounds);
+  run_corpus("nesting", make_nesting(records), rounds);
+  return 0;
+}
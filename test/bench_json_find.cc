@@ -0,0 +1,110 @@
+/*
+  Benchmark for json_object_find().
+
+  Looks up members of objects of 10 to 10000 members, with names like the
+  fields of an API payload. Nine lookups in ten hit. Reports the time per
+  lookup of json_object_find() and json_object_find_n() with names of known
+  length, and the time of the first lookup in a fresh object, which builds
+  the hash index of a big object.
+
+  USAGE: bench_json_find [lookups]
+*/
+
+#include "../src/util/json_parser.h"
+#include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string member_name(int i) {
+  char buf[64];
+
+  snprintf(buf, sizeof buf, "user_profile_field_%d", i);
+  return buf;
+}
+
+static std::string make_object(int members) {
+  std::string text = "{";
+  int i;
+
+  for (i = 0; i < members; i++) {
+    if (i)
+      text += ',';
+
+    text += '\"' + member_name(i) + "\":" + std::to_string(i);
+  }
+
+  text += '}';
+  return text;
+}
+
+int main(int argc, char *argv[]) {
+  int lookups = argc > 1 ? atoi(argv[1]) : 2000000;
+  static const int sizes[] = {10, 100, 1000, 10000};
+  std::vector<std::string> names;
+  json_value_t *val;
+  json_object_t *obj;
+  double find_ns, find_n_ns, first_us;
+  long hits;
+  int members;
+  int i, j;
+
+  printf("%8s %12s %12s %14s\n", "members", "find ns", "find_n ns",
+         "first find us");
+  for (i = 0; i < 4; i++) {
+    members = sizes[i];
+    std::string text = make_object(members);
+
+    names.clear();
+    srand(members);
+    for (j = 0; j < 4096; j++) {
+      if (j % 10 == 9)
+        names.push_back(member_name(members + rand() % members));
+      else
+        names.push_back(member_name(rand() % members));
+    }
+
+    val = json_value_parse(text.c_str());
+    assert(val);
+    obj = json_value_object(val);
+    auto t0 = Clock::now();
+    assert(json_object_find(names[0].c_str(), obj));
+    auto t1 = Clock::now();
+    first_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+    hits = 0;
+    t0 = Clock::now();
+    for (j = 0; j < lookups; j++) {
+      if (json_object_find(names[j & 4095].c_str(), obj))
+        hits++;
+    }
+
+    t1 = Clock::now();
+    find_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() /
+              lookups;
+
+    t0 = Clock::now();
+    for (j = 0; j < lookups; j++) {
+      const std::string &name = names[j & 4095];
+
+      if (json_object_find_n(name.c_str(), name.size(), obj))
+        hits--;
+    }
+
+    t1 = Clock::now();
+    find_n_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                lookups;
+
+    assert(hits == 0);
+    json_value_destroy(val);
+    printf("%8d %12.1f %12.1f %14.1f\n", members, find_ns, find_n_ns,
+           first_us);
+  }
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+/*
+  Benchmark for incremental JSON parsing.
+
+  Delivers an HTTP request with a large JSON body to HttpRequest::append()
+  in segments, the way the communicator does, and measures how long after
+  the last segment the DOM is ready:
+    buffer   json_value_parse() on the parsed body after the last segment;
+    stream   json_stream_feed() from the body callback, keeping the body;
+    discard  the same, dropping the body bytes once they are parsed;
+    events   event callbacks only, counting values, no DOM at all.
+  The total time for the whole message is reported as well, and the DOMs
+  must be equal.
+
+  USAGE: bench_json_stream [records] [segment size] [rounds]
+*/
+
+#include "../src/protocol/HttpMessage.h"
+#include "../src/util/json_parser.h"
+#include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace protocol;
+using Clock = std::chrono::steady_clock;
+
+/* append() is for the communicator only. */
+class BenchRequest : public HttpRequest {
+public:
+  using HttpRequest::append;
+};
+
+static std::string make_payload(int records) {
+  std::string text = "{\"code\":0,\"message\":\"ok\",\"data\":[";
+  char buf[1024];
+  int i;
+
+  for (i = 0; i < records; i++) {
+    snprintf(buf, sizeof buf,
+             "%s{\"id\":%d,\"name\":\"user_%d\",\"email\":\"user%d@example.com\","
+             "\"score\":%d.%02d,\"active\":%s,\"tags\":[\"a\",\"b\\u00e9\",\"c\"],"
+             "\"text\":\"RT \\\"hello\\\" \\\\ world\\n\","
+             "\"address\":{\"city\":\"Beijing\",\"zip\":\"1000%02d\","
+             "\"geo\":{\"lat\":39.9%d,\"lng\":116.3%d}},\"note\":null}",
+             i ? "," : "", i, i, i, i % 100, i % 97, i % 2 ? "true" : "false",
+             i % 100, i % 10, i % 7);
+    text += buf;
+  }
+
+  text += "]}";
+  return text;
+}
+
+static int count_event(int event, const char *name, const json_value_t *val,
+                       void *context) {
+  ++*(long *)context;
+  return 0;
+}
+
+enum { MODE_BUFFER, MODE_STREAM, MODE_DISCARD, MODE_EVENTS };
+
+static const char *mode_name[] = {"buffer", "stream", "discard", "events"};
+
+/* Returns the DOM, NULL for MODE_EVENTS. */
+static json_value_t *run(int mode, const std::string &msg, size_t segment,
+                         double *last_us, double *total_us) {
+  BenchRequest req;
+  json_stream_t *stream = NULL;
+  json_value_t *root = NULL;
+  long events = 0;
+  const void *body;
+  size_t body_size;
+  size_t off = 0;
+  size_t n;
+  int ret = 0;
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point last;
+
+  if (mode == MODE_EVENTS)
+    stream = json_stream_create(count_event, &events);
+  else if (mode != MODE_BUFFER)
+    stream = json_stream_create(NULL, NULL);
+
+  if (stream) {
+    req.set_body_callback(
+        [stream](const void *buf, size_t size) {
+          return json_stream_feed((const char *)buf, size, stream) < 0 ? -1 : 0;
+        },
+        mode != MODE_STREAM);
+  }
+
+  while (off < msg.size()) {
+    n = std::min(segment, msg.size() - off);
+    if (off + n == msg.size())
+      last = Clock::now();
+
+    ret = req.append(msg.data() + off, &n);
+    off += n;
+    if (ret != 0)
+      break;
+  }
+
+  assert(ret == 1);
+  if (stream) {
+    ret = json_stream_end(stream);
+    assert(ret == 1);
+    root = json_stream_release(stream);
+    json_stream_destroy(stream);
+  } else {
+    req.get_parsed_body(&body, &body_size);
+    root = json_value_parse((const char *)body);
+  }
+
+  Clock::time_point end = Clock::now();
+  *last_us = std::chrono::duration<double, std::micro>(end - last).count();
+  *total_us = std::chrono::duration<double, std::micro>(end - start).count();
+  assert(mode == MODE_EVENTS ? events > 0 : root != NULL);
+  return root;
+}
+
+static bool equal(const json_value_t *a, const json_value_t *b) {
+  const json_value_t *va = NULL, *vb = NULL;
+  const char *na = NULL, *nb = NULL;
+
+  if (json_value_type(a) != json_value_type(b))
+    return false;
+
+  switch (json_value_type(a)) {
+  case JSON_VALUE_STRING:
+    return strcmp(json_value_string(a), json_value_string(b)) == 0;
+  case JSON_VALUE_NUMBER:
+    return json_value_number(a) == json_value_number(b);
+  case JSON_VALUE_OBJECT:
+    if (json_object_size(json_value_object(a)) !=
+        json_object_size(json_value_object(b)))
+      return false;
+
+    while ((na = json_object_next_name(na, json_value_object(a)))) {
+      nb = json_object_next_name(nb, json_value_object(b));
+      va = json_object_next_value(va, json_value_object(a));
+      vb = json_object_next_value(vb, json_value_object(b));
+      if (strcmp(na, nb) != 0 || !equal(va, vb))
+        return false;
+    }
+
+    return true;
+  case JSON_VALUE_ARRAY:
+    if (json_array_size(json_value_array(a)) !=
+        json_array_size(json_value_array(b)))
+      return false;
+
+    while ((va = json_array_next_value(va, json_value_array(a)))) {
+      vb = json_array_next_value(vb, json_value_array(b));
+      if (!equal(va, vb))
+        return false;
+    }
+
+    return true;
+  default:
+    return true;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int records = argc > 1 ? atoi(argv[1]) : 20000;
+  size_t segment = argc > 2 ? atol(argv[2]) : 16384;
+  int rounds = argc > 3 ? atoi(argv[3]) : 10;
+  std::string body = make_payload(records);
+  std::string msg = "POST /api HTTP/1.1\r\nHost: localhost\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Content-Length: " +
+                    std::to_string(body.size()) + "\r\n\r\n" + body;
+  json_value_t *expected;
+  json_value_t *root;
+  double last, total;
+  double best_last, best_total;
+  int mode;
+  int i;
+
+  printf("body %zu bytes, segments of %zu bytes\n", body.size(), segment);
+  expected = run(MODE_BUFFER, msg, segment, &last, &total);
+
+  for (mode = MODE_BUFFER; mode <= MODE_EVENTS; mode++) {
+    best_last = best_total = 1e30;
+    for (i = 0; i < rounds; i++) {
+      root = run(mode, msg, segment, &last, &total);
+      if (root) {
+        assert(equal(root, expected));
+        json_value_destroy(root);
+      }
+
+      best_last = std::min(best_last, last);
+      best_total = std::min(best_total, total);
+    }
+
+    printf("%-8s after last segment %10.1f us, whole message %10.1f us\n",
+           mode_name[mode], best_last, best_total);
+  }
+
+  json_value_destroy(expected);
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*
+  Benchmark for JsonWriter.
+
+  Serializes a parsed API payload (records with nested objects, strings
+  with escapes and numbers) into an HttpResponse output body, three ways:
+    concat   the usual hand-rolled std::string concatenation with
+             snprintf("%.17g") for numbers, then append_output_body();
+    value    JsonWriter::value() on the json_value_t;
+    stream   JsonWriter calls that emit the same records without a DOM.
+  The outputs must parse back to the same number of records.
+
+  USAGE: bench_json_writer [records] [rounds]
+*/
+
+#include "../src/protocol/HttpMessage.h"
+#include "../src/util/JsonWriter.h"
+#include "../src/util/json_parser.h"
+#include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace protocol;
+
+static std::string make_payload(int records) {
+  std::string text = "{\"code\":0,\"message\":\"ok\",\"data\":[";
+  char buf[1024];
+  int i;
+
+  for (i = 0; i < records; i++) {
+    snprintf(buf, sizeof buf,
+             "%s{\"id\":%d,\"name\":\"user_%d\",\"email\":\"user%d@example.com\","
+             "\"score\":%d.%02d,\"active\":%s,\"tags\":[\"a\",\"b\\u00e9\",\"c\"],"
+             "\"text\":\"RT \\\"hello\\\" \\\\ world\\n\","
+             "\"address\":{\"city\":\"Beijing\",\"zip\":\"1000%02d\","
+             "\"geo\":{\"lat\":39.9%d,\"lng\":116.3%d}},\"note\":null}",
+             i ? "," : "", i, i, i, i % 100, i % 97, i % 2 ? "true" : "false",
+             i % 100, i % 10, i % 7);
+    text += buf;
+  }
+
+  text += "]}";
+  return text;
+}
+
+static void concat_string(std::string &out, const char *str) {
+  out += '\"';
+  for (; *str; str++) {
+    switch (*str) {
+    case '\"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    default:
+      out += *str;
+      break;
+    }
+  }
+
+  out += '\"';
+}
+
+static void concat_value(std::string &out, const json_value_t *val) {
+  const json_value_t *child = NULL;
+  const char *name = NULL;
+  char buf[32];
+
+  switch (json_value_type(val)) {
+  case JSON_VALUE_STRING:
+    concat_string(out, json_value_string(val));
+    break;
+  case JSON_VALUE_NUMBER:
+    snprintf(buf, sizeof buf, "%.17g", json_value_number(val));
+    out += buf;
+    break;
+  case JSON_VALUE_OBJECT:
+    out += '{';
+    while ((name = json_object_next_name(name, json_value_object(val)))) {
+      child = json_object_next_value(child, json_value_object(val));
+      if (out.back() != '{')
+        out += ',';
+
+      concat_string(out, name);
+      out += ':';
+      concat_value(out, child);
+    }
+
+    out += '}';
+    break;
+  case JSON_VALUE_ARRAY:
+    out += '[';
+    while ((child = json_array_next_value(child, json_value_array(val)))) {
+      if (out.back() != '[')
+        out += ',';
+
+      concat_value(out, child);
+    }
+
+    out += ']';
+    break;
+  case JSON_VALUE_TRUE:
+    out += "true";
+    break;
+  case JSON_VALUE_FALSE:
+    out += "false";
+    break;
+  default:
+    out += "null";
+    break;
+  }
+}
+
+static void stream_records(JsonWriter &w, int records) {
+  char buf[64];
+  int i;
+
+  w.begin_object().key("code").integer(0).key("message").string("ok");
+  w.key("data").begin_array();
+  for (i = 0; i < records; i++) {
+    w.begin_object().key("id").integer(i);
+    snprintf(buf, sizeof buf, "user_%d", i);
+    w.key("name").string(buf);
+    snprintf(buf, sizeof buf, "user%d@example.com", i);
+    w.key("email").string(buf);
+    w.key("score").number(i % 100 + i % 97 / 100.0);
+    w.key("active").boolean(i % 2);
+    w.key("tags").begin_array().string("a").string("b\xc3\xa9").string("c");
+    w.end_array();
+    w.key("text").string("RT \"hello\" \\ world\n");
+    w.key("address").begin_object().key("city").string("Beijing");
+    snprintf(buf, sizeof buf, "1000%02d", i % 100);
+    w.key("zip").string(buf);
+    w.key("geo").begin_object();
+    w.key("lat").number(39.9 + i % 10 / 100.0);
+    w.key("lng").number(116.3 + i % 7 / 100.0);
+    w.end_object().end_object();
+    w.key("note").null().end_object();
+  }
+
+  w.end_array().end_object();
+}
+
+static int count_records(const HttpResponse &resp) {
+  std::string body;
+  json_value_t *val;
+  int n;
+
+  resp.get_output_body_merged(body);
+  val = json_value_parse(body.c_str());
+  assert(val);
+  n = json_array_size(json_value_array(
+      json_object_find("data", json_value_object(val))));
+  json_value_destroy(val);
+  return n;
+}
+
+template <class FUNC>
+static void run(const char *name, int records, int rounds, FUNC func) {
+  double ms = 0;
+  size_t bytes = 0;
+  int i;
+
+  for (i = 0; i < rounds; i++) {
+    HttpResponse resp;
+
+    auto start = std::chrono::steady_clock::now();
+    func(resp);
+    auto end = std::chrono::steady_clock::now();
+
+    ms += std::chrono::duration<double, std::milli>(end - start).count();
+    bytes = resp.get_output_body_size();
+    if (i == 0)
+      assert(count_records(resp) == records);
+  }
+
+  printf("  %-8s %8.3f ms  %8.1f MB/s  (%zu bytes)\n", name, ms / rounds,
+         bytes / (ms / rounds) / 1e3, bytes);
+}
+
+int main(int argc, char *argv[]) {
+  int records = argc > 1 ? atoi(argv[1]) : 4000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 20;
+  std::string text = make_payload(records);
+  json_value_t *val = json_value_parse(text.c_str());
+
+  assert(val);
+  printf("%d records, ms per round\n", records);
+  run("concat", records, rounds, [val](HttpResponse &resp) {
+    std::string out;
+    concat_value(out, val);
+    resp.append_output_body(out);
+  });
+  run("value", records, rounds, [val](HttpResponse &resp) {
+    JsonWriter w(&resp);
+    w.value(val);
+  });
+  run("stream", records, rounds, [records](HttpResponse &resp) {
+    JsonWriter w(&resp);
+    stream_records(w, records);
+  });
+
+  json_value_destroy(val);
+  return 0;
+}
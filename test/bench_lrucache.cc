@@ -0,0 +1,122 @@
+/*
+  Trace-replay benchmark for LRUCache eviction/admission policies.
+
+  Replays a synthetic Zipf trace and a Zipf trace interleaved with large
+  one-pass scans, reports hit ratio and ops/sec per policy.
+
+  USAGE: bench_lrucache [cache_size] [requests]
+*/
+
+#include "../src/util/LRUCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#define KEY_SPACE 100000
+#define ZIPF_ALPHA 0.99
+
+struct ValueDeleter {
+  void operator()(int &value) const {}
+};
+
+static std::vector<uint64_t> zipf_trace(size_t n, size_t keys, double alpha,
+                                        unsigned int seed) {
+  std::vector<double> cdf(keys);
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::vector<uint64_t> trace;
+  double sum = 0;
+  size_t i;
+
+  for (i = 0; i < keys; i++) {
+    sum += 1.0 / pow((double)(i + 1), alpha);
+    cdf[i] = sum;
+  }
+
+  trace.reserve(n);
+  for (i = 0; i < n; i++) {
+    double r = dist(rng) * sum;
+    trace.push_back(std::lower_bound(cdf.begin(), cdf.end(), r) - cdf.begin());
+  }
+
+  return trace;
+}
+
+/* Every `period` requests, splice in a scan of `scan_len` never-seen keys. */
+static std::vector<uint64_t> scan_trace(const std::vector<uint64_t> &zipf,
+                                        size_t period, size_t scan_len) {
+  std::vector<uint64_t> trace;
+  uint64_t next_scan_key = KEY_SPACE;
+  size_t i, j;
+
+  for (i = 0; i < zipf.size(); i++) {
+    if (i % period == 0 && i > 0) {
+      for (j = 0; j < scan_len; j++)
+        trace.push_back(next_scan_key++);
+    }
+
+    trace.push_back(zipf[i]);
+  }
+
+  return trace;
+}
+
+template <class CACHE>
+static void replay(const char *name, const std::vector<uint64_t> &trace,
+                   size_t cache_size) {
+  CACHE cache;
+  size_t hits = 0;
+
+  cache.set_max_size(cache_size);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t key : trace) {
+    auto *handle = cache.get(key);
+
+    if (handle)
+      hits++;
+    else
+      handle = cache.put(key, 0);
+
+    cache.release(handle);
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double secs = std::chrono::duration<double>(end - start).count();
+
+  printf("  %-16s hit ratio %6.2f%%  %8.2f Mops/s\n", name,
+         100.0 * hits / trace.size(), trace.size() / secs / 1e6);
+}
+
+static void run_all(const char *title, const std::vector<uint64_t> &trace,
+                    size_t cache_size) {
+  typedef uint64_t K;
+
+  printf("%s: %zu requests, cache size %zu\n", title, trace.size(),
+         cache_size);
+  replay<LRUCache<K, int, ValueDeleter>>("LRU", trace, cache_size);
+  replay<LRUCache<K, int, ValueDeleter, ClockPolicy<K>>>("CLOCK", trace,
+                                                         cache_size);
+  replay<LRUCache<K, int, ValueDeleter, S3FIFOPolicy<K>>>("S3-FIFO", trace,
+                                                          cache_size);
+  replay<LRUCache<K, int, ValueDeleter, LRUPolicy<K>, TinyLFUAdmit<K>>>(
+      "LRU+TinyLFU", trace, cache_size);
+  replay<LRUCache<K, int, ValueDeleter, ClockPolicy<K>, TinyLFUAdmit<K>>>(
+      "CLOCK+TinyLFU", trace, cache_size);
+  replay<LRUCache<K, int, ValueDeleter, S3FIFOPolicy<K>, TinyLFUAdmit<K>>>(
+      "S3-FIFO+TinyLFU", trace, cache_size);
+}
+
+int main(int argc, char *argv[]) {
+  size_t cache_size = argc > 1 ? atol(argv[1]) : 2000;
+  size_t requests = argc > 2 ? atol(argv[2]) : 1000000;
+  std::vector<uint64_t> zipf = zipf_trace(requests, KEY_SPACE, ZIPF_ALPHA, 1);
+
+  run_all("zipf", zipf, cache_size);
+  run_all("zipf+scan", scan_trace(zipf, 20000, 4 * cache_size), cache_size);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+  Benchmark for HttpMessage output bodies.
+
+  Builds responses the way test/http_echo_server.cc does: a constant by
+  reference, then many small formatted pieces with append_output_body(),
+  then another constant. Every response is encoded with the 2048 iovecs the
+  communicator gives, and with 64 iovecs to force combining. Reports the
+  time per response, the iovecs of encode() and the malloc() calls per
+  response, counted by a replaced malloc().
+
+  USAGE: bench_output_body [responses]
+*/
+
+#include "../src/protocol/HttpMessage.h"
+#include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+extern "C" void *__libc_malloc(size_t size);
+
+static long allocations;
+
+extern "C" void *malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+
+using namespace protocol;
+
+/* encode() is for the communicator only. */
+class BenchResponse : public HttpResponse {
+public:
+  using HttpResponse::encode;
+};
+
+static void build(BenchResponse &resp, int pieces) {
+  char buf[256];
+  int len;
+  int i;
+
+  resp.set_http_version("HTTP/1.1");
+  resp.set_status_code("200");
+  resp.set_reason_phrase("OK");
+  resp.append_output_body_nocopy("<html>", 6);
+  for (i = 0; i < pieces; i++) {
+    len = snprintf(buf, sizeof buf, "<p>X-Header-%d: value of header %d</p>",
+                   i, i * 7919);
+    resp.append_output_body(buf, len);
+  }
+
+  resp.append_output_body_nocopy("</html>", 7);
+}
+
+int main(int argc, char *argv[]) {
+  long responses = argc > 1 ? atol(argv[1]) : 100000;
+  static const int pieces[] = {10, 100, 1000};
+  static const int maxes[] = {2048, 64};
+  static struct iovec vectors[2048];
+  int vecs = 0;
+  long i;
+
+  printf("%7s %6s %14s %8s %20s\n", "pieces", "iovecs", "ns/response",
+         "encode", "mallocs/response");
+  for (const int max : maxes) {
+    for (const int n : pieces) {
+      long count = responses * 10 / n;
+      long before = allocations;
+      auto start = std::chrono::steady_clock::now();
+
+      for (i = 0; i < count; i++) {
+        BenchResponse resp;
+
+        build(resp, n);
+        vecs = resp.encode(vectors, max);
+        assert(vecs > 0);
+      }
+
+      auto end = std::chrono::steady_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+      printf("%7d %6d %14.1f %8d %20.2f\n", n, max, ns / count, vecs,
+             (double)(allocations - before) / count);
+    }
+  }
+
+  return 0;
+}
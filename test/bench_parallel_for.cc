@@ -0,0 +1,158 @@
+/*
+  Scaling benchmark for parallel-for tasks.
+
+  Scores 100k items, a few hundred flops each, with 1 to N compute threads.
+  Every thread count runs in a child process, because the number of compute
+  threads is fixed when the library starts. Three ways:
+    parallel-for  WFTaskFactory::create_parallel_for_task();
+    map-reduce    WFMapReduceTaskFactory::create_map_reduce_task(), summing
+                  the scores;
+    series        a ParallelWork of one SeriesWork per thread, each with a go
+                  task over a fixed slice, the way it was built by hand.
+  Reports the best of 5 runs in ms and the speedup over one thread.
+
+  USAGE: bench_parallel_for [items] [max threads]
+*/
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/factory/Workflow.h"
+#include "../src/manager/WFGlobal.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static std::mutex run_mutex;
+static std::condition_variable run_cond;
+static bool run_done;
+
+static void finish() {
+  std::lock_guard<std::mutex> lock(run_mutex);
+
+  run_done = true;
+  run_cond.notify_one();
+}
+
+static void wait_finish() {
+  std::unique_lock<std::mutex> lock(run_mutex);
+
+  while (!run_done)
+    run_cond.wait(lock);
+
+  run_done = false;
+}
+
+static double score(size_t i) {
+  double x = (double)(i % 1000) / 1000;
+  int j;
+
+  for (j = 0; j < 64; j++)
+    x = sin(x) * 0.5 + cos(x * 1.5) * 0.5;
+
+  return x;
+}
+
+static double run(int mode, size_t items, int threads,
+                  std::vector<double> &scores) {
+  Clock::time_point start = Clock::now();
+
+  if (mode == 0) {
+    WFTaskFactory::create_parallel_for_task(
+        "bench", 0, items, [&scores](size_t i) { scores[i] = score(i); },
+        [](WFParallelForTask *) { finish(); })->start();
+  } else if (mode == 1) {
+    WFMapReduceTaskFactory<double>::create_map_reduce_task(
+        "bench", 0, items, 0.0,
+        [](size_t i, double *partial) { *partial += score(i); },
+        [](double *result, double *partial) { *result += *partial; },
+        [&scores](WFMapReduceTask<double> *task) {
+          scores[0] = *task->get_result();
+          finish();
+        })->start();
+  } else {
+    std::vector<SeriesWork *> all(threads);
+    size_t slice = (items + threads - 1) / threads;
+
+    for (int t = 0; t < threads; t++) {
+      size_t first = std::min(items, t * slice);
+      size_t last = std::min(items, first + slice);
+      WFGoTask *task = WFTaskFactory::create_go_task(
+          "bench", [&scores, first, last]() {
+            for (size_t i = first; i < last; i++)
+              scores[i] = score(i);
+          });
+
+      all[t] = Workflow::create_series_work(task, nullptr);
+    }
+
+    Workflow::start_parallel_work(all.data(), threads,
+                                  [](const ParallelWork *) { finish(); });
+  }
+
+  wait_finish();
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+static void child(size_t items, int threads, int fd) {
+  struct WFGlobalSettings settings = GLOBAL_SETTINGS_DEFAULT;
+  std::vector<double> scores(items);
+  double best[3];
+
+  settings.compute_threads = threads;
+  WORKFLOW_library_init(&settings);
+  for (int mode = 0; mode < 3; mode++) {
+    best[mode] = 1e30;
+    for (int round = 0; round < 5; round++)
+      best[mode] = std::min(best[mode], run(mode, items, threads, scores));
+  }
+
+  if (write(fd, best, sizeof best) != sizeof best)
+    exit(1);
+
+  exit(0);
+}
+
+int main(int argc, char *argv[]) {
+  size_t items = argc > 1 ? atol(argv[1]) : 100000;
+  int max = argc > 2 ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+  double base[3];
+  double best[3];
+  int fds[2];
+
+  printf("%8s %22s %22s %22s\n", "threads", "parallel-for ms", "map-reduce ms",
+         "series ms");
+  for (int threads = 1; threads <= max; threads++) {
+    if (pipe(fds) < 0)
+      return 1;
+
+    fflush(stdout);
+    if (fork() == 0)
+      child(items, threads, fds[1]);
+
+    if (read(fds[0], best, sizeof best) != sizeof best)
+      return 1;
+
+    wait(NULL);
+    close(fds[0]);
+    close(fds[1]);
+    if (threads == 1)
+      std::copy(best, best + 3, base);
+
+    printf("%8d", threads);
+    for (int mode = 0; mode < 3; mode++)
+      printf(" %12.2f (%5.2fx)", best[mode], base[mode] / best[mode]);
+
+    printf("\n");
+  }
+
+  return 0;
+}
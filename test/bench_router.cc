@@ -0,0 +1,129 @@
+/*
+  Benchmark for WFHttpRouter.
+
+  Registers thousands of static, :param and *wildcard routes and matches
+  request URIs against them. For comparison, also times the routing that
+  user code used to do by hand: URIParser::split_path() plus a std::map
+  lookup of the joined path (static routes only).
+
+  USAGE: bench_router [resources] [requests]
+*/
+
+#include "../src/server/WFHttpRouter.h"
+#include "../src/util/URIParser.h"
+#include <assert.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static const char *verbs[] = {"list", "create", "stats", "export"};
+
+int main(int argc, char *argv[]) {
+  size_t resources = argc > 1 ? atol(argv[1]) : 1000;
+  size_t requests = argc > 2 ? atol(argv[2]) : 1000000;
+  std::map<std::string, int> table;
+  std::vector<std::string> uris;
+  std::mt19937 rng(1);
+  WFHttpRouter router;
+  WFHttpRouteParams params;
+  size_t routes = 0;
+  size_t hits = 0;
+  char buf[256];
+  size_t i;
+  int j;
+
+  auto handler = [](WFHttpTask *, const WFHttpRouteParams *) {};
+
+  for (i = 0; i < resources; i++) {
+    for (j = 0; j < 4; j++) {
+      snprintf(buf, sizeof buf, "/api/v%zu/res%zu/%s", i % 3, i, verbs[j]);
+      router.add("GET", buf, handler);
+      table[buf] = j;
+      routes++;
+    }
+
+    snprintf(buf, sizeof buf, "/api/v%zu/res%zu/:id", i % 3, i);
+    router.add("GET", buf, handler);
+    snprintf(buf, sizeof buf, "/api/v%zu/res%zu/:id/items/:item", i % 3, i);
+    router.add("GET", buf, handler);
+    routes += 2;
+  }
+
+  router.add("GET", "/static/*path", handler);
+  routes++;
+
+  assert(router.match("GET", "/api/v0/res0/list", &params) &&
+         params.count == 0);
+  assert(router.match("GET", "/api/v0/res0/listx?a=1", &params) &&
+         params.get("id") == "listx");
+  assert(router.match("GET", "/api/v1/res1/42/items/7", &params) &&
+         params.get("id") == "42" && params.get("item") == "7");
+  assert(router.match("GET", "/static/css/a.css", &params) &&
+         params.get("path") == "css/a.css");
+  assert(!router.match("GET", "/api/v0/res0", &params));
+  assert(!router.match("POST", "/api/v0/res0/list", &params));
+
+  for (i = 0; i < 4096; i++) {
+    size_t r = rng() % resources;
+
+    switch (rng() % 4) {
+    case 0:
+    case 1:
+      snprintf(buf, sizeof buf, "/api/v%zu/res%zu/%s?x=1", r % 3, r,
+               verbs[rng() % 4]);
+      break;
+    case 2:
+      snprintf(buf, sizeof buf, "/api/v%zu/res%zu/%u/items/%u", r % 3, r,
+               (unsigned)rng() % 100000, (unsigned)rng() % 100);
+      break;
+    default:
+      snprintf(buf, sizeof buf, "/static/img/%u.png", (unsigned)rng() % 1000);
+      break;
+    }
+
+    uris.push_back(buf);
+  }
+
+  printf("%zu routes, %zu requests\n", routes, requests);
+
+  auto start = std::chrono::steady_clock::now();
+  for (i = 0; i < requests; i++) {
+    const std::string &uri = uris[i & 4095];
+
+    if (router.match("GET", uri.c_str(), uri.size(), &params))
+      hits++;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double secs = std::chrono::duration<double>(end - start).count();
+
+  printf("  %-24s %8.2f Mops/s  (%zu matched)\n", "WFHttpRouter::match",
+         requests / secs / 1e6, hits);
+
+  hits = 0;
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < requests; i++) {
+    const std::string &uri = uris[i & 4095];
+    std::string path = uri.substr(0, uri.find('?'));
+    std::vector<std::string> segs = URIParser::split_path(path);
+    std::string key;
+
+    for (const std::string &seg : segs) {
+      key += '/';
+      key += seg;
+    }
+
+    if (table.find(key) != table.end())
+      hits++;
+  }
+
+  end = std::chrono::steady_clock::now();
+  secs = std::chrono::duration<double>(end - start).count();
+  printf("  %-24s %8.2f Mops/s  (%zu matched, static only)\n",
+         "split_path + std::map", requests / secs / 1e6, hits);
+  return 0;
+}
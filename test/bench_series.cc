@@ -0,0 +1,118 @@
+/*
+  Benchmark for the SeriesWork task queue.
+
+  Runs empty tasks that finish at once, so what is left is the cost of the
+  series: push_back(), pop() and the task objects. A trampoline in main()
+  dispatches the next task instead of the finishing one, to keep the stack
+  flat. Two ways:
+    pipeline  one series of many tasks, every task appends the next one
+              from its done() while it is the running task;
+    prebuilt  many series of 16 tasks, all appended before start().
+  Reports the time per task and the heap allocations per series besides
+  the series and its tasks, counted by a replaced operator new.
+
+  USAGE: bench_series [tasks]
+*/
+
+#include "../src/factory/Workflow.h"
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static long allocations;
+
+void *operator new(size_t size) {
+  void *ptr = malloc(size);
+
+  if (!ptr)
+    throw std::bad_alloc();
+
+  allocations++;
+  return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+class EmptyTask;
+
+static EmptyTask *ready;
+static long remaining;
+
+class EmptyTask : public SubTask {
+public:
+  EmptyTask(bool append) : append(append) {}
+
+  virtual void dispatch() { ready = this; }
+
+  void finish() { this->subtask_done(); }
+
+private:
+  virtual SubTask *done() {
+    SeriesWork *series = series_of(this);
+
+    if (this->append && --remaining > 0)
+      series->push_back(new EmptyTask(true));
+
+    delete this;
+    return series->pop();
+  }
+
+  bool append;
+};
+
+static void run_ready() {
+  EmptyTask *task;
+
+  while (ready) {
+    task = ready;
+    ready = NULL;
+    task->finish();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  long tasks = argc > 1 ? atol(argv[1]) : 1000000;
+  long before;
+  long series;
+  long i;
+  int j;
+
+  for (int mode = 0; mode < 2; mode++) {
+    auto start = std::chrono::steady_clock::now();
+
+    before = allocations;
+    if (mode == 0) {
+      series = 1;
+      remaining = tasks;
+      Workflow::start_series_work(new EmptyTask(true), nullptr);
+      run_ready();
+    } else {
+      series = tasks / 16;
+      for (i = 0; i < series; i++) {
+        SeriesWork *s = Workflow::create_series_work(new EmptyTask(false),
+                                                     nullptr);
+
+        for (j = 1; j < 16; j++)
+          *s << new EmptyTask(false);
+
+        s->start();
+        run_ready();
+      }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    long extra = allocations - before - series - (mode == 0 ? tasks : series * 16);
+
+    printf("%-9s %8.1f ns/task %10.2f extra allocations/series\n",
+           mode == 0 ? "pipeline" : "prebuilt",
+           ns / (mode == 0 ? tasks : series * 16), (double)extra / series);
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+/*
+  Benchmark for coalesced timers.
+
+  Starts 100k timer tasks due evenly over one second, with a timer slack of
+  0 (exact), 50us (the default) and 1ms. Every slack runs in a child
+  process, because the slack is fixed when the library starts. Reports the
+  voluntary context switches of the process while the timers run, which
+  are the poller and handler thread wakeups, and how late the callbacks
+  were: p50, p99 and max. No timer may fire early.
+
+  USAGE: bench_timer [timers] [span ms]
+*/
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/factory/Workflow.h"
+#include "../src/manager/WFGlobal.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static std::mutex mtx;
+static std::condition_variable cond;
+static std::atomic<long> remaining;
+
+static long long now_nsec() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void child(long timers, long span, unsigned int slack, int fd) {
+  struct WFGlobalSettings settings = GLOBAL_SETTINGS_DEFAULT;
+  std::vector<long long> due(timers);
+  std::vector<long long> late(timers);
+  struct rusage before, after;
+  double result[5];
+  long i;
+
+  settings.timer_slack = slack;
+  WORKFLOW_library_init(&settings);
+  remaining = timers;
+  getrusage(RUSAGE_SELF, &before);
+  for (i = 0; i < timers; i++) {
+    long long delay = span * 1000000LL * (i + 1) / timers;
+    WFTimerTask *task;
+
+    task = WFTaskFactory::create_timer_task(
+        delay / 1000000000, delay % 1000000000, [&late, &due](WFTimerTask *t) {
+          long i = (long)t->user_data;
+
+          late[i] = now_nsec() - due[i];
+          if (--remaining == 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cond.notify_one();
+          }
+        });
+    task->user_data = (void *)i;
+    due[i] = now_nsec() + delay;
+    task->start();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [] { return remaining == 0; });
+  }
+
+  getrusage(RUSAGE_SELF, &after);
+  std::sort(late.begin(), late.end());
+  result[0] = after.ru_nvcsw - before.ru_nvcsw;
+  result[1] = late[timers / 2] / 1000.0;
+  result[2] = late[timers * 99 / 100] / 1000.0;
+  result[3] = late[timers - 1] / 1000.0;
+  result[4] = late[0] / 1000.0;
+  if (write(fd, result, sizeof result) != sizeof result)
+    exit(1);
+
+  exit(0);
+}
+
+int main(int argc, char *argv[]) {
+  long timers = argc > 1 ? atol(argv[1]) : 100000;
+  long span = argc > 2 ? atol(argv[2]) : 1000;
+  static const unsigned int slacks[] = {0, 50, 1000};
+  double result[5];
+  int fds[2];
+
+  printf("%9s %12s %12s %12s %12s\n", "slack us", "wakeups", "p50 late us",
+         "p99 late us", "max late us");
+  for (unsigned int slack : slacks) {
+    if (pipe(fds) < 0)
+      return 1;
+
+    fflush(stdout);
+    if (fork() == 0)
+      child(timers, span, slack, fds[1]);
+
+    if (read(fds[0], result, sizeof result) != sizeof result)
+      return 1;
+
+    wait(NULL);
+    close(fds[0]);
+    close(fds[1]);
+    printf("%9u %12.0f %12.1f %12.1f %12.1f%s\n", slack, result[0], result[1],
+           result[2], result[3], result[4] < 0 ? "  (fired early!)" : "");
+  }
+
+  return 0;
+}
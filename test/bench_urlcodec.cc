@@ -0,0 +1,154 @@
+/*
+  Benchmark for StringUtil URL encode/decode.
+
+  Compares the SIMD span based codec with the previous byte-at-a-time
+  implementation (kept here as the reference) on inputs with different
+  densities of escaped characters, and checks both give the same output.
+
+  USAGE: bench_urlcodec [bytes] [rounds]
+*/
+
+#include "../src/util/StringUtil.h"
+#include <assert.h>
+#include <chrono>
+#include <ctype.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static int legacy_htoi(unsigned char *s) {
+  int value;
+  int c;
+
+  c = tolower(s[0]);
+  value = (c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10) * 16;
+  c = tolower(s[1]);
+  value += (c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10);
+  return value;
+}
+
+static inline char legacy_itoh(int n) { return n > 9 ? n - 10 + 'A' : n + '0'; }
+
+static void legacy_url_decode(std::string &str) {
+  char *dest = &str[0];
+  char *data = &str[0];
+
+  while (*data) {
+    if (*data == '%' && isxdigit(data[1]) && isxdigit(data[2])) {
+      *dest = legacy_htoi((unsigned char *)data + 1);
+      data += 2;
+    } else if (*data == '+')
+      *dest = ' ';
+    else
+      *dest = *data;
+
+    data++;
+    dest++;
+  }
+
+  str.resize(dest - &str[0]);
+}
+
+static std::string legacy_url_encode_component(const std::string &str) {
+  const char *cur = str.c_str();
+  const char *ed = cur + str.size();
+  std::string res;
+
+  while (cur < ed) {
+    if (*cur == ' ')
+      res += '+';
+    else if (isalnum(*cur) || *cur == '-' || *cur == '_' || *cur == '.' ||
+             *cur == '!' || *cur == '~' || *cur == '*' || *cur == '\'' ||
+             *cur == '(' || *cur == ')')
+      res += *cur;
+    else {
+      res += '%';
+      res += legacy_itoh(((const unsigned char)(*cur)) >> 4);
+      res += legacy_itoh(((const unsigned char)(*cur)) % 16);
+    }
+
+    cur++;
+  }
+
+  return res;
+}
+
+/* 'escape_ratio' of the bytes need escaping. */
+static std::string make_input(size_t len, double escape_ratio,
+                              unsigned int seed) {
+  static const char plain[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~";
+  static const char special[] = " &=/?#%+\xe4\xb8\xad";
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::string s;
+
+  s.reserve(len);
+  while (s.size() < len) {
+    if (dist(rng) < escape_ratio)
+      s += special[rng() % (sizeof special - 1)];
+    else
+      s += plain[rng() % (sizeof plain - 1)];
+  }
+
+  return s;
+}
+
+template <class FUNC>
+static double mbps(size_t bytes, int rounds, FUNC func) {
+  auto start = std::chrono::steady_clock::now();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    func();
+
+  auto end = std::chrono::steady_clock::now();
+  return bytes * rounds / std::chrono::duration<double>(end - start).count() /
+         1e6;
+}
+
+int main(int argc, char *argv[]) {
+  size_t bytes = argc > 1 ? atol(argv[1]) : 4096;
+  int rounds = argc > 2 ? atoi(argv[2]) : 2000;
+  const double ratios[] = {0.0, 0.02, 0.2, 1.0};
+  std::vector<char> buf(3 * bytes);
+
+  printf("%zu bytes x %d rounds, MB/s of input\n", bytes, rounds);
+  printf("  %-8s %12s %12s %12s %12s %12s\n", "escaped", "enc legacy",
+         "enc string", "enc buffer", "dec legacy", "dec inplace");
+
+  for (double ratio : ratios) {
+    std::string input = make_input(bytes, ratio, 1);
+    std::string encoded = legacy_url_encode_component(input);
+    std::string tmp;
+
+    assert(StringUtil::url_encode_component(input) == encoded);
+    tmp = encoded;
+    StringUtil::url_decode(tmp);
+    assert(tmp == input);
+
+    double e0 = mbps(bytes, rounds, [&] {
+      std::string r = legacy_url_encode_component(input);
+    });
+    double e1 = mbps(bytes, rounds, [&] {
+      std::string r = StringUtil::url_encode_component(input);
+    });
+    double e2 = mbps(bytes, rounds, [&] {
+      StringUtil::url_encode_component(input.c_str(), input.size(), &buf[0]);
+    });
+    double d0 = mbps(encoded.size(), rounds, [&] {
+      tmp = encoded;
+      legacy_url_decode(tmp);
+    });
+    double d1 = mbps(encoded.size(), rounds, [&] {
+      tmp = encoded;
+      StringUtil::url_decode(&tmp[0], tmp.size());
+    });
+
+    printf("  %-7.0f%% %12.1f %12.1f %12.1f %12.1f %12.1f\n", ratio * 100, e0,
+           e1, e2, d0, d1);
+  }
+
+  return 0;
+}
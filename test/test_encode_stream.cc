@@ -0,0 +1,68 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_encode_stream.cc
+ * @Description  : 线程的缓冲池销毁之后再销毁的EncodeStream
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/util/EncodeStream.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+#define VECTORS 64
+
+static void fill(EncodeStream *stream) {
+  std::string data(300, 'x');
+  int i;
+
+  for (i = 0; i < 40; i++)
+    stream->append_copy(data);
+
+  assert(stream->bytes() == 40 * data.size());
+}
+
+//*pool之后析构的thread_local,析构时把缓冲还回去
+struct LateStream {
+  struct iovec vectors[VECTORS];
+  EncodeStream stream;
+
+  LateStream() : stream(vectors, VECTORS) {}
+};
+
+static struct iovec static_vectors[VECTORS];
+static EncodeStream static_stream(static_vectors, VECTORS);
+
+int main() {
+  //*先让pool有缓冲,析构顺序与构造相反
+  {
+    struct iovec vectors[VECTORS];
+    EncodeStream stream(vectors, VECTORS);
+
+    fill(&stream);
+  }
+
+  fill(&static_stream);
+  std::thread([] {
+    static thread_local LateStream late;
+
+    {
+      struct iovec vectors[VECTORS];
+      EncodeStream stream(vectors, VECTORS);
+
+      fill(&stream);
+    }
+
+    fill(&late.stream);
+  }).join();
+
+  //*reset()之后再用,pool已销毁时也一样
+  static_stream.reset(static_vectors, VECTORS);
+  fill(&static_stream);
+  printf("encode stream ok\n");
+  return 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_http_cache.cc
+ * @Description  : WFHttpCache的命中重放,并发未命中合并与Cache-Control处理
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/server/WFHttpCache.h"
+#include "../src/server/WFHttpServer.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <strings.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace protocol;
+
+#define CONCURRENT 4
+
+static std::mutex calls_mutex;
+static std::map<std::string, int> calls;
+static unsigned short port;
+
+static int get_calls(const std::string &uri) {
+  std::lock_guard<std::mutex> lock(calls_mutex);
+  return calls[uri];
+}
+
+//*每个URI的响应体为"<uri> #<第几次调用>",Cache-Control由URI决定
+static void process(WFHttpTask *task) {
+  HttpResponse *resp = task->get_resp();
+  std::string uri = task->get_req()->get_request_uri();
+  int n;
+
+  calls_mutex.lock();
+  n = ++calls[uri];
+  calls_mutex.unlock();
+
+  resp->set_status_code("200");
+  resp->add_header_pair("Keep-Alive", "timeout=60");
+  resp->add_header_pair("X-Test", "1");
+  if (uri == "/no-store")
+    resp->add_header_pair("Cache-Control", "no-store");
+  else if (uri == "/private")
+    resp->add_header_pair("Cache-Control", "public, private");
+  else if (uri == "/max-age")
+    resp->add_header_pair("Cache-Control", "max-age=1");
+  else if (uri == "/max-age-0")
+    resp->add_header_pair("Cache-Control", "max-age=0");
+
+  resp->append_output_body(uri + " #" + std::to_string(n));
+
+  //*回复前等一会,让同一key的其他请求都到达并等待
+  if (uri == "/collapse")
+    series_of(task)->push_back(
+        WFTaskFactory::create_timer_task(0, 200 * 1000 * 1000, nullptr));
+}
+
+struct Response {
+  std::string head;
+  std::string body;
+
+  //*返回名为name的响应头的个数,value为最后一个的值
+  int header(const char *name, std::string *value = NULL) const {
+    size_t len = strlen(name);
+    size_t pos = head.find("\r\n");
+    int n = 0;
+
+    while (pos + 2 < head.size()) {
+      size_t end = head.find("\r\n", pos + 2);
+      std::string line = head.substr(pos + 2, end - pos - 2);
+
+      if (line.size() > len && line[len] == ':' &&
+          strncasecmp(line.c_str(), name, len) == 0) {
+        if (value)
+          *value = line.substr(len + 2);
+        n++;
+      }
+
+      pos = end;
+    }
+
+    return n;
+  }
+};
+
+//*每个请求一个新连接
+static Response request(const char *method, const std::string &uri,
+                        bool close_conn) {
+  struct sockaddr_in addr = {};
+  std::string text = std::string(method) + " " + uri + " HTTP/1.1\r\n" +
+                     "Host: localhost\r\nContent-Length: 0\r\n";
+  std::string data;
+  Response resp;
+  char buf[4096];
+  size_t head_end;
+  std::string len;
+  ssize_t n;
+  int fd;
+
+  if (close_conn)
+    text += "Connection: close\r\n";
+
+  text += "\r\n";
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  assert(fd >= 0);
+  assert(connect(fd, (struct sockaddr *)&addr, sizeof addr) == 0);
+  assert(write(fd, text.data(), text.size()) == (ssize_t)text.size());
+
+  while ((head_end = data.find("\r\n\r\n")) == std::string::npos ||
+         data.size() < head_end + 4 + resp.body.size()) {
+    n = read(fd, buf, sizeof buf);
+    assert(n > 0);
+    data.append(buf, n);
+    if (head_end == std::string::npos &&
+        (head_end = data.find("\r\n\r\n")) != std::string::npos) {
+      resp.head = data.substr(0, head_end + 2);
+      assert(resp.header("Content-Length", &len) == 1);
+      resp.body.resize(atoi(len.c_str()));
+    }
+  }
+
+  close(fd);
+  resp.body = data.substr(head_end + 4);
+  return resp;
+}
+
+//*命中时不调用process,重放的响应头与首次一致,只有Connection按请求生成,
+//*Keep-Alive不会被重放
+static void test_hit() {
+  Response first = request("GET", "/hit", false);
+  std::string value;
+
+  assert(first.body == "/hit #1");
+  for (bool close_conn : {false, true, false}) {
+    Response resp = request("GET", "/hit", close_conn);
+
+    assert(resp.body == "/hit #1");
+    assert(resp.head.compare(0, 17, "HTTP/1.1 200 OK\r\n") == 0);
+    assert(resp.header("X-Test") == 1);
+    assert(resp.header("Keep-Alive") == 0);
+    assert(resp.header("Connection", &value) == 1);
+    assert(strcasecmp(value.c_str(), close_conn ? "close" : "Keep-Alive") == 0);
+  }
+
+  assert(get_calls("/hit") == 1);
+
+  //*只缓存GET
+  assert(request("POST", "/post", false).body == "/post #1");
+  assert(request("POST", "/post", false).body == "/post #2");
+  printf("hit ok\n");
+}
+
+//*同一key并发未命中只调用一次process,其余请求重放它的响应,
+//*只有process发出的那一个响应带着它自己的Keep-Alive
+static void test_collapse() {
+  std::vector<std::thread> threads;
+  std::atomic<int> replayed(0);
+  int i;
+
+  for (i = 0; i < CONCURRENT; i++) {
+    threads.emplace_back([&replayed] {
+      Response resp = request("GET", "/collapse", false);
+
+      assert(resp.body == "/collapse #1");
+      if (resp.header("Keep-Alive") == 0)
+        replayed++;
+    });
+  }
+
+  for (auto &t : threads)
+    t.join();
+
+  assert(replayed == CONCURRENT - 1);
+  assert(get_calls("/collapse") == 1);
+  printf("collapse ok\n");
+}
+
+static void test_cache_control() {
+  //*no-store/private/max-age=0不缓存
+  for (const char *uri : {"/no-store", "/private", "/max-age-0"}) {
+    assert(request("GET", uri, false).body == uri + std::string(" #1"));
+    assert(request("GET", uri, false).body == uri + std::string(" #2"));
+  }
+
+  //*max-age覆盖默认的ttl
+  assert(request("GET", "/max-age", false).body == "/max-age #1");
+  assert(request("GET", "/max-age", false).body == "/max-age #1");
+  usleep(1100 * 1000);
+  assert(request("GET", "/max-age", false).body == "/max-age #2");
+  printf("cache control ok\n");
+}
+
+int main() {
+  struct WFHttpCacheParams params = HTTP_CACHE_PARAMS_DEFAULT;
+  struct sockaddr_in addr;
+  socklen_t len = sizeof addr;
+
+  params.ttl = 60 * 1000;
+  WFHttpCache cache(&params, process);
+  WFHttpServer server(cache.get_process());
+
+  assert(server.start(AF_INET, "127.0.0.1", 0) == 0);
+  assert(server.get_listen_addr((struct sockaddr *)&addr, &len) == 0);
+  port = ntohs(addr.sin_port);
+
+  test_hit();
+  test_collapse();
+  test_cache_control();
+  server.stop();
+  return 0;
+}
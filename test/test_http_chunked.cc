@@ -0,0 +1,106 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_http_chunked.cc
+ * @Description  : chunked body解码后的body与header状态
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+#include "../src/protocol/http_parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static std::string find_header(const char *name, http_parser_t *parser) {
+  http_header_cursor_t cursor;
+  const void *value;
+  size_t value_len;
+  std::string ret = "<none>";
+
+  http_header_cursor_init(&cursor, parser);
+  if (http_header_cursor_find(name, strlen(name), &value, &value_len,
+                              &cursor) == 0)
+    ret.assign((const char *)value, value_len);
+
+  http_header_cursor_deinit(&cursor);
+  return ret;
+}
+
+//*step为每次append的字节数,0表示一次全部
+static void parse(const char *msg, size_t step, http_parser_t *parser) {
+  size_t len = strlen(msg);
+  size_t off = 0;
+  size_t n;
+  int ret = 0;
+
+  http_parser_init(1, parser);
+  while (off < len) {
+    n = step && step < len - off ? step : len - off;
+    ret = http_parser_append_message(msg + off, &n, parser);
+    assert(ret >= 0);
+    off += n;
+    if (ret > 0)
+      break;
+  }
+
+  assert(ret == 1);
+}
+
+static void check(const char *msg, const char *body, const char *encoding) {
+  static const size_t steps[] = {0, 1, 7};
+  http_parser_t parser;
+  const void *parsed;
+  size_t size;
+
+  for (size_t step : steps) {
+    parse(msg, step, &parser);
+    assert(http_parser_get_body(&parsed, &size, &parser) == 0);
+    assert(size == strlen(body));
+    assert(memcmp(parsed, body, size) == 0);
+    assert(!http_parser_chunked(&parser));
+    assert(http_parser_has_content_length(&parser));
+    assert(find_header("Content-Length", &parser) ==
+           std::to_string(strlen(body)));
+    assert(find_header("Transfer-Encoding", &parser) == encoding);
+    assert(find_header("Server", &parser) == "test");
+    http_parser_deinit(&parser);
+  }
+}
+
+int main() {
+  check("HTTP/1.1 200 OK\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Server: test\r\n"
+        "\r\n"
+        "5\r\nhello\r\n"
+        "7;ext=1\r\n, world\r\n"
+        "0\r\n"
+        "X-Trailer: 1\r\n"
+        "\r\n",
+        "hello, world", "<none>");
+  check("HTTP/1.1 200 OK\r\n"
+        "Server: test\r\n"
+        "Transfer-Encoding: gzip, chunked\r\n"
+        "\r\n"
+        "3\r\nabc\r\n"
+        "0\r\n\r\n",
+        "abc", "gzip");
+  check("HTTP/1.1 200 OK\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Server: test\r\n"
+        "\r\n"
+        "0\r\n\r\n",
+        "", "<none>");
+
+  //*没有chunked的消息不受影响
+  http_parser_t parser;
+  parse("HTTP/1.1 200 OK\r\nServer: test\r\nContent-Length: 2\r\n\r\nok",
+        0, &parser);
+  assert(find_header("Content-Length", &parser) == "2");
+  assert(find_header("Transfer-Encoding", &parser) == "<none>");
+  http_parser_deinit(&parser);
+  printf("chunked ok\n");
+  return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_http_output_body.cc
+ * @Description  : 线程的output slab销毁之后再填充或销毁的HttpMessage
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/protocol/HttpMessage.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+using namespace protocol;
+
+//*小块拷贝打包进16KB的chunk,释放时回到slab
+static void fill(HttpResponse *resp) {
+  std::string data(300, 'x');
+  int i;
+
+  resp->clear_output_body();
+  for (i = 0; i < 200; i++)
+    assert(resp->append_output_body(data));
+
+  assert(resp->get_output_body_size() == 200 * data.size());
+}
+
+static HttpResponse static_resp;
+
+int main() {
+  //*先让slab有chunk,析构顺序与构造相反
+  {
+    HttpResponse resp;
+
+    fill(&resp);
+  }
+
+  fill(&static_resp);
+  std::thread([] {
+    static thread_local HttpResponse late;
+
+    {
+      HttpResponse resp;
+
+      fill(&resp);
+    }
+
+    fill(&late);
+  }).join();
+
+  printf("output body ok\n");
+  return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_ioservice.cc
+ * @Description  : IOService在io_uring和native aio两个后端上的测试
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/kernel/CommScheduler.h"
+#include "../src/manager/WFGlobal.h"
+#include <assert.h>
+#include <condition_variable>
+#include <errno.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <mutex>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define FILE_SIZE 8192
+
+static std::mutex done_mutex;
+static std::condition_variable done_cond;
+static int handled;
+
+class TestService : public IOService {
+public:
+  int bind() {
+    this->unbound = false;
+    return WFGlobal::get_scheduler()->io_bind(this);
+  }
+
+  void unbind() { WFGlobal::get_scheduler()->io_unbind(this); }
+
+  //*返回handle_unbound()时已经回调的session数
+  int wait_unbound() {
+    std::unique_lock<std::mutex> lock(done_mutex);
+
+    done_cond.wait(lock, [this] { return this->unbound; });
+    return this->handled_at_unbound;
+  }
+
+private:
+  virtual void handle_unbound() {
+    std::lock_guard<std::mutex> lock(done_mutex);
+
+    this->handled_at_unbound = handled;
+    this->unbound = true;
+    done_cond.notify_all();
+  }
+
+  virtual void handle_stop(int error) { this->unbind(); }
+
+  bool unbound;
+  int handled_at_unbound;
+};
+
+enum { OP_PREAD, OP_PWRITE, OP_PREADV, OP_PWRITEV, OP_FSYNC, OP_FDSYNC };
+
+class TestSession : public IOSession {
+public:
+  TestSession(int op, int fd, void *buf, size_t count, long long offset)
+      : op(op), fd(fd), buf(buf), count(count), offset(offset) {
+    this->state = -1;
+  }
+
+  int state;
+  int error;
+  long res;
+  IOService *nested = NULL; //*在回调里同步发起并等待的第二个请求
+
+private:
+  virtual int prepare() {
+    switch (this->op) {
+    case OP_PREAD:
+      this->prep_pread(this->fd, this->buf, this->count, this->offset);
+      break;
+    case OP_PWRITE:
+      this->prep_pwrite(this->fd, this->buf, this->count, this->offset);
+      break;
+    case OP_PREADV:
+      this->prep_preadv(this->fd, (struct iovec *)this->buf, this->count,
+                        this->offset);
+      break;
+    case OP_PWRITEV:
+      this->prep_pwritev(this->fd, (struct iovec *)this->buf, this->count,
+                         this->offset);
+      break;
+    case OP_FSYNC:
+      this->prep_fsync(this->fd);
+      break;
+    case OP_FDSYNC:
+      this->prep_fdsync(this->fd);
+      break;
+    }
+
+    return 0;
+  }
+
+  virtual void handle(int state, int error) {
+    if (this->nested) {
+      char c;
+      TestSession session(OP_PREAD, this->fd, &c, 1, 0);
+      int cookie = WFGlobal::sync_operation_begin();
+
+      assert(this->nested->request(&session) == 0);
+      IOService::flush_deferred();
+      {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cond.wait(lock, [&session] { return session.state >= 0; });
+      }
+
+      WFGlobal::sync_operation_end(cookie);
+      assert(session.state == IOS_STATE_SUCCESS);
+    }
+
+    std::lock_guard<std::mutex> lock(done_mutex);
+    this->res = this->get_res();
+    this->error = error;
+    this->state = state;
+    handled++;
+    done_cond.notify_all();
+  }
+
+  int op;
+  int fd;
+  void *buf;
+  size_t count;
+  long long offset;
+};
+
+static void wait_handled(int n) {
+  std::unique_lock<std::mutex> lock(done_mutex);
+
+  done_cond.wait(lock, [n] { return handled >= n; });
+}
+
+static TestSession *run(IOService *service, TestSession *session) {
+  assert(service->request(session) == 0);
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done_cond.wait(lock, [session] { return session->state >= 0; });
+  return session;
+}
+
+static void check_success(TestSession *session, long res) {
+  assert(session->state == IOS_STATE_SUCCESS);
+  assert(session->res == res);
+}
+
+static void check_error(TestSession *session, int error) {
+  assert(session->state == IOS_STATE_ERROR);
+  assert(session->error == error);
+}
+
+//*只拦截一个系统调用,返回指定的errno
+static void block_syscall(int nr, int error) {
+  struct sock_filter filter[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (unsigned int)nr, 0, 1),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | (error & SECCOMP_RET_DATA)),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+  };
+  struct sock_fprog prog = {sizeof filter / sizeof filter[0], filter};
+
+  assert(prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0);
+  assert(prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0);
+}
+
+static int open_file() {
+  char path[] = "/tmp/test_ioservice.XXXXXX";
+  int fd = mkstemp(path);
+
+  assert(fd >= 0);
+  unlink(path);
+  return fd;
+}
+
+static void test_rw(TestService *service) {
+  std::vector<char> data(FILE_SIZE);
+  std::vector<char> buf(FILE_SIZE);
+  struct iovec iov[2];
+  int fd = open_file();
+  int i;
+
+  for (i = 0; i < FILE_SIZE; i++)
+    data[i] = (char)(i * 7 + 1);
+
+  TestSession write(OP_PWRITE, fd, data.data(), FILE_SIZE / 2, 0);
+  check_success(run(service, &write), FILE_SIZE / 2);
+
+  iov[0] = {data.data() + FILE_SIZE / 2, FILE_SIZE / 4};
+  iov[1] = {data.data() + FILE_SIZE * 3 / 4, FILE_SIZE / 4};
+  TestSession writev(OP_PWRITEV, fd, iov, 2, FILE_SIZE / 2);
+  check_success(run(service, &writev), FILE_SIZE / 2);
+
+  TestSession fsync(OP_FSYNC, fd, NULL, 0, 0);
+  check_success(run(service, &fsync), 0);
+  TestSession fdsync(OP_FDSYNC, fd, NULL, 0, 0);
+  check_success(run(service, &fdsync), 0);
+
+  TestSession read(OP_PREAD, fd, buf.data(), FILE_SIZE, 0);
+  check_success(run(service, &read), FILE_SIZE);
+  assert(memcmp(buf.data(), data.data(), FILE_SIZE) == 0);
+
+  memset(buf.data(), 0, FILE_SIZE);
+  iov[0] = {buf.data(), 100};
+  iov[1] = {buf.data() + 100, FILE_SIZE};
+  TestSession readv(OP_PREADV, fd, iov, 2, 0);
+  check_success(run(service, &readv), FILE_SIZE);
+  assert(memcmp(buf.data(), data.data(), FILE_SIZE) == 0);
+
+  //*超过一次读写上限的count被截断,而不是在sqe的32位len里回绕
+  TestSession huge(OP_PREAD, fd, buf.data(), (size_t)1 << 33, 0);
+  check_success(run(service, &huge), FILE_SIZE);
+
+  //*io_uring在CQE里返回错误,native aio由io_submit()失败走fail()
+  TestSession badfd(OP_PREAD, 1000, buf.data(), 1, 0);
+  check_error(run(service, &badfd), EBADF);
+
+  //*回调里同步等自己发起的io:先flush_deferred(),等待期间加一个handler线程
+  TestSession nested(OP_PREAD, fd, buf.data(), 1, 0);
+  nested.nested = service;
+  check_success(run(service, &nested), 1);
+  close(fd);
+}
+
+//*还有请求在途时解绑:每个session都在handle_unbound()之前回调
+static void test_unbind(TestService *service) {
+  std::vector<TestSession *> sessions;
+  char buf[64][512];
+  int fd = open_file();
+  int n;
+  int i;
+
+  assert(ftruncate(fd, FILE_SIZE) == 0);
+  done_mutex.lock();
+  n = handled;
+  done_mutex.unlock();
+  for (i = 0; i < 64; i++) {
+    sessions.push_back(new TestSession(OP_PREAD, fd, buf[i], 512, i * 64));
+    assert(service->request(sessions.back()) == 0);
+  }
+
+  service->unbind();
+  assert(service->wait_unbound() == n + 64);
+  for (TestSession *session : sessions) {
+    check_success(session, 512);
+    delete session;
+  }
+
+  TestSession late(OP_PREAD, fd, buf[0], 1, 0);
+  assert(service->request(&late) < 0 && errno == ENOENT);
+  close(fd);
+}
+
+//*提交的系统调用失败时,请求以这个错误结束
+static void test_fail(TestService *service, int submit_nr) {
+  char buf[16];
+  int fd = open_file();
+  int n;
+  int i;
+
+  done_mutex.lock();
+  n = handled;
+  done_mutex.unlock();
+  block_syscall(submit_nr, EPERM);
+  std::vector<TestSession> sessions(8, TestSession(OP_PREAD, fd, buf, 1, 0));
+  for (i = 0; i < 8; i++)
+    assert(service->request(&sessions[i]) == 0);
+
+  wait_handled(n + 8);
+  for (i = 0; i < 8; i++)
+    check_error(&sessions[i], EPERM);
+
+  service->unbind();
+  service->wait_unbound();
+  close(fd);
+}
+
+//*每种情况在子进程里跑,seccomp的过滤不能撤销
+static void run_child(const char *name, bool native_aio, bool fail) {
+  TestService service;
+  int status;
+  pid_t pid;
+
+  fflush(stdout);
+  pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    if (native_aio)
+      block_syscall(__NR_io_uring_setup, ENOSYS);
+
+    assert(service.init(256) == 0);
+    assert(service.bind() == 0);
+    if (fail)
+      test_fail(&service, native_aio ? __NR_io_submit : __NR_io_uring_enter);
+    else {
+      test_rw(&service);
+      test_unbind(&service);
+    }
+
+    service.deinit();
+    exit(0);
+  }
+
+  assert(waitpid(pid, &status, 0) == pid);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  printf("%s ok\n", name);
+}
+
+int main() {
+  run_child("io_uring", false, false);
+  run_child("io_uring submit failure", false, true);
+  run_child("native aio", true, false);
+  run_child("native aio submit failure", true, true);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_json_find.cc
+ * @Description  : 重名成员的查找规则,哈希表阈值两侧结果一致
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/util/json_parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+//*name不以'\0'结尾,验证json_object_find_n()只看前len个字节
+static double find(const json_object_t *obj, const char *name) {
+  std::string buf = std::string(name) + "_tail";
+  const json_value_t *val = json_object_find(name, obj);
+  const json_value_t *val_n = json_object_find_n(buf.c_str(), strlen(name), obj);
+
+  assert(val == val_n);
+  return val ? json_value_number(val) : -1;
+}
+
+static std::string make_text(int members) {
+  std::string text = "{\"dup\": 1";
+  int i;
+
+  for (i = 0; i <= members; i++) {
+    if (i == members / 2)
+      text += ", \"dup\": 2";
+
+    if (i < members)
+      text += ", \"m" + std::to_string(i) + "\": " + std::to_string(i);
+  }
+
+  text += ", \"dup\": 3, \"du\": 4}";
+  return text;
+}
+
+//*解析出的对象:文本里第一个重名成员胜出
+static void test_parsed(int members, json_value_t *(*parse)(const char *)) {
+  std::string text = make_text(members);
+  json_value_t *root = parse(text.c_str());
+  json_object_t *obj = json_value_object(root);
+
+  assert(json_object_size(obj) == members + 4);
+  assert(find(obj, "dup") == 1);
+  assert(find(obj, "du") == 4);
+  assert(find(obj, "d") == -1);
+  assert(find(obj, "dupx") == -1);
+  assert(find(obj, "m0") == (members > 0 ? 0 : -1));
+  json_value_destroy(root);
+}
+
+//*修改过的对象:先加入的重名成员胜出,与在链表里的位置无关,
+//*删除后由下一个先加入的接替.每一步前后都查一次,哈希表已建好时也一样
+static void test_modified(int members) {
+  json_value_t *root = json_value_create(JSON_VALUE_OBJECT);
+  json_object_t *obj = json_value_object(root);
+  const json_value_t *first;
+  const json_value_t *second;
+  const json_value_t *val;
+  int i;
+
+  for (i = 0; i < members; i++)
+    json_object_append(obj, ("m" + std::to_string(i)).c_str(),
+                       JSON_VALUE_NUMBER, (double)i);
+
+  first = json_object_append(obj, "dup", JSON_VALUE_NUMBER, 1.0);
+  assert(find(obj, "dup") == 1);
+
+  val = members > 0 ? json_object_find("m0", obj) : first;
+  second = json_object_insert_before(val, obj, "dup", JSON_VALUE_NUMBER, 2.0);
+  assert(find(obj, "dup") == 1);
+
+  json_object_insert_after(first, obj, "dup", JSON_VALUE_NUMBER, 3.0);
+  assert(find(obj, "dup") == 1);
+
+  json_value_destroy(json_object_remove(first, obj));
+  assert(find(obj, "dup") == 2);
+
+  json_value_destroy(json_object_remove(second, obj));
+  assert(find(obj, "dup") == 3);
+
+  //*复制出的对象按链表顺序加入,链表里第一个胜出
+  val = json_object_next_value(NULL, obj);
+  json_object_insert_before(val, obj, "dup", JSON_VALUE_NUMBER, 4.0);
+  json_value_t *copy = json_value_copy(root);
+  assert(find(json_value_object(copy), "dup") == 4);
+  assert(find(obj, "dup") == 3);
+  json_value_destroy(copy);
+  json_value_destroy(root);
+}
+
+int main() {
+  //*JSON_HASH_THRESHOLD为16,成员数在它两侧
+  static const int sizes[] = {0, 3, 11, 12, 13, 40, 1000};
+
+  for (int members : sizes) {
+    test_parsed(members, json_value_parse);
+    test_parsed(members, json_value_parse_arena);
+
+    test_modified(members);
+  }
+
+  printf("json find ok\n");
+  return 0;
+}
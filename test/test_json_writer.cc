@@ -0,0 +1,80 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_json_writer.cc
+ * @Description  : JsonWriter写出的数字经strtod()读回后与原值逐位相同
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/util/JsonWriter.h"
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static std::string write_number(double num) {
+  std::string out;
+  JsonWriter writer(&out);
+
+  writer.number(num);
+  assert(writer.flush());
+  return out;
+}
+
+//*逐位比较,-0.0与0.0不同
+static void check(double num) {
+  std::string text = write_number(num);
+  char *end;
+  double back = strtod(text.c_str(), &end);
+
+  assert(*end == '\0');
+  if (memcmp(&back, &num, sizeof(double)) != 0) {
+    fprintf(stderr, "%.17g written as %s\n", num, text.c_str());
+    abort();
+  }
+}
+
+int main() {
+  static const double values[] = {
+      0.0,           -0.0,           1.0,         -1.0,
+      0.1,           -0.1,           0.3,         1.0 / 3,
+      123.456,       -123.456,       1e-7,        1e-9,
+      1e-10,         1e15,           1e16,        1e21,
+      1e22,          9007199254740992.0,          9007199254740993.0,
+      DBL_MAX,       -DBL_MAX,       DBL_MIN,     -DBL_MIN,
+      DBL_MIN / 2,   4.9e-324,       -4.9e-324,   DBL_EPSILON,
+      1.7976931348623157e308,        2.2250738585072009e-308,
+      5e-324 * 3,    0.1 + 0.2,      1e300 * 1e-5,
+  };
+  std::mt19937_64 rng(1);
+  uint64_t bits;
+  double num;
+  int i;
+
+  for (double v : values)
+    check(v);
+
+  assert(write_number(-0.0) == "-0");
+  assert(write_number(0.0) == "0");
+  assert(write_number(NAN) == "null");
+  assert(write_number(-INFINITY) == "null");
+
+  //*随机位模式覆盖各个量级,以及短小数的快速路径
+  for (i = 0; i < 200000; i++) {
+    bits = rng();
+    memcpy(&num, &bits, sizeof(double));
+    if (isfinite(num))
+      check(num);
+
+    check((double)(int64_t)(rng() % 2000001 - 1000000) / 1000);
+  }
+
+  printf("json writer ok\n");
+  return 0;
+}
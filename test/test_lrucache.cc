@@ -0,0 +1,250 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_lrucache.cc
+ * @Description  : LRUCache各淘汰/准入策略的正确性测试
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/util/LRUCache.h"
+#include <assert.h>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+static long live_values;
+
+struct ValueDeleter {
+  void operator()(int &value) const { live_values--; }
+};
+
+template <class Cache>
+static auto put(Cache &cache, int key, int value) -> decltype(cache.get(key)) {
+  live_values++;
+  return cache.put(key, value);
+}
+
+template <class Cache> static bool contains(Cache &cache, int key) {
+  auto *handle = cache.get(key);
+
+  if (!handle)
+    return false;
+
+  cache.release(handle);
+  return true;
+}
+
+//*随机操作并与std::map对照:值正确,未被引用的条目数不超过max_size,
+//*被引用的条目不会被淘汰,每个值恰好释放一次
+template <class Cache> static void test_random(const char *name) {
+  typedef decltype(((Cache *)0)->get(0)) HandlePtr;
+  std::mt19937 rng(1);
+  std::map<int, int> model;
+  std::map<int, HandlePtr> pinned;
+  int i;
+
+  {
+    Cache cache;
+
+    cache.set_max_size(64);
+    for (i = 0; i < 200000; i++) {
+      int key = rng() % 256;
+      int op = rng() % 8;
+
+      if (op < 3) {
+        HandlePtr handle = cache.get(key);
+
+        if (handle) {
+          assert(model.count(key) && handle->value == model[key]);
+          if (pinned.size() < 16 && !pinned.count(key))
+            pinned[key] = handle;
+          else
+            cache.release(handle);
+        } else
+          model.erase(key);
+      } else if (op < 6) {
+        HandlePtr handle = put(cache, key, i);
+
+        assert(handle->value == i);
+        if (contains(cache, key))
+          model[key] = i;
+
+        cache.release(handle);
+      } else if (op == 6) {
+        if (pinned.count(key)) {
+          cache.release(pinned[key]);
+          pinned.erase(key);
+        }
+
+        cache.del(key);
+        model.erase(key);
+      } else if (!pinned.empty()) {
+        auto it = pinned.begin();
+
+        cache.release(it->second);
+        pinned.erase(it);
+      }
+
+      for (auto &kv : pinned)
+        assert(contains(cache, kv.first));
+    }
+
+    for (auto &kv : pinned)
+      cache.release(kv.second);
+
+    cache.prune();
+    for (i = 0; i < 256; i++)
+      assert(!contains(cache, i));
+  }
+
+  assert(live_values == 0);
+  printf("%s random ok\n", name);
+}
+
+//*max_size为3,访问1后放入4
+static void test_order() {
+  LRUCache<int, int, ValueDeleter> lru;
+  LRUCache<int, int, ValueDeleter, ClockPolicy<int>> clock;
+  int i;
+
+  lru.set_max_size(3);
+  clock.set_max_size(3);
+  for (i = 1; i <= 3; i++) {
+    lru.release(put(lru, i, i));
+    clock.release(put(clock, i, i));
+  }
+
+  assert(contains(lru, 1));
+  assert(contains(clock, 1));
+  lru.release(put(lru, 4, 4));
+  clock.release(put(clock, 4, 4));
+
+  //*LRU淘汰最久未用的2
+  assert(contains(lru, 1) && !contains(lru, 2) && contains(lru, 3));
+  //*CLOCK给1第二次机会,淘汰2
+  assert(contains(clock, 1) && !contains(clock, 2) && contains(clock, 3));
+  printf("order ok\n");
+}
+
+//*S3-FIFO:被访问过的key不会被一次性扫描冲掉
+static void test_scan() {
+  LRUCache<int, int, ValueDeleter, S3FIFOPolicy<int>> cache;
+  int i;
+
+  cache.set_max_size(100);
+  for (i = 0; i < 50; i++) {
+    cache.release(put(cache, i, i));
+    assert(contains(cache, i));
+  }
+
+  for (i = 1000; i < 11000; i++)
+    cache.release(put(cache, i, i));
+
+  for (i = 0; i < 50; i++)
+    assert(contains(cache, i));
+
+  printf("scan ok\n");
+}
+
+//*被引用的条目不在队列中,全部被引用时victim()返回NULL,缓存暂时超出max_size
+template <class Cache> static void test_pinned(const char *name) {
+  Cache cache;
+  decltype(cache.get(0)) handles[4];
+  int i;
+
+  cache.set_max_size(4);
+  for (i = 0; i < 4; i++)
+    handles[i] = put(cache, i, i);
+
+  cache.release(put(cache, 4, 4));
+  cache.release(put(cache, 5, 5));
+  for (i = 0; i < 4; i++)
+    assert(contains(cache, i));
+
+  for (i = 0; i < 4; i++)
+    cache.release(handles[i]);
+
+  cache.release(put(cache, 6, 6));
+  assert(contains(cache, 6));
+  printf("%s pinned ok\n", name);
+}
+
+//*TinyLFU:从未被get()的新key不能挤掉热门key,被请求过的key可以
+static void test_tinylfu() {
+  LRUCache<int, int, ValueDeleter, LRUPolicy<int>, TinyLFUAdmit<int>> cache;
+  int i, j;
+
+  cache.set_max_size(8);
+  for (i = 0; i < 8; i++) {
+    cache.release(put(cache, i, i));
+    for (j = 0; j < 3; j++)
+      assert(contains(cache, i));
+  }
+
+  cache.release(put(cache, 100, 100));
+  assert(!contains(cache, 100));
+  for (i = 0; i < 8; i++)
+    assert(contains(cache, i));
+
+  //*sketch只有16列,200会与0完全冲突,这里用101
+  for (j = 0; j < 8; j++)
+    assert(!contains(cache, 101));
+
+  cache.release(put(cache, 101, 101));
+  assert(contains(cache, 101));
+  printf("tinylfu ok\n");
+}
+
+//*peek_victim()不移动队列也不修改访问计数
+template <class Policy> static void test_peek(const char *name) {
+  std::vector<CachePolicyNode> nodes(16);
+  std::vector<unsigned char> freq(16);
+  CachePolicyNode *victim;
+  Policy policy;
+  int i;
+
+  policy.init(16);
+  for (i = 0; i < 16; i++) {
+    policy.insert(&nodes[i], i);
+    policy.unpin(&nodes[i]);
+  }
+
+  for (i = 0; i < 16; i += 3)
+    policy.access(&nodes[i]);
+
+  for (i = 0; i < 16; i++)
+    freq[i] = nodes[i].freq;
+
+  victim = policy.peek_victim();
+  assert(victim && policy.peek_victim() == victim);
+  for (i = 0; i < 16; i++)
+    assert(nodes[i].freq == freq[i]);
+
+  assert(policy.victim() == victim);
+  for (i = 0; i < 16; i++)
+    policy.erase(&nodes[i]);
+
+  assert(policy.peek_victim() == NULL && policy.victim() == NULL);
+  printf("%s peek ok\n", name);
+}
+
+int main() {
+  test_random<LRUCache<int, int, ValueDeleter>>("LRU");
+  test_random<LRUCache<int, int, ValueDeleter, ClockPolicy<int>>>("CLOCK");
+  test_random<LRUCache<int, int, ValueDeleter, S3FIFOPolicy<int>>>("S3-FIFO");
+  test_random<LRUCache<int, int, ValueDeleter, S3FIFOPolicy<int>,
+                       TinyLFUAdmit<int>>>("S3-FIFO+TinyLFU");
+  test_order();
+  test_scan();
+  test_pinned<LRUCache<int, int, ValueDeleter>>("LRU");
+  test_pinned<LRUCache<int, int, ValueDeleter, ClockPolicy<int>>>("CLOCK");
+  test_pinned<LRUCache<int, int, ValueDeleter, S3FIFOPolicy<int>>>("S3-FIFO");
+  test_tinylfu();
+  test_peek<LRUPolicy<int>>("LRU");
+  test_peek<ClockPolicy<int>>("CLOCK");
+  test_peek<S3FIFOPolicy<int>>("S3-FIFO");
+  return 0;
+}
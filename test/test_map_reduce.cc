@@ -0,0 +1,79 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_map_reduce.cc
+ * @Description  : map-reduce任务的结果与回调,通过基类指针设置的回调同样生效
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/factory/WFTaskFactory.h"
+#include <assert.h>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+
+#define ITEMS 100000
+
+static std::mutex done_mutex;
+static std::condition_variable done_cond;
+static long done_result;
+static bool done;
+
+static void finish(long result) {
+  std::lock_guard<std::mutex> lock(done_mutex);
+
+  done_result = result;
+  done = true;
+  done_cond.notify_one();
+}
+
+static long wait_finish() {
+  std::unique_lock<std::mutex> lock(done_mutex);
+
+  done_cond.wait(lock, [] { return done; });
+  done = false;
+  return done_result;
+}
+
+static WFMapReduceTask<long> *
+create_task(std::function<void(WFMapReduceTask<long> *)> callback) {
+  return WFMapReduceTaskFactory<long>::create_map_reduce_task(
+      "test_map_reduce", 0, ITEMS, 0L,
+      [](size_t i, long *partial) { *partial += (long)i; },
+      [](long *result, long *partial) { *result += *partial; },
+      std::move(callback));
+}
+
+int main() {
+  static const long sum = (long)ITEMS * (ITEMS - 1) / 2;
+  WFMapReduceTask<long> *task;
+  WFParallelForTask *base;
+
+  //*创建时给的回调
+  create_task([](WFMapReduceTask<long> *task) {
+    assert(task->get_state() == WFT_STATE_SUCCESS);
+    finish(*task->get_result());
+  })->start();
+  assert(wait_finish() == sum);
+
+  //*WFMapReduceTask::set_callback()替换创建时的回调
+  task = create_task([](WFMapReduceTask<long> *) { assert(0); });
+  task->set_callback(
+      [](WFMapReduceTask<long> *task) { finish(*task->get_result() + 1); });
+  task->start();
+  assert(wait_finish() == sum + 1);
+
+  //*通过基类指针设置的回调也生效
+  task = create_task([](WFMapReduceTask<long> *) { assert(0); });
+  base = task;
+  base->set_callback([](WFParallelForTask *task) {
+    finish(*static_cast<WFMapReduceTask<long> *>(task)->get_result() + 2);
+  });
+  task->start();
+  assert(wait_finish() == sum + 2);
+
+  printf("map reduce ok\n");
+  return 0;
+}
@@ -34,6 +34,7 @@ int main() {
   params->max_open_files = 100;
   params->callback = &callback;
   params->context = meg;
+  params->timer_slack = 0;
   mpoller_t *poller = mpoller_create(params, 3);
 
   poller_data *data = new poller_data;
@@ -0,0 +1,119 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_series.cc
+ * @Description  : 多个线程向运行中的series push_back,回调里push_front的压力测试
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/factory/Workflow.h"
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define PRODUCERS 4
+#define TASKS 5000
+#define FRONTS 3
+
+//*日志项:producer的任务记id,push_front的任务记-(id * FRONTS + k + 1)
+static std::mutex log_mutex;
+static std::vector<long> run_log;
+static std::atomic<bool> producers_done;
+static std::atomic<bool> series_done;
+
+static void append_log(long id) {
+  std::lock_guard<std::mutex> lock(log_mutex);
+  run_log.push_back(id);
+}
+
+static WFGoTask *create_front_task(long id, int k) {
+  WFGoTask *task = WFTaskFactory::create_go_task("test_series", [] {});
+
+  task->set_callback(
+      [id, k](WFGoTask *task) { append_log(-(id * FRONTS + k + 1)); });
+  return task;
+}
+
+//*每7个任务在回调里push_front FRONTS个任务,它们应当紧接着倒序执行
+static WFGoTask *create_task(long id) {
+  WFGoTask *task = WFTaskFactory::create_go_task("test_series", [] {});
+
+  task->set_callback([id](WFGoTask *task) {
+    append_log(id);
+    if (id % 7 == 0) {
+      for (int k = 0; k < FRONTS; k++)
+        series_of(task)->push_front(create_front_task(id, k));
+    }
+  });
+  return task;
+}
+
+//*生产者全部结束前,队列里总有一个保活任务,series不会提前结束
+static WFTimerTask *create_keepalive_task() {
+  return WFTaskFactory::create_timer_task(0, 100000, [](WFTimerTask *task) {
+    if (!producers_done)
+      series_of(task)->push_back(create_keepalive_task());
+  });
+}
+
+int main() {
+  std::vector<std::thread> producers;
+  std::vector<int> seen(PRODUCERS * TASKS);
+  std::vector<long> last(PRODUCERS, -1);
+  SeriesWork *series;
+  size_t fronts = 0;
+  size_t i;
+  long id;
+  int k;
+
+  series = Workflow::create_series_work(
+      create_keepalive_task(), [](const SeriesWork *) { series_done = true; });
+  series->start();
+
+  for (int p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([p, series] {
+      for (long i = 0; i < TASKS; i++) {
+        series->push_back(create_task(p * TASKS + i));
+        if (i % 64 == 0)
+          usleep(50);
+      }
+    });
+  }
+
+  for (auto &t : producers)
+    t.join();
+
+  producers_done = true;
+  while (!series_done)
+    usleep(1000);
+
+  //*producer的任务各执行一次,按各自push_back的顺序;push_front的任务紧跟
+  //*在推它的任务后面,后推的先执行
+  for (i = 0; i < run_log.size(); i++) {
+    id = run_log[i];
+    assert(id >= 0 && id < PRODUCERS * TASKS);
+    assert(seen[id]++ == 0);
+    assert(id > last[id / TASKS]);
+    last[id / TASKS] = id;
+    if (id % 7 == 0) {
+      for (k = FRONTS - 1; k >= 0; k--) {
+        assert(++i < run_log.size());
+        assert(run_log[i] == -(id * FRONTS + k + 1));
+        fronts++;
+      }
+    }
+  }
+
+  for (id = 0; id < PRODUCERS * TASKS; id++)
+    assert(seen[id] == 1);
+
+  printf("series ok: %zu tasks, %zu pushed to front\n", run_log.size(), fronts);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * @Author       : gyy0727 3155833132@qq.com
+ * @Date         : 2026-10-19 10:00:00
+ * @LastEditors  : gyy0727 3155833132@qq.com
+ * @LastEditTime : 2026-10-19 10:00:00
+ * @FilePath     : /myworkflow/test/test_timer.cc
+ * @Description  : 定时器任务与cancel_by_name()的测试
+ * Copyright (c) 2026 by gyy0727 email: 3155833132@qq.com, All Rights Reserved.
+ */
+
+#include "../src/factory/WFTaskFactory.h"
+#include "../src/manager/WFGlobal.h"
+#include <assert.h>
+#include <atomic>
+#include <errno.h>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+
+static std::atomic<int> fired;
+static std::atomic<int> canceled;
+static std::atomic<int> other;
+static std::atomic<int> finished;
+
+static void timer_callback(WFTimerTask *task) {
+  if (task->get_state() == WFT_STATE_SUCCESS)
+    fired++;
+  else if (task->get_state() == WFT_STATE_SYS_ERROR &&
+           task->get_error() == ECANCELED)
+    canceled++;
+  else
+    other++;
+
+  finished++;
+}
+
+static void wait_finished(int n) {
+  while (finished < n)
+    usleep(1000);
+}
+
+static void reset() {
+  fired = 0;
+  canceled = 0;
+  other = 0;
+  finished = 0;
+}
+
+//*长定时器全部被取消,短定时器全部到期,max只取消前max个
+static void test_cancel() {
+  size_t n;
+  int i;
+
+  reset();
+  for (i = 0; i < 1000; i++)
+    WFTaskFactory::create_timer_task("long", 5, 0, timer_callback)->start();
+
+  for (i = 0; i < 1000; i++)
+    WFTaskFactory::create_timer_task("short", 0, 10000000, timer_callback)
+        ->start();
+
+  n = WFTaskFactory::cancel_by_name("long", 10);
+  assert(n == 10);
+  n = WFTaskFactory::cancel_by_name("long");
+  assert(n == 990);
+  assert(WFTaskFactory::cancel_by_name("long") == 0);
+  assert(WFTaskFactory::cancel_by_name("nothing") == 0);
+
+  wait_finished(2000);
+  assert(fired == 1000);
+  assert(canceled == 1000);
+  assert(other == 0);
+  printf("cancel ok\n");
+}
+
+//*定时器在0~50us后到期,另一个线程同时按名字取消:每个定时器恰好回调一次,
+//*取消成功的个数等于ECANCELED回调的个数
+static void test_race() {
+  const int rounds = 200;
+  const int timers = 100;
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> total(0);
+  int i, j;
+
+  reset();
+  std::thread canceler([&stop, &total] {
+    while (!stop)
+      total += WFTaskFactory::cancel_by_name("race");
+  });
+
+  for (i = 0; i < rounds; i++) {
+    for (j = 0; j < timers; j++)
+      WFTaskFactory::create_timer_task("race", 0, j * 500, timer_callback)
+          ->start();
+
+    total += WFTaskFactory::cancel_by_name("race", j / 2);
+  }
+
+  wait_finished(rounds * timers);
+  stop = true;
+  canceler.join();
+  assert(other == 0);
+  assert(fired + canceled == rounds * timers);
+  assert((size_t)canceled == total);
+  printf("race ok: %d fired, %d canceled\n", (int)fired, (int)canceled);
+}
+
+int main() {
+  test_cancel();
+  test_race();
+  return 0;
+}